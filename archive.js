@@ -0,0 +1,370 @@
+'use strict';
+
+// ZIP/APK/IPA 感知的 diff:把 deflate 条目展开成原始数据后再交给 diff(),
+// patch 时用记录的 zlib 参数重新压缩回逐字节相同的归档。
+//
+// 展开规则:
+// - old:所有能完整解压的 deflate 条目都替换为解压数据(解压是确定的,
+//   patch 端对同一个 old 得到同一展开结果,无需记录)。
+// - new:只展开“用 zlib 某组参数重新压缩后与原数据逐字节相同”的条目,
+//   其余字节(文件头、中央目录、stored 条目、无法复现的压缩数据)原样保留。
+// 产物头部记录 new 中每个展开段的位置与压缩参数及整个 new 的 sha256;
+// patch 端重新压缩后逐段核对长度并校验摘要,zlib 实现不同导致的偏差会报错而不是
+// 产出错误的归档。非 ZIP 输入(或 zip64、加密条目)按普通字节处理。
+
+const crypto = require('crypto');
+const { promisify } = require('util');
+const zlib = require('zlib');
+
+const inflateRawAsync = promisify(zlib.inflateRaw);
+const deflateRawAsync = promisify(zlib.deflateRaw);
+
+const kMagic = Buffer.from('HDPZIP1\0', 'latin1');
+const kHeaderSize = kMagic.length + 4 + 8 + 32;
+const kSegmentSize = 8 * 3 + 4;
+const kEocdSignature = 0x06054b50;
+const kCentralSignature = 0x02014b50;
+const kLocalSignature = 0x04034b50;
+const kMethodDeflate = 8;
+// 常见打包工具(zip、Java Deflater、apksigner 等)都用 zlib 默认 memLevel 与
+// 策略;级别按常见程度排序,命中即停
+const kCandidateLevels = [6, 9, 1, 5, 4, 3, 2, 7, 8];
+const kMemLevel = 8;
+// 回调形式同时提交给 libuv 线程池的 zlib 任务数(与默认池大小一致)
+const kZlibConcurrency = 4;
+
+function sha256(data) {
+  return crypto.createHash('sha256').update(data).digest();
+}
+
+// 由中央目录列出 deflate 条目的压缩数据区间;不是 ZIP 或结构异常时返回 []
+function listDeflateEntries(buf) {
+  const minEocd = 22;
+  if (buf.length < minEocd) return [];
+  let eocd = -1;
+  const scanStart = Math.max(0, buf.length - minEocd - 0xffff);
+  for (let pos = buf.length - minEocd; pos >= scanStart; pos--) {
+    if (buf.readUInt32LE(pos) === kEocdSignature) {
+      eocd = pos;
+      break;
+    }
+  }
+  if (eocd < 0) return [];
+  const count = buf.readUInt16LE(eocd + 10);
+  const cdSize = buf.readUInt32LE(eocd + 12);
+  const cdOffset = buf.readUInt32LE(eocd + 16);
+  // zip64 的 0xffffffff 占位与越界的目录都按非归档处理
+  if (cdOffset + cdSize > eocd) return [];
+
+  const entries = [];
+  let pos = cdOffset;
+  for (let i = 0; i < count; i++) {
+    if (pos + 46 > eocd || buf.readUInt32LE(pos) !== kCentralSignature) return [];
+    const flags = buf.readUInt16LE(pos + 8);
+    const method = buf.readUInt16LE(pos + 10);
+    const compSize = buf.readUInt32LE(pos + 20);
+    const uncompSize = buf.readUInt32LE(pos + 24);
+    const nameLen = buf.readUInt16LE(pos + 28);
+    const extraLen = buf.readUInt16LE(pos + 30);
+    const commentLen = buf.readUInt16LE(pos + 32);
+    const localOffset = buf.readUInt32LE(pos + 42);
+    pos += 46 + nameLen + extraLen + commentLen;
+    if (method !== kMethodDeflate || (flags & 1) !== 0) continue;
+    if (localOffset + 30 > buf.length || buf.readUInt32LE(localOffset) !== kLocalSignature) {
+      continue;
+    }
+    const start = localOffset + 30 + buf.readUInt16LE(localOffset + 26) +
+      buf.readUInt16LE(localOffset + 28);
+    if (start + compSize > cdOffset) continue;
+    entries.push({ start, end: start + compSize, uncompSize });
+  }
+  entries.sort((a, b) => a.start - b.start);
+  // 丢弃互相重叠的条目(畸形或刻意构造的归档)
+  return entries.filter((e, i) => i === 0 || e.start >= entries[i - 1].end);
+}
+
+// sync 为 true 时在调用线程上执行,否则走 zlib 的线程池版本并返回 Promise
+function inflateEntry(buf, entry, sync) {
+  const compressed = buf.subarray(entry.start, entry.end);
+  const checked = (data) => (data.length === entry.uncompSize ? data : null);
+  if (sync) {
+    try {
+      return checked(zlib.inflateRawSync(compressed));
+    } catch (err) {
+      return null;
+    }
+  }
+  return inflateRawAsync(compressed).then(checked, () => null);
+}
+
+function deflateEntry(data, level, memLevel, sync) {
+  const options = { level, memLevel, windowBits: 15 };
+  return sync ? zlib.deflateRawSync(data, options) : deflateRawAsync(data, options);
+}
+
+// 找到能逐字节复现原压缩数据的级别;找不到返回 -1
+function findLevelSync(compressed, data) {
+  for (const level of kCandidateLevels) {
+    const redeflated = deflateEntry(data, level, kMemLevel, true);
+    if (redeflated.length === compressed.length && redeflated.equals(compressed)) return level;
+  }
+  return -1;
+}
+
+async function findLevelAsync(compressed, data) {
+  for (const level of kCandidateLevels) {
+    const redeflated = await deflateEntry(data, level, kMemLevel, false);
+    if (redeflated.length === compressed.length && redeflated.equals(compressed)) return level;
+  }
+  return -1;
+}
+
+// 按顺序对 items 调用 fn,同时最多 kZlibConcurrency 个在线程池中
+async function mapLimit(items, fn) {
+  const results = new Array(items.length);
+  let next = 0;
+  async function worker() {
+    while (next < items.length) {
+      const i = next++;
+      results[i] = await fn(items[i]);
+    }
+  }
+  const workers = [];
+  for (let i = 0; i < Math.min(kZlibConcurrency, items.length); i++) workers.push(worker());
+  await Promise.all(workers);
+  return results;
+}
+
+// 把 buf 中的条目替换为展开数据;expansions[i] 为 null 的条目保留原字节
+function splice(buf, entries, expansions) {
+  const parts = [];
+  const segments = [];
+  let pos = 0;
+  entries.forEach((entry, i) => {
+    const expansion = expansions[i];
+    if (!expansion) return;
+    segments.push({
+      rawLen: entry.start - pos,
+      uncompLen: expansion.data.length,
+      compLen: entry.end - entry.start,
+      level: expansion.level,
+    });
+    parts.push(buf.subarray(pos, entry.start), expansion.data);
+    pos = entry.end;
+  });
+  parts.push(buf.subarray(pos));
+  return { expanded: segments.length ? Buffer.concat(parts) : buf, segments };
+}
+
+function expandOld(oldBuf) {
+  const entries = listDeflateEntries(oldBuf);
+  const expansions = entries.map((entry) => {
+    const data = inflateEntry(oldBuf, entry, true);
+    return data && { data };
+  });
+  return splice(oldBuf, entries, expansions).expanded;
+}
+
+async function expandOldAsync(oldBuf) {
+  const entries = listDeflateEntries(oldBuf);
+  const expansions = await mapLimit(entries, async (entry) => {
+    const data = await inflateEntry(oldBuf, entry, false);
+    return data && { data };
+  });
+  return splice(oldBuf, entries, expansions).expanded;
+}
+
+function expandNew(newBuf) {
+  const entries = listDeflateEntries(newBuf);
+  const expansions = entries.map((entry) => {
+    const data = inflateEntry(newBuf, entry, true);
+    if (!data) return null;
+    const level = findLevelSync(newBuf.subarray(entry.start, entry.end), data);
+    return level < 0 ? null : { data, level };
+  });
+  return splice(newBuf, entries, expansions);
+}
+
+async function expandNewAsync(newBuf) {
+  const entries = listDeflateEntries(newBuf);
+  const expansions = await mapLimit(entries, async (entry) => {
+    const data = await inflateEntry(newBuf, entry, false);
+    if (!data) return null;
+    const level = await findLevelAsync(newBuf.subarray(entry.start, entry.end), data);
+    return level < 0 ? null : { data, level };
+  });
+  return splice(newBuf, entries, expansions);
+}
+
+function encodeHeader(newBuf, segments) {
+  const header = Buffer.alloc(kHeaderSize + segments.length * kSegmentSize);
+  kMagic.copy(header, 0);
+  let pos = kMagic.length;
+  header.writeUInt32LE(segments.length, pos);
+  header.writeBigUInt64LE(BigInt(newBuf.length), pos + 4);
+  sha256(newBuf).copy(header, pos + 12);
+  pos = kHeaderSize;
+  for (const seg of segments) {
+    header.writeBigUInt64LE(BigInt(seg.rawLen), pos);
+    header.writeBigUInt64LE(BigInt(seg.uncompLen), pos + 8);
+    header.writeBigUInt64LE(BigInt(seg.compLen), pos + 16);
+    header.writeUInt8(seg.level, pos + 24);
+    header.writeUInt8(kMemLevel, pos + 25);
+    pos += kSegmentSize;
+  }
+  return header;
+}
+
+function decodeHeader(diffBuf) {
+  if (diffBuf.length < kHeaderSize ||
+      !diffBuf.subarray(0, kMagic.length).equals(kMagic)) {
+    throw new Error('Invalid archive diff: bad magic.');
+  }
+  let pos = kMagic.length;
+  const count = diffBuf.readUInt32LE(pos);
+  const newSize = Number(diffBuf.readBigUInt64LE(pos + 4));
+  const digest = diffBuf.subarray(pos + 12, pos + 44);
+  if (diffBuf.length < kHeaderSize + count * kSegmentSize) {
+    throw new Error('Invalid archive diff: truncated header.');
+  }
+  const segments = [];
+  pos = kHeaderSize;
+  for (let i = 0; i < count; i++) {
+    segments.push({
+      rawLen: Number(diffBuf.readBigUInt64LE(pos)),
+      uncompLen: Number(diffBuf.readBigUInt64LE(pos + 8)),
+      compLen: Number(diffBuf.readBigUInt64LE(pos + 16)),
+      level: diffBuf.readUInt8(pos + 24),
+      memLevel: diffBuf.readUInt8(pos + 25),
+    });
+    pos += kSegmentSize;
+  }
+  return { segments, newSize, digest, inner: diffBuf.subarray(pos) };
+}
+
+// 把展开数据切成 [原样字节, 待重新压缩的数据] 段;越界时报错
+function locateSegments(expanded, header) {
+  const located = [];
+  let pos = 0;
+  for (const seg of header.segments) {
+    if (pos + seg.rawLen + seg.uncompLen > expanded.length) {
+      throw new Error('Invalid archive diff: segment out of range.');
+    }
+    const dataStart = pos + seg.rawLen;
+    located.push({
+      seg,
+      raw: expanded.subarray(pos, dataStart),
+      data: expanded.subarray(dataStart, dataStart + seg.uncompLen),
+    });
+    pos = dataStart + seg.uncompLen;
+  }
+  return { located, tail: expanded.subarray(pos) };
+}
+
+// compressed[i] 为第 i 段重新压缩的结果
+function assembleNew(header, { located, tail }, compressed) {
+  const parts = [];
+  located.forEach(({ seg, raw }, i) => {
+    if (compressed[i].length !== seg.compLen) {
+      throw new Error('Archive entry re-deflate mismatch: this zlib differs from the one used by diffArchive().');
+    }
+    parts.push(raw, compressed[i]);
+  });
+  parts.push(tail);
+  const newBuf = Buffer.concat(parts);
+  if (newBuf.length !== header.newSize || !sha256(newBuf).equals(header.digest)) {
+    throw new Error('Archive re-deflate mismatch: rebuilt archive digest differs.');
+  }
+  return newBuf;
+}
+
+function rebuildNew(expanded, header) {
+  const layout = locateSegments(expanded, header);
+  const compressed = layout.located.map(({ seg, data }) =>
+    deflateEntry(data, seg.level, seg.memLevel, true)
+  );
+  return assembleNew(header, layout, compressed);
+}
+
+async function rebuildNewAsync(expanded, header) {
+  const layout = locateSegments(expanded, header);
+  const compressed = await mapLimit(layout.located, ({ seg, data }) =>
+    deflateEntry(data, seg.level, seg.memLevel, false)
+  );
+  return assembleNew(header, layout, compressed);
+}
+
+function toBuffer(data, name) {
+  if (Buffer.isBuffer(data)) return data;
+  if (ArrayBuffer.isView(data)) return Buffer.from(data.buffer, data.byteOffset, data.byteLength);
+  if (data instanceof ArrayBuffer ||
+      (typeof SharedArrayBuffer === 'function' && data instanceof SharedArrayBuffer)) {
+    return Buffer.from(data);
+  }
+  throw new TypeError(`Invalid ${name}: expected Buffer, TypedArray or (Shared)ArrayBuffer.`);
+}
+
+// native 为原生模块(需要 diff/patch);options 透传给 diff(),checksum 总是开启,
+// 使 patch 端先校验展开后的 old
+module.exports = function createArchive(native) {
+  // 回调形式:展开/重新压缩走 zlib 的异步接口,在 libuv 线程池中执行;
+  // cb 经 nextTick 调用,不落在 Promise 链里
+  function settle(promise, cb) {
+    promise.then(
+      (value) => process.nextTick(cb, null, value),
+      (err) => process.nextTick(cb, err)
+    );
+  }
+
+  function diffArchive(oldData, newData, options, cb) {
+    if (typeof options === 'function') {
+      cb = options;
+      options = undefined;
+    }
+    const oldBuf = toBuffer(oldData, 'old');
+    const newBuf = toBuffer(newData, 'new');
+    if (options && options.out !== undefined) {
+      throw new TypeError('diffArchive does not support out: the patch is prefixed with an archive header.');
+    }
+    const diffOptions = Object.assign({}, options, { checksum: true });
+    if (typeof cb === 'function') {
+      settle(
+        Promise.all([expandOldAsync(oldBuf), expandNewAsync(newBuf)]).then(
+          ([oldExpanded, expandedNew]) => new Promise((resolve, reject) => {
+            const header = encodeHeader(newBuf, expandedNew.segments);
+            native.diff(oldExpanded, expandedNew.expanded, diffOptions, (err, inner) =>
+              err ? reject(err) : resolve(Buffer.concat([header, inner]))
+            );
+          })
+        ),
+        cb
+      );
+      return undefined;
+    }
+    const oldExpanded = expandOld(oldBuf);
+    const expandedNew = expandNew(newBuf);
+    const header = encodeHeader(newBuf, expandedNew.segments);
+    return Buffer.concat([header, native.diff(oldExpanded, expandedNew.expanded, diffOptions)]);
+  }
+
+  function patchArchive(oldData, diffData, cb) {
+    if (typeof cb === 'function') {
+      settle(
+        Promise.resolve().then(async () => {
+          const header = decodeHeader(toBuffer(diffData, 'diff'));
+          const oldExpanded = await expandOldAsync(toBuffer(oldData, 'old'));
+          const expanded = await new Promise((resolve, reject) => {
+            native.patch(oldExpanded, header.inner, (err, out) => (err ? reject(err) : resolve(out)));
+          });
+          return rebuildNewAsync(expanded, header);
+        }),
+        cb
+      );
+      return undefined;
+    }
+    const header = decodeHeader(toBuffer(diffData, 'diff'));
+    return rebuildNew(native.patch(expandOld(toBuffer(oldData, 'old')), header.inner), header);
+  }
+
+  return { diffArchive, patchArchive };
+};
@@ -0,0 +1,392 @@
+'use strict';
+
+// hdp batch / hdp bench 的实现。
+//
+// batch:按清单并发执行多个 diff/patch 任务。任务按清单顺序启动,同时运行的
+// 任务数不超过 threads,已启动任务的内存估算之和不超过 maxMemory(单个任务
+// 超出预算时等到没有其它任务运行再单独执行,不会卡死)。任务之间没有依赖,
+// 需要先 diff 再 patch 同一产物时请分成两个清单。
+//
+// bench:在临时目录生成几类确定性语料,按各 diff 模式测量耗时与产物大小。
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const kModes = ['single', 'window', 'stream', 'auto'];
+// 与 src/hdiff.cpp 中 *_memory_estimate 的估算方式一致
+const kSuffixIndex32Limit = 2 ** 31;
+const kDefaultWindowSize = 2 * 1024 * 1024;
+const kMatchBlockSize = 64;
+
+function indexBytesPerByte(size) {
+  return size < kSuffixIndex32Limit ? 4 : 8;
+}
+
+// diff() 拒绝低于最小窗口索引的 maxIndexMemory;份额更小时用最小窗口,
+// 估算也按它计,由调度器把任务排到预算之内
+function autoIndexBudget(share) {
+  return Math.max(share, kDefaultWindowSize * indexBytesPerByte(kDefaultWindowSize));
+}
+
+function diffMemoryEstimate(mode, oldSize, newSize, job, share) {
+  switch (mode) {
+    case 'single':
+      return oldSize * indexBytesPerByte(oldSize) + newSize;
+    case 'window': {
+      const windowSize = job.windowSize || kDefaultWindowSize;
+      return windowSize * (1 + indexBytesPerByte(windowSize)) + newSize;
+    }
+    case 'stream':
+      return (Math.floor(oldSize / kMatchBlockSize) + 1) * 16 + newSize;
+    default: {
+      // auto:索引放不下每任务份额时原生侧改走 window,估算取两者中较小的一档
+      const full = oldSize * indexBytesPerByte(oldSize) + newSize;
+      return share > 0 ? Math.min(full, autoIndexBudget(share) + newSize) : full;
+    }
+  }
+}
+
+function parseBytes(value, name) {
+  if (typeof value === 'number' && Number.isSafeInteger(value) && value >= 0) return value;
+  const match = /^(\d+)\s*([kmg]?)i?b?$/i.exec(String(value).trim());
+  if (!match) throw new Error(`Invalid ${name}: expected bytes or a size such as 512m.`);
+  const scale = { '': 1, k: 1024, m: 1024 ** 2, g: 1024 ** 3 }[match[2].toLowerCase()];
+  return Number(match[1]) * scale;
+}
+
+function parsePositiveInt(value, name) {
+  const n = Number(value);
+  if (!Number.isInteger(n) || n < 1) throw new Error(`Invalid ${name}: expected an integer >= 1.`);
+  return n;
+}
+
+function loadManifest(manifestPath) {
+  const raw = JSON.parse(fs.readFileSync(manifestPath, 'utf8'));
+  const manifest = Array.isArray(raw) ? { jobs: raw } : raw;
+  if (!manifest || !Array.isArray(manifest.jobs)) {
+    throw new Error('Invalid manifest: expected { jobs: [...] } or an array of jobs.');
+  }
+  // 相对路径以清单所在目录为基准
+  const baseDir = path.dirname(path.resolve(manifestPath));
+  const resolve = (p, label) => {
+    if (typeof p !== 'string' || p === '') throw new Error(`Invalid ${label}: expected a path.`);
+    return path.resolve(baseDir, p);
+  };
+  const defaultMode = manifest.mode || 'auto';
+  if (!kModes.includes(defaultMode)) {
+    throw new Error(`Invalid mode: expected one of ${kModes.join(', ')}.`);
+  }
+  const jobs = manifest.jobs.map((job, i) => {
+    const label = `job #${i}`;
+    if (!job || typeof job !== 'object') throw new Error(`Invalid ${label}: expected an object.`);
+    const type = job.type || 'diff';
+    if (type === 'diff') {
+      const mode = job.mode || defaultMode;
+      if (!kModes.includes(mode)) {
+        throw new Error(`Invalid ${label}.mode: expected one of ${kModes.join(', ')}.`);
+      }
+      return {
+        index: i,
+        name: job.name || `${label}`,
+        type,
+        mode,
+        old: resolve(job.old, `${label}.old`),
+        new: resolve(job.new, `${label}.new`),
+        out: resolve(job.out, `${label}.out`),
+        checksum: job.checksum === true,
+        windowSize: job.windowSize,
+      };
+    }
+    if (type === 'patch') {
+      return {
+        index: i,
+        name: job.name || `${label}`,
+        type,
+        old: resolve(job.old, `${label}.old`),
+        diff: resolve(job.diff, `${label}.diff`),
+        out: resolve(job.out, `${label}.out`),
+      };
+    }
+    throw new Error(`Invalid ${label}.type: expected 'diff' or 'patch'.`);
+  });
+  return {
+    jobs,
+    threads: manifest.threads,
+    maxMemory: manifest.maxMemory,
+  };
+}
+
+function createRunner(hdiffpatch, detectDiffFormat) {
+  function estimate(job, share) {
+    if (job.type === 'patch') {
+      try {
+        return hdiffpatch.getDiffInfo(job.diff).streamPatchMemory;
+      } catch (err) {
+        return 0;  // 头部无法解析,错误留给 patch 本身报告
+      }
+    }
+    let oldSize = 0;
+    let newSize = 0;
+    try {
+      oldSize = fs.statSync(job.old).size;
+      newSize = fs.statSync(job.new).size;
+    } catch (err) {
+      return 0;
+    }
+    return diffMemoryEstimate(job.mode, oldSize, newSize, job, share);
+  }
+
+  function start(job, share, done) {
+    if (job.type === 'patch') {
+      const format = detectDiffFormat(job.diff);
+      if (format === 'single') {
+        hdiffpatch.patchSingleStream(job.old, job.diff, job.out, done);
+      } else if (format === 'stream') {
+        hdiffpatch.patchStream(job.old, job.diff, job.out, done);
+      } else {
+        done(new Error(`${job.diff} is not a recognized hdiffpatch diff file.`));
+      }
+      return;
+    }
+    const options = { checksum: job.checksum };
+    switch (job.mode) {
+      case 'single':
+        hdiffpatch.diffFile(job.old, job.new, job.out, options, done);
+        break;
+      case 'window':
+        if (job.windowSize !== undefined) options.windowSize = job.windowSize;
+        hdiffpatch.diffWindow(job.old, job.new, job.out, options, done);
+        break;
+      case 'stream':
+        hdiffpatch.diffStream(job.old, job.new, job.out, options, done);
+        break;
+      default:
+        if (share > 0) options.maxIndexMemory = autoIndexBudget(share);
+        hdiffpatch.diffFile(job.old, job.new, job.out, options, done);
+        break;
+    }
+  }
+
+  // 结果按清单顺序返回;onResult 在每个任务结束时调用
+  function runJobs(jobs, { threads, maxMemory }, onResult) {
+    const share = maxMemory > 0 ? Math.floor(maxMemory / threads) : 0;
+    const results = new Array(jobs.length);
+    const queue = jobs.map((job) => ({ job, memory: estimate(job, share) }));
+    let running = 0;
+    let usedMemory = 0;
+    let finished = 0;
+    return new Promise((resolve) => {
+      if (jobs.length === 0) {
+        resolve(results);
+        return;
+      }
+      const pump = () => {
+        while (queue.length > 0 && running < threads) {
+          const { job, memory } = queue[0];
+          const fits = maxMemory <= 0 || usedMemory + memory <= maxMemory;
+          if (!fits && running > 0) break;
+          queue.shift();
+          running++;
+          usedMemory += memory;
+          const startedAt = process.hrtime.bigint();
+          let settled = false;
+          const done = (err) => {
+            if (settled) return;
+            settled = true;
+            const ms = Number(process.hrtime.bigint() - startedAt) / 1e6;
+            const result = { index: job.index, name: job.name, type: job.type, ms, memory };
+            if (job.mode) result.mode = job.mode;
+            result.out = job.out;
+            if (err) {
+              result.status = 'error';
+              result.error = err && err.message ? err.message : String(err);
+            } else {
+              result.status = 'ok';
+              try {
+                result.size = fs.statSync(job.out).size;
+              } catch (statErr) {
+                result.size = 0;
+              }
+            }
+            results[job.index] = result;
+            running--;
+            usedMemory -= memory;
+            finished++;
+            onResult(result);
+            if (finished === jobs.length) resolve(results);
+            else pump();
+          };
+          try {
+            start(job, share, done);
+          } catch (err) {
+            done(err);
+          }
+        }
+      };
+      pump();
+    });
+  }
+
+  return { runJobs };
+}
+
+function formatResult(result) {
+  const what = result.type === 'diff' ? `diff/${result.mode}` : 'patch';
+  const tail = result.status === 'ok' ? `${result.size} bytes` : `error: ${result.error}`;
+  return `${result.status === 'ok' ? 'ok  ' : 'FAIL'} ${what.padEnd(12)} ` +
+    `${result.ms.toFixed(1).padStart(10)} ms  ${result.name}  ${tail}`;
+}
+
+// argv: [manifest, ...flags];返回进程退出码
+async function runBatch(hdiffpatch, detectDiffFormat, argv) {
+  let manifestPath = null;
+  let threadsArg;
+  let memoryArg;
+  let json = false;
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    if (arg === '--threads') threadsArg = argv[++i];
+    else if (arg === '--max-memory') memoryArg = argv[++i];
+    else if (arg === '--json') json = true;
+    else if (manifestPath === null) manifestPath = arg;
+    else throw new Error(`unexpected argument: ${arg}`);
+  }
+  if (manifestPath === null) throw new Error('batch expects a manifest file.');
+
+  const manifest = loadManifest(manifestPath);
+  const threadsValue = threadsArg !== undefined ? threadsArg : manifest.threads;
+  const threads = threadsValue !== undefined
+    ? parsePositiveInt(threadsValue, 'threads')
+    : Math.max(1, os.cpus().length);
+  const memoryValue = memoryArg !== undefined ? memoryArg : manifest.maxMemory;
+  const maxMemory = memoryValue !== undefined ? parseBytes(memoryValue, 'maxMemory') : 0;
+
+  // 异步任务跑在 libuv 线程池上(默认 4 线程);须在首个异步调用前调大
+  if (!process.env.UV_THREADPOOL_SIZE || Number(process.env.UV_THREADPOOL_SIZE) < threads) {
+    process.env.UV_THREADPOOL_SIZE = String(Math.min(threads, 1024));
+  }
+
+  const { runJobs } = createRunner(hdiffpatch, detectDiffFormat);
+  const startedAt = process.hrtime.bigint();
+  const results = await runJobs(manifest.jobs, { threads, maxMemory }, (result) => {
+    if (!json) console.log(formatResult(result));
+  });
+  const totalMs = Number(process.hrtime.bigint() - startedAt) / 1e6;
+  const failed = results.filter((r) => r.status !== 'ok').length;
+  if (json) {
+    console.log(JSON.stringify({ threads, maxMemory, totalMs, failed, jobs: results }, null, 2));
+  } else {
+    console.log(`${results.length} jobs, ${failed} failed, ${totalMs.toFixed(1)} ms total ` +
+      `(threads ${threads}${maxMemory > 0 ? `, maxMemory ${maxMemory}` : ''})`);
+  }
+  return failed === 0 ? 0 : 1;
+}
+
+function deterministicBytes(size, seed) {
+  const out = Buffer.allocUnsafe(size);
+  let x = seed >>> 0;
+  for (let i = 0; i < size; i++) {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    out[i] = x & 0xff;
+  }
+  return out;
+}
+
+// 内置语料:随机数据上的零散改动、文本状数据中的插入、尾部追加
+function benchCorpora(size) {
+  const scattered = () => {
+    const oldData = deterministicBytes(size, 0x2468ace0);
+    const newData = Buffer.from(oldData);
+    const noise = deterministicBytes(64 * 1024, 0x1357);
+    for (let pos = 4096, i = 0; pos + 64 < size; pos += 256 * 1024, i++) {
+      noise.copy(newData, pos, (i * 64) % (noise.length - 64), (i * 64) % (noise.length - 64) + 64);
+    }
+    return { oldData, newData };
+  };
+  const text = () => {
+    const oldData = deterministicBytes(size, 0x0badf00d);
+    for (let i = 0; i < size; i++) oldData[i] = 0x61 + (oldData[i] % 16);
+    const insert = Buffer.from('inserted line\n'.repeat(64));
+    const parts = [];
+    for (let pos = 0; pos < size; pos += 1024 * 1024) {
+      parts.push(oldData.subarray(pos, Math.min(pos + 1024 * 1024, size)), insert);
+    }
+    return { oldData, newData: Buffer.concat(parts) };
+  };
+  const appended = () => {
+    const oldData = deterministicBytes(size, 0x9e3779b9);
+    return { oldData, newData: Buffer.concat([oldData, deterministicBytes(size >> 3, 0x51ed)]) };
+  };
+  return { scattered, text, appended };
+}
+
+// argv: [--size MiB] [--modes a,b] [--json];返回进程退出码
+function runBench(hdiffpatch, argv) {
+  let sizeMiB = 16;
+  let modes = ['single', 'window', 'stream'];
+  let json = false;
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    if (arg === '--size') sizeMiB = parsePositiveInt(argv[++i], 'size');
+    else if (arg === '--modes') modes = String(argv[++i]).split(',');
+    else if (arg === '--json') json = true;
+    else throw new Error(`unexpected argument: ${arg}`);
+  }
+  for (const mode of modes) {
+    if (!kModes.includes(mode) || mode === 'auto') {
+      throw new Error('Invalid modes: expected a comma-separated list of single, window, stream.');
+    }
+  }
+
+  const size = sizeMiB * 1024 * 1024;
+  const tempRoot = fs.mkdtempSync(path.join(os.tmpdir(), 'hdp-bench-'));
+  const rows = [];
+  try {
+    const oldPath = path.join(tempRoot, 'old.bin');
+    const newPath = path.join(tempRoot, 'new.bin');
+    const diffPath = path.join(tempRoot, 'out.diff');
+    const outPath = path.join(tempRoot, 'out.bin');
+    for (const [corpus, make] of Object.entries(benchCorpora(size))) {
+      const { oldData, newData } = make();
+      fs.writeFileSync(oldPath, oldData);
+      fs.writeFileSync(newPath, newData);
+      for (const mode of modes) {
+        const diffStart = process.hrtime.bigint();
+        if (mode === 'single') hdiffpatch.diffFile(oldPath, newPath, diffPath);
+        else if (mode === 'window') hdiffpatch.diffWindow(oldPath, newPath, diffPath);
+        else hdiffpatch.diffStream(oldPath, newPath, diffPath);
+        const diffMs = Number(process.hrtime.bigint() - diffStart) / 1e6;
+        const patchStart = process.hrtime.bigint();
+        if (mode === 'stream') hdiffpatch.patchStream(oldPath, diffPath, outPath);
+        else hdiffpatch.patchSingleStream(oldPath, diffPath, outPath);
+        const patchMs = Number(process.hrtime.bigint() - patchStart) / 1e6;
+        if (!fs.readFileSync(outPath).equals(newData)) {
+          throw new Error(`${corpus}/${mode}: patch output mismatch`);
+        }
+        const row = {
+          corpus,
+          mode,
+          newBytes: newData.length,
+          diffBytes: fs.statSync(diffPath).size,
+          diffMs,
+          patchMs,
+        };
+        rows.push(row);
+        if (!json) {
+          console.log(`${corpus.padEnd(10)} ${mode.padEnd(7)} ` +
+            `diff ${diffMs.toFixed(1).padStart(9)} ms  patch ${patchMs.toFixed(1).padStart(8)} ms  ` +
+            `${row.diffBytes} bytes`);
+        }
+      }
+    }
+  } finally {
+    fs.rmSync(tempRoot, { recursive: true, force: true });
+  }
+  if (json) console.log(JSON.stringify({ sizeMiB, rows }, null, 2));
+  return 0;
+}
+
+module.exports = { runBatch, runBench, loadManifest };
@@ -10,29 +10,31 @@ function usage() {
       'Usage:',
       '  hdp diff <oldFile> <newFile> <outDiff>',
       '  hdp patch <oldFile> <diffFile> <outNew>',
+      '  hdp batch <manifest.json> [--threads N] [--max-memory SIZE] [--json]',
+      '  hdp bench [--size MiB] [--modes single,window,stream] [--json]',
       '',
       'Notes:',
       '  - Uses streaming diff/patch for low memory usage.',
       '  - patch auto-detects the diff format (diffStream or diff/diffWithCovers output).',
       '  - Outputs are files specified by <outDiff>/<outNew>.',
+      '  - batch runs the manifest jobs concurrently; diff jobs pick a mode:',
+      '    single | window | stream | auto (default).',
+      '  - bench diffs and patches built-in generated corpora with each mode.',
     ].join('\n')
   );
 }
 
-// 两种 diff 格式的文件头:流式为 "HDIFF13",单压缩(diff()/diffWithCovers() 产物)为 "HDIFFSF20"
+// 由原生 getDiffInfo() 解析文件头:HDIFF13 为流式格式,HDIFFSF20 为 single 格式
+// (diff()/diffSingleStream()/diffWindow() 产物);无法识别时返回 null
 function detectDiffFormat(diffFile) {
-  const header = Buffer.alloc(9);
-  const fd = fs.openSync(diffFile, 'r');
-  let bytesRead;
+  let info;
   try {
-    bytesRead = fs.readSync(fd, header, 0, header.length, 0);
-  } finally {
-    fs.closeSync(fd);
+    info = hdiffpatch.getDiffInfo(diffFile);
+  } catch (err) {
+    if (!fs.existsSync(diffFile)) throw err;
+    return null;
   }
-  const magic = header.slice(0, bytesRead).toString('latin1');
-  if (magic.startsWith('HDIFFSF20')) return 'single';
-  if (magic.startsWith('HDIFF13')) return 'stream';
-  return null;
+  return info.format === 'HDIFFSF20' ? 'single' : 'stream';
 }
 
 function fail(msg) {
@@ -83,4 +85,15 @@ if (cmd === 'patch') {
   process.exit(0);
 }
 
-fail(`unknown command: ${cmd}`);
+if (cmd === 'batch' || cmd === 'bench') {
+  const batch = require('./batch');
+  const run = cmd === 'batch'
+    ? batch.runBatch(hdiffpatch, detectDiffFormat, args.slice(1))
+    : Promise.resolve().then(() => batch.runBench(hdiffpatch, args.slice(1)));
+  run.then(
+    (code) => process.exit(code),
+    (err) => fail(err && err.message ? err.message : String(err))
+  );
+} else {
+  fail(`unknown command: ${cmd}`);
+}
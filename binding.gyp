@@ -1,4 +1,10 @@
 {
+  "variables": {
+    "hdp_lto%": "false",
+    "hdp_pgo%": "",
+    "hdp_pgo_dir%": "<(module_root_dir)/build/pgo",
+    "hdp_march%": ""
+  },
   "targets": [
     {
       "target_name": "hdiffpatch",
@@ -6,6 +12,19 @@
         "src/main.cc",
         "src/hdiff.cpp",
         "src/hpatch.cpp",
+        "src/parallel.cpp",
+        "src/pipelined_decompress.cpp",
+        "src/buffer_arena.cpp",
+        "src/byte_compare.cpp",
+        "src/cpu_dispatch.cpp",
+        "src/diff_cache.cpp",
+        "src/diff_checksum.cpp",
+        "src/feed_stream.cpp",
+        "src/file_stream.cpp",
+        "src/mapped_file.cpp",
+        "src/mem_stream.cpp",
+        "src/native_memory.cpp",
+        "src/xxh64.cpp",
         "HDiffPatch/libHDiffPatch/HPatch/patch.c",
         "HDiffPatch/file_for_patch.c",
         "HDiffPatch/libHDiffPatch/HDiff/diff.cpp",
@@ -60,6 +79,44 @@
               "ExceptionHandling": 1
             }
           }
+        }],
+        ["hdp_lto==\"true\"", {
+          "defines": [ "HDP_BUILD_LTO=1" ],
+          "cflags": [ "-flto" ],
+          "ldflags": [ "-flto" ],
+          "xcode_settings": {
+            "LLVM_LTO": "YES"
+          },
+          "msvs_settings": {
+            "VCCLCompilerTool": {
+              "WholeProgramOptimization": "true"
+            },
+            "VCLinkerTool": {
+              "LinkTimeCodeGeneration": 1
+            }
+          }
+        }],
+        ["hdp_pgo==\"generate\"", {
+          "defines": [ "HDP_BUILD_PGO=1" ],
+          "cflags": [ "-fprofile-generate=<(hdp_pgo_dir)" ],
+          "ldflags": [ "-fprofile-generate=<(hdp_pgo_dir)" ],
+          "xcode_settings": {
+            "OTHER_CFLAGS": [ "-fprofile-generate=<(hdp_pgo_dir)" ],
+            "OTHER_LDFLAGS": [ "-fprofile-generate=<(hdp_pgo_dir)" ]
+          }
+        }],
+        ["hdp_pgo==\"use\"", {
+          "defines": [ "HDP_BUILD_PGO=2" ],
+          "cflags": [ "-fprofile-use=<(hdp_pgo_dir)", "-Wno-missing-profile" ],
+          "xcode_settings": {
+            "OTHER_CFLAGS": [ "-fprofile-use=<(hdp_pgo_dir)" ]
+          }
+        }],
+        ["hdp_march!=\"\"", {
+          "cflags": [ "-march=<(hdp_march)" ],
+          "xcode_settings": {
+            "OTHER_CFLAGS": [ "-march=<(hdp_march)" ]
+          }
         }]
       ]
     }
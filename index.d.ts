@@ -1,38 +1,335 @@
 /// <reference types="node" />
 
-export type BinaryLike = Buffer | ArrayBufferView;
+/** Views and bare (Shared)ArrayBuffers are read in place, without copying. */
+export type BinaryLike = Buffer | ArrayBufferView | ArrayBuffer | SharedArrayBuffer;
 
 export type DiffCallback = (err: Error | null, result?: Buffer) => void;
+/** Byte count written into a caller-provided `out`. */
+export type WrittenCallback = (err: Error | null, written?: number) => void;
 export type StreamCallback = (err: Error | null, outPath?: string) => void;
 
+export interface DiffCacheOptions {
+  /** Cache directory; created if missing (the parent must exist). */
+  dir: string;
+  /** Evict least-recently-used entries once the directory exceeds this size; 0 = unlimited. */
+  maxBytes?: number;
+}
+
 export interface CompressionOptions {
   /** LZMA2 compression workers. Level 9 and the 8 MiB dictionary are unchanged. */
   compressionThreads?: 1 | 2;
+  /**
+   * Append old/new XXH64 checksums after the diff payload. This library's patch
+   * functions verify them; other HDiffPatch appliers must not be given such a diff.
+   */
+  checksum?: boolean;
+  /** Content-addressed on-disk patch cache shared across calls and processes. */
+  cache?: DiffCacheOptions;
+}
+
+export interface DiffOptions extends CompressionOptions {
+  /**
+   * Heuristic engine switch: for large, mostly identical inputs (shared
+   * prefix/suffix and unchanged blocks cover at least half of new), use the
+   * windowed matcher instead of a full suffix array over old. The measured
+   * regions are not passed to the matcher. Output is still single-format but
+   * not byte-identical to the default path, and may be larger.
+   */
+  trimIdentical?: boolean;
+  /**
+   * Budget in bytes for the suffix index over old (about 4 bytes per old byte
+   * below 2 GiB, 8 above). Selects the engine: when the full index does not
+   * fit, the windowed matcher runs with the largest window whose index fits.
+   * 0 = unlimited; other values must be at least 8 MiB (one 2 MiB window).
+   */
+  maxIndexMemory?: number;
+}
+
+export interface DiffIntoTarget {
+  /**
+   * Write the patch into this region instead of returning a new Buffer; the
+   * byte count is returned. Throws if the patch does not fit. Only diff() and
+   * the Buffer forms of diffSingleStream()/diffWindow() accept it; the other
+   * diff functions throw when it is given.
+   */
+  out: BinaryLike;
+}
+
+export interface DiffIntoOptions extends DiffOptions, DiffIntoTarget {}
+
+export interface FileIoOptions {
+  /** Bytes per read-ahead window step / write-behind block (4 KiB–256 MiB, default 1 MiB). */
+  bufferSize?: number;
+  /** Write-behind blocks in flight and read-ahead depth in blocks (1–64, default 4). */
+  queueDepth?: number;
+  /**
+   * Drop pages of sequentially read inputs and written outputs from the page
+   * cache once processed (default true), so multi-GB files do not evict it.
+   */
+  dropBehind?: boolean;
+}
+
+export interface FileStreamOptions {
+  /**
+   * Overlap file I/O with compute: kernel read-ahead hints for inputs and a
+   * background writer for the output. POSIX only; ignored on Windows. Does
+   * not change the output bytes.
+   */
+  io?: FileIoOptions;
+  /**
+   * Map the input files read-only instead of reading them through file
+   * streams (random access becomes a memcpy). Falls back to reading when a
+   * file cannot be mapped. Inputs must not be truncated while in use.
+   */
+  mmap?: boolean;
+}
+
+export interface FileDiffOptions extends CompressionOptions, FileStreamOptions {}
+
+export interface DiffWindowOptions extends FileDiffOptions {
+  /** Old-data sliding window bytes; 0 uses the native 2 MiB default. */
+  windowSize?: number;
+}
+
+/** Options when `new` is a Readable; `cache` is not supported. */
+export interface ReadableNewOptions extends FileDiffOptions {
+  /** Total byte length of the stream; required, checked when the stream ends. */
+  newSize: number;
+}
+
+export interface ReadableNewWindowOptions extends ReadableNewOptions {
+  windowSize?: number;
 }
 
-export interface DiffWindowOptions extends CompressionOptions {
+/** diffWindow() over in-memory inputs: no io/mmap, since nothing is read from disk. */
+export interface DiffWindowBufferOptions extends CompressionOptions {
   /** Old-data sliding window bytes; 0 uses the native 2 MiB default. */
   windowSize?: number;
 }
 
+export interface PatchChainOptions extends FileStreamOptions {
+  /**
+   * Bytes of intermediate results kept in memory at once (default 256 MiB).
+   * Larger intermediates are written to temp files next to outNewPath.
+   */
+  maxMemory?: number;
+}
+
+export type PatchFileOptions = FileStreamOptions;
+
+export interface PatchStreamOptions extends PatchFileOptions {
+  /**
+   * Decompress each compressed sub-stream ahead on its own thread while the
+   * patch thread copies covers (default false). Output bytes are identical.
+   */
+  pipelined?: boolean;
+}
+
+export interface PatchManyBufferItem {
+  old: BinaryLike;
+  diff: BinaryLike;
+}
+
+export interface PatchManyFileItem {
+  oldPath: string;
+  diffPath: string;
+  outPath: string;
+}
+
+export type PatchManyItem = PatchManyBufferItem | PatchManyFileItem;
+
+/** Buffer for buffer items, outPath for file items, or the item's Error. */
+export type PatchManyResult = Buffer | string | Error;
+
+export type PatchManyCallback = (err: Error | null, results?: PatchManyResult[]) => void;
+
+export interface DiffManyOptions extends DiffOptions {
+  /** Old versions diffed concurrently (1–16); defaults to 1. */
+  threads?: number;
+  /** Lower `threads` until the estimated working set fits; 0 = unlimited. */
+  maxMemory?: number;
+}
+
+export type DiffManyCallback = (err: Error | null, diffs?: Buffer[]) => void;
+
+export type DiffBestCandidate =
+  | ({ engine?: 'diff' } & Omit<DiffOptions, 'checksum'>)
+  | ({ engine: 'window' } & Omit<DiffWindowBufferOptions, 'checksum'>)
+  | ({ engine: 'singleStream' } & Omit<CompressionOptions, 'checksum'>);
+
+export interface DiffBestOptions {
+  /** Configurations to try; at least one. */
+  candidates: DiffBestCandidate[];
+  /**
+   * Start no further candidates after this many ms; running ones finish and
+   * are compared. 0 = unlimited.
+   */
+  timeBudgetMs?: number;
+  /** Candidates run concurrently, cheapest first (1–16); defaults to the CPU count. */
+  threads?: number;
+  /**
+   * Lower `threads` until the estimated working set fits; defaults to half
+   * the physical memory, 0 = unlimited.
+   */
+  maxMemory?: number;
+  /** Applies to every candidate so sizes stay comparable. */
+  checksum?: boolean;
+}
+
+export interface DiffBestCandidateResult {
+  status: 'done' | 'failed' | 'skipped';
+  /** Patch bytes; 0 unless done. */
+  size: number;
+  ms: number;
+  error?: string;
+}
+
+export interface DiffBestResult {
+  /** Smallest verified patch. */
+  diff: Buffer;
+  index: number;
+  candidate: DiffBestCandidate;
+  results: DiffBestCandidateResult[];
+}
+
+export type DiffBestCallback = (err: Error | null, result?: DiffBestResult) => void;
+
+export interface DiffReuseResult {
+  /** Patch from old to new; prevDiff itself when reused is true. */
+  diff: Buffer;
+  /** True when prevDiff still restores new from old. */
+  reused: boolean;
+}
+
+export type DiffReuseCallback = (err: Error | null, result?: DiffReuseResult) => void;
+
+export interface PatchManyOptions {
+  /** Worker threads for the batch (1–64); defaults to the CPU count. */
+  threads?: number;
+}
+
+export interface DiffInfo {
+  format: 'HDIFFSF20' | 'HDIFF13';
+  oldDataSize: number;
+  newDataSize: number;
+  /** '' when the diff data is stored uncompressed. */
+  compressType: string;
+  /** Patch step buffer size; 0 for HDIFF13. */
+  stepMemSize: number;
+  /** The diff carries an old/new checksum trailer. */
+  checksum: boolean;
+  /** Native bytes for patch()/Patcher/patchMany including the output; null for HDIFF13. */
+  patchMemory: number | null;
+  /** Native bytes for patchSingleStream()/patchStream(). */
+  streamPatchMemory: number;
+  /** false when decoder memory is estimated (HDIFF13 assumes an 8 MiB dictionary). */
+  memoryExact: boolean;
+}
+
+export interface NativeMemoryUsage {
+  /** Bytes held right now. */
+  current: number;
+  /** Highest `current` since the process started. */
+  peak: number;
+  /** Running jobs, or live result Buffers for `results`. */
+  count: number;
+}
+
+export interface NativeMemoryStats {
+  /** Sum over all kinds; `peak` is the peak of the sum. */
+  current: number;
+  peak: number;
+  /** Estimated working sets of running diff()/diffSingleStream()/diffWindow() Buffer jobs. */
+  diff: NativeMemoryUsage;
+  /** Estimated working sets of running patch() jobs. */
+  patch: NativeMemoryUsage;
+  /** Native result Buffers from diff()/patch() not yet garbage-collected. */
+  results: NativeMemoryUsage;
+  /** Blocks served by the buffer arena (see configureArena()). */
+  arena: ArenaStats;
+}
+
+export interface ArenaStats {
+  /** Bytes in blocks handed out and not yet released. */
+  live: number;
+  /** Bytes in released blocks kept for reuse. */
+  retained: number;
+  /** Allocations served by the arena since the process started. */
+  allocations: number;
+  /** Of those, allocations served from a retained block. */
+  reused: number;
+  /** `hugetlb` mappings that failed and fell back to transparent huge pages. */
+  hugeTlbFallbacks: number;
+}
+
+export interface ArenaOptions {
+  /** Default: true. `false` stops serving new blocks and releases retained ones. */
+  enabled?: boolean;
+  /** Default: unchanged ('off' initially). */
+  hugePages?: 'off' | 'transparent' | 'hugetlb';
+  /** Released blocks are kept up to this many bytes. Default: unchanged (0 initially). */
+  retainBytes?: number;
+}
+
+export interface BuildInfo {
+  /** CPU features detected at load time. */
+  cpu: { sse2: boolean; sse41: boolean; avx2: boolean; bmi2: boolean; neon: boolean };
+  /** Prefix/suffix compare kernel chosen for this CPU. */
+  byteCompare: 'avx2' | 'sse2' | 'neon' | 'scalar';
+  /**
+   * LZMA match finder normalization routine in use, derived from lzma's
+   * compile-time conditions and this CPU (LzFind.c cannot be queried).
+   */
+  lzmaMatchFinder: 'avx2' | 'sse4.1' | 'neon' | 'generic';
+  /** Best LZMA match finder normalization routine this CPU can run. */
+  lzmaMatchFinderCpuCapable: 'avx2' | 'sse4.1' | 'neon' | 'generic';
+  /** Extensions enabled at compile time for all code (`hdp_march` builds). */
+  compiledFor: string[];
+  lto: boolean;
+  pgo: 'off' | 'generate' | 'use';
+}
+
 export interface NativeAddon {
   diff(oldBuf: BinaryLike, newBuf: BinaryLike): Buffer;
-  diff(oldBuf: BinaryLike, newBuf: BinaryLike, options: CompressionOptions): Buffer;
+  diff(oldBuf: BinaryLike, newBuf: BinaryLike, options: DiffOptions): Buffer;
   diff(oldBuf: BinaryLike, newBuf: BinaryLike, cb: DiffCallback): void;
   diff(
     oldBuf: BinaryLike,
     newBuf: BinaryLike,
-    options: CompressionOptions,
+    options: DiffOptions,
     cb: DiffCallback
   ): void;
   patch(oldBuf: BinaryLike, diffBuf: BinaryLike): Buffer;
   patch(oldBuf: BinaryLike, diffBuf: BinaryLike, cb: DiffCallback): void;
+  patchRange(oldBuf: BinaryLike, diffBuf: BinaryLike, offset: number, length: number): Buffer;
+  patchRange(
+    oldBuf: BinaryLike,
+    diffBuf: BinaryLike,
+    offset: number,
+    length: number,
+    cb: DiffCallback
+  ): void;
+  patchRange(
+    oldBuf: BinaryLike,
+    diffBuf: BinaryLike,
+    offset: number,
+    length: number,
+    out: BinaryLike
+  ): number;
+  patchRange(
+    oldBuf: BinaryLike,
+    diffBuf: BinaryLike,
+    offset: number,
+    length: number,
+    out: BinaryLike,
+    cb: WrittenCallback
+  ): void;
   diffStream(oldPath: string, newPath: string, outDiffPath: string): string;
   diffStream(
     oldPath: string,
     newPath: string,
     outDiffPath: string,
-    options: CompressionOptions
+    options: FileDiffOptions
   ): string;
   diffStream(
     oldPath: string,
@@ -44,7 +341,7 @@ export interface NativeAddon {
     oldPath: string,
     newPath: string,
     outDiffPath: string,
-    options: CompressionOptions,
+    options: FileDiffOptions,
     cb: StreamCallback
   ): void;
   patchStream(oldPath: string, diffPath: string, outNewPath: string): string;
@@ -52,14 +349,46 @@ export interface NativeAddon {
     oldPath: string,
     diffPath: string,
     outNewPath: string,
+    options: PatchStreamOptions
+  ): string;
+  patchStream(
+    oldPath: string,
+    diffPath: string,
+    outNewPath: string,
+    cb: StreamCallback
+  ): void;
+  patchStream(
+    oldPath: string,
+    diffPath: string,
+    outNewPath: string,
+    options: PatchStreamOptions,
     cb: StreamCallback
   ): void;
   diffSingleStream(oldPath: string, newPath: string, outDiffPath: string): string;
+  diffSingleStream(oldBuf: BinaryLike, newBuf: BinaryLike, options?: CompressionOptions): Buffer;
+  diffSingleStream(oldBuf: BinaryLike, newBuf: BinaryLike, cb: DiffCallback): void;
+  diffSingleStream(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    options: CompressionOptions,
+    cb: DiffCallback
+  ): void;
+  diffSingleStream(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    options: CompressionOptions & DiffIntoTarget
+  ): number;
+  diffSingleStream(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    options: CompressionOptions & DiffIntoTarget,
+    cb: WrittenCallback
+  ): void;
   diffSingleStream(
     oldPath: string,
     newPath: string,
     outDiffPath: string,
-    options: CompressionOptions
+    options: FileDiffOptions
   ): string;
   diffSingleStream(
     oldPath: string,
@@ -71,7 +400,7 @@ export interface NativeAddon {
     oldPath: string,
     newPath: string,
     outDiffPath: string,
-    options: CompressionOptions,
+    options: FileDiffOptions,
     cb: StreamCallback,
   ): void;
   patchSingleStream(oldPath: string, diffPath: string, outNewPath: string): string;
@@ -79,6 +408,39 @@ export interface NativeAddon {
     oldPath: string,
     diffPath: string,
     outNewPath: string,
+    options: PatchFileOptions
+  ): string;
+  patchSingleStream(
+    oldPath: string,
+    diffPath: string,
+    outNewPath: string,
+    cb: StreamCallback
+  ): void;
+  patchSingleStream(
+    oldPath: string,
+    diffPath: string,
+    outNewPath: string,
+    options: PatchFileOptions,
+    cb: StreamCallback
+  ): void;
+  patchChain(oldPath: string, diffPaths: string[], outNewPath: string): string;
+  patchChain(
+    oldPath: string,
+    diffPaths: string[],
+    outNewPath: string,
+    options: PatchChainOptions
+  ): string;
+  patchChain(
+    oldPath: string,
+    diffPaths: string[],
+    outNewPath: string,
+    cb: StreamCallback
+  ): void;
+  patchChain(
+    oldPath: string,
+    diffPaths: string[],
+    outNewPath: string,
+    options: PatchChainOptions,
     cb: StreamCallback
   ): void;
   diffWindow(
@@ -87,6 +449,29 @@ export interface NativeAddon {
     outDiffPath: string,
     windowSize?: number
   ): string;
+  diffWindow(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    options?: number | DiffWindowBufferOptions
+  ): Buffer;
+  diffWindow(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    options: number | DiffWindowBufferOptions,
+    cb: DiffCallback
+  ): void;
+  diffWindow(oldBuf: BinaryLike, newBuf: BinaryLike, cb: DiffCallback): void;
+  diffWindow(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    options: DiffWindowBufferOptions & DiffIntoTarget
+  ): number;
+  diffWindow(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    options: DiffWindowBufferOptions & DiffIntoTarget,
+    cb: WrittenCallback
+  ): void;
   diffWindow(
     oldPath: string,
     newPath: string,
@@ -113,6 +498,70 @@ export interface NativeAddon {
     windowSize: number,
     cb: StreamCallback
   ): void;
+  diffFile(oldPath: string, newPath: string, outDiffPath: string): string;
+  diffFile(
+    oldPath: string,
+    newPath: string,
+    outDiffPath: string,
+    options: DiffOptions
+  ): string;
+  diffFile(
+    oldPath: string,
+    newPath: string,
+    outDiffPath: string,
+    cb: StreamCallback
+  ): void;
+  diffFile(
+    oldPath: string,
+    newPath: string,
+    outDiffPath: string,
+    options: DiffOptions,
+    cb: StreamCallback
+  ): void;
+  getDiffInfo(diff: BinaryLike | string): DiffInfo;
+  nativeMemoryStats(): NativeMemoryStats;
+  buildInfo(): BuildInfo;
+  configureArena(options: ArenaOptions): void;
+  diffMany(olds: BinaryLike[], newBuf: BinaryLike, options?: DiffManyOptions): Buffer[];
+  diffBest(oldBuf: BinaryLike, newBuf: BinaryLike, options: DiffBestOptions): DiffBestResult;
+  diffBest(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    options: DiffBestOptions,
+    cb: DiffBestCallback
+  ): void;
+  diffMany(olds: BinaryLike[], newBuf: BinaryLike, cb: DiffManyCallback): void;
+  diffMany(
+    olds: BinaryLike[],
+    newBuf: BinaryLike,
+    options: DiffManyOptions,
+    cb: DiffManyCallback
+  ): void;
+  diffReuse(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    prevDiff: BinaryLike,
+    options?: DiffOptions
+  ): DiffReuseResult;
+  diffReuse(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    prevDiff: BinaryLike,
+    cb: DiffReuseCallback
+  ): void;
+  diffReuse(
+    oldBuf: BinaryLike,
+    newBuf: BinaryLike,
+    prevDiff: BinaryLike,
+    options: DiffOptions,
+    cb: DiffReuseCallback
+  ): void;
+  patchMany(
+    items: PatchManyItem[],
+    options: PatchManyOptions | undefined,
+    cb: PatchManyCallback
+  ): void;
+  Patcher: typeof Patcher;
 }
 
 export const native: NativeAddon;
@@ -128,10 +577,17 @@ export interface HdiffpatchCapabilities {
 export const capabilities: HdiffpatchCapabilities;
 
 export function diff(oldBuf: BinaryLike, newBuf: BinaryLike): Buffer;
+export function diff(oldBuf: BinaryLike, newBuf: BinaryLike, options: DiffIntoOptions): number;
 export function diff(
   oldBuf: BinaryLike,
   newBuf: BinaryLike,
-  options: CompressionOptions
+  options: DiffIntoOptions,
+  cb: WrittenCallback
+): void;
+export function diff(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options: DiffOptions
 ): Buffer;
 export function diff(
   oldBuf: BinaryLike,
@@ -141,17 +597,113 @@ export function diff(
 export function diff(
   oldBuf: BinaryLike,
   newBuf: BinaryLike,
-  options: CompressionOptions,
+  options: DiffOptions,
   cb: DiffCallback
 ): void;
 
+/**
+ * Batch helper: one diff() per old version against the same new, in one
+ * native call. Identical olds share one result Buffer. Each diff applies with
+ * patch(); there is no multi-reference patch.
+ */
+export function diffMany(olds: BinaryLike[], newBuf: BinaryLike, options?: DiffManyOptions): Buffer[];
+export function diffMany(olds: BinaryLike[], newBuf: BinaryLike, cb: DiffManyCallback): void;
+export function diffMany(
+  olds: BinaryLike[],
+  newBuf: BinaryLike,
+  options: DiffManyOptions,
+  cb: DiffManyCallback
+): void;
+
+/**
+ * Runs several diff configurations concurrently on the same inputs and
+ * returns the smallest patch with the configuration that produced it.
+ */
+export function diffBest(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options: DiffBestOptions
+): DiffBestResult;
+export function diffBest(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options: DiffBestOptions,
+  cb: DiffBestCallback
+): void;
+
+/**
+ * Returns prevDiff when it still turns old into new (checked without running
+ * the matcher), otherwise runs diff() with the same options.
+ */
+export function diffReuse(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  prevDiff: BinaryLike,
+  options?: DiffOptions
+): DiffReuseResult;
+export function diffReuse(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  prevDiff: BinaryLike,
+  cb: DiffReuseCallback
+): void;
+export function diffReuse(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  prevDiff: BinaryLike,
+  options: DiffOptions,
+  cb: DiffReuseCallback
+): void;
+
 export function patch(oldBuf: BinaryLike, diffBuf: BinaryLike): Buffer;
+/** Writes the new data into `out` (which must hold all of it) and returns the byte count. */
+export function patch(oldBuf: BinaryLike, diffBuf: BinaryLike, out: BinaryLike): number;
+export function patch(
+  oldBuf: BinaryLike,
+  diffBuf: BinaryLike,
+  out: BinaryLike,
+  cb: WrittenCallback
+): void;
 export function patch(
   oldBuf: BinaryLike,
   diffBuf: BinaryLike,
   cb: DiffCallback
 ): void;
 
+/**
+ * Bytes [offset, offset + length) of the patched file. Decoding stops once the
+ * range is complete; memory grows with length, not with the new file size.
+ */
+export function patchRange(
+  oldBuf: BinaryLike,
+  diffBuf: BinaryLike,
+  offset: number,
+  length: number
+): Buffer;
+export function patchRange(
+  oldBuf: BinaryLike,
+  diffBuf: BinaryLike,
+  offset: number,
+  length: number,
+  cb: DiffCallback
+): void;
+/** Writes the range into `out` (must hold `length` bytes) and returns the byte count. */
+export function patchRange(
+  oldBuf: BinaryLike,
+  diffBuf: BinaryLike,
+  offset: number,
+  length: number,
+  out: BinaryLike
+): number;
+export function patchRange(
+  oldBuf: BinaryLike,
+  diffBuf: BinaryLike,
+  offset: number,
+  length: number,
+  out: BinaryLike,
+  cb: WrittenCallback
+): void;
+
 export function diffStream(
   oldPath: string,
   newPath: string,
@@ -161,7 +713,7 @@ export function diffStream(
   oldPath: string,
   newPath: string,
   outDiffPath: string,
-  options: CompressionOptions
+  options: FileDiffOptions
 ): string;
 export function diffStream(
   oldPath: string,
@@ -173,7 +725,16 @@ export function diffStream(
   oldPath: string,
   newPath: string,
   outDiffPath: string,
-  options: CompressionOptions,
+  options: FileDiffOptions,
+  cb: StreamCallback
+): void;
+
+/** `new` from a Readable: diffing starts while the stream is still being read. */
+export function diffStream(
+  oldPath: string,
+  newStream: NodeJS.ReadableStream,
+  outDiffPath: string,
+  options: ReadableNewOptions,
   cb: StreamCallback
 ): void;
 
@@ -182,22 +743,59 @@ export function patchStream(
   diffPath: string,
   outNewPath: string
 ): string;
+export function patchStream(
+  oldPath: string,
+  diffPath: string,
+  outNewPath: string,
+  options: PatchStreamOptions
+): string;
 export function patchStream(
   oldPath: string,
   diffPath: string,
   outNewPath: string,
   cb: StreamCallback
 ): void;
+export function patchStream(
+  oldPath: string,
+  diffPath: string,
+  outNewPath: string,
+  options: PatchStreamOptions,
+  cb: StreamCallback
+): void;
 export function diffSingleStream(
   oldPath: string,
   newPath: string,
   outDiffPath: string,
 ): string;
+// Buffer 形态:同一流式匹配器作用于内存输入,产物以 Buffer 返回
+export function diffSingleStream(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options?: CompressionOptions
+): Buffer;
+export function diffSingleStream(oldBuf: BinaryLike, newBuf: BinaryLike, cb: DiffCallback): void;
+export function diffSingleStream(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options: CompressionOptions,
+  cb: DiffCallback
+): void;
+export function diffSingleStream(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options: CompressionOptions & DiffIntoTarget
+): number;
+export function diffSingleStream(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options: CompressionOptions & DiffIntoTarget,
+  cb: WrittenCallback
+): void;
 export function diffSingleStream(
   oldPath: string,
   newPath: string,
   outDiffPath: string,
-  options: CompressionOptions,
+  options: FileDiffOptions,
 ): string;
 export function diffSingleStream(
   oldPath: string,
@@ -209,9 +807,17 @@ export function diffSingleStream(
   oldPath: string,
   newPath: string,
   outDiffPath: string,
-  options: CompressionOptions,
+  options: FileDiffOptions,
   cb: StreamCallback,
 ): void;
+/** `new` from a Readable: diffing starts while the stream is still being read. */
+export function diffSingleStream(
+  oldPath: string,
+  newStream: NodeJS.ReadableStream,
+  outDiffPath: string,
+  options: ReadableNewOptions,
+  cb: StreamCallback
+): void;
 export function patchSingleStream(
   oldPath: string,
   diffPath: string,
@@ -221,6 +827,46 @@ export function patchSingleStream(
   oldPath: string,
   diffPath: string,
   outNewPath: string,
+  options: PatchFileOptions
+): string;
+export function patchSingleStream(
+  oldPath: string,
+  diffPath: string,
+  outNewPath: string,
+  cb: StreamCallback
+): void;
+export function patchSingleStream(
+  oldPath: string,
+  diffPath: string,
+  outNewPath: string,
+  options: PatchFileOptions,
+  cb: StreamCallback
+): void;
+
+// 依次应用多个 diff(可混用 single 与 stream 格式),中间结果不写盘,
+// 超过 maxMemory 的才落临时文件。
+export function patchChain(
+  oldPath: string,
+  diffPaths: string[],
+  outNewPath: string
+): string;
+export function patchChain(
+  oldPath: string,
+  diffPaths: string[],
+  outNewPath: string,
+  options: PatchChainOptions
+): string;
+export function patchChain(
+  oldPath: string,
+  diffPaths: string[],
+  outNewPath: string,
+  cb: StreamCallback
+): void;
+export function patchChain(
+  oldPath: string,
+  diffPaths: string[],
+  outNewPath: string,
+  options: PatchChainOptions,
   cb: StreamCallback
 ): void;
 
@@ -234,6 +880,29 @@ export function diffWindow(
   outDiffPath: string,
   windowSize?: number
 ): string;
+export function diffWindow(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options?: number | DiffWindowBufferOptions
+): Buffer;
+export function diffWindow(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options: number | DiffWindowBufferOptions,
+  cb: DiffCallback
+): void;
+export function diffWindow(oldBuf: BinaryLike, newBuf: BinaryLike, cb: DiffCallback): void;
+export function diffWindow(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options: DiffWindowBufferOptions & DiffIntoTarget
+): number;
+export function diffWindow(
+  oldBuf: BinaryLike,
+  newBuf: BinaryLike,
+  options: DiffWindowBufferOptions & DiffIntoTarget,
+  cb: WrittenCallback
+): void;
 export function diffWindow(
   oldPath: string,
   newPath: string,
@@ -260,17 +929,135 @@ export function diffWindow(
   windowSize: number,
   cb: StreamCallback
 ): void;
+/** `new` from a Readable: diffing starts while the stream is still being read. */
+export function diffWindow(
+  oldPath: string,
+  newStream: NodeJS.ReadableStream,
+  outDiffPath: string,
+  options: ReadableNewWindowOptions,
+  cb: StreamCallback
+): void;
+
+// 内存版 diff() 直接作用于映射的文件,产物与 diff() 字节相同,
+// old/new 不进入 JS 堆。
+export function diffFile(
+  oldPath: string,
+  newPath: string,
+  outDiffPath: string
+): string;
+export function diffFile(
+  oldPath: string,
+  newPath: string,
+  outDiffPath: string,
+  options: DiffOptions
+): string;
+export function diffFile(
+  oldPath: string,
+  newPath: string,
+  outDiffPath: string,
+  cb: StreamCallback
+): void;
+export function diffFile(
+  oldPath: string,
+  newPath: string,
+  outDiffPath: string,
+  options: DiffOptions,
+  cb: StreamCallback
+): void;
+
+/** Reads a diff header (Buffer or file path) without applying it. */
+export function getDiffInfo(diff: BinaryLike | string): DiffInfo;
+
+/** Native memory reported to V8 by running jobs and live result Buffers. */
+export function nativeMemoryStats(): NativeMemoryStats;
+
+/** Build flags and the kernel variants selected for the running CPU. */
+export function buildInfo(): BuildInfo;
+
+/**
+ * Routes large patch buffers and diffFile() input copies through a huge-page
+ * arena. Diff working memory (suffix array, matchers, LZMA) is not covered.
+ */
+export function configureArena(options: ArenaOptions): void;
+
+/**
+ * Diff two ZIP-based archives (zip/APK/IPA/jar) on their inflated entries.
+ * Entries whose deflate stream zlib reproduces bit-exactly are diffed
+ * uncompressed; everything else is diffed as stored bytes. Options are passed
+ * to diff() (checksum is always on). Non-archives work as plain bytes.
+ */
+export function diffArchive(
+  oldArchive: BinaryLike,
+  newArchive: BinaryLike,
+  options?: DiffOptions
+): Buffer;
+export function diffArchive(oldArchive: BinaryLike, newArchive: BinaryLike, cb: DiffCallback): void;
+export function diffArchive(
+  oldArchive: BinaryLike,
+  newArchive: BinaryLike,
+  options: DiffOptions,
+  cb: DiffCallback
+): void;
+
+/** Applies a diffArchive() patch; verifies the rebuilt archive's sha256. */
+export function patchArchive(oldArchive: BinaryLike, diff: BinaryLike): Buffer;
+export function patchArchive(oldArchive: BinaryLike, diff: BinaryLike, cb: DiffCallback): void;
+
+/**
+ * Applies many diffs in one native call on an internal thread pool. Buffer
+ * items must be single-format; file items may use either format. One item's
+ * failure is reported in its slot and does not fail the batch.
+ */
+export function patchMany(
+  items: PatchManyItem[],
+  options?: PatchManyOptions
+): Promise<PatchManyResult[]>;
+export function patchMany(items: PatchManyItem[], cb: PatchManyCallback): void;
+export function patchMany(
+  items: PatchManyItem[],
+  options: PatchManyOptions,
+  cb: PatchManyCallback
+): void;
+
+/**
+ * Applies single-format diffs while reusing its work buffer across calls.
+ * The LZMA2 decoder state is still allocated per call.
+ * patchAsync() calls on one instance run one after another in call order;
+ * patch() throws while an async patch is pending.
+ */
+export class Patcher {
+  constructor();
+  patch(oldBuf: BinaryLike, diffBuf: BinaryLike): Buffer;
+  /** Writes into `out` (must hold the whole result) and returns the byte count. */
+  patch(oldBuf: BinaryLike, diffBuf: BinaryLike, out: ArrayBufferView): number;
+  patchAsync(oldBuf: BinaryLike, diffBuf: BinaryLike): Promise<Buffer>;
+  patchAsync(oldBuf: BinaryLike, diffBuf: BinaryLike, out: ArrayBufferView): Promise<number>;
+}
 
 declare const hdiffpatch: {
   native: NativeAddon;
   capabilities: HdiffpatchCapabilities;
   diff: typeof diff;
   patch: typeof patch;
+  patchRange: typeof patchRange;
   diffStream: typeof diffStream;
   patchStream: typeof patchStream;
   diffSingleStream: typeof diffSingleStream;
   patchSingleStream: typeof patchSingleStream;
   diffWindow: typeof diffWindow;
+  diffFile: typeof diffFile;
+  patchChain: typeof patchChain;
+  getDiffInfo: typeof getDiffInfo;
+  nativeMemoryStats: typeof nativeMemoryStats;
+  buildInfo: typeof buildInfo;
+  configureArena: typeof configureArena;
+  diffMany: typeof diffMany;
+  diffBest: typeof diffBest;
+  diffReuse: typeof diffReuse;
+  diffArchive: typeof diffArchive;
+  patchArchive: typeof patchArchive;
+  patchMany: typeof patchMany;
+  Patcher: typeof Patcher;
 };
 
 export default hdiffpatch;
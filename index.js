@@ -33,11 +33,44 @@ exports.native = native;
 
 exports.diff = native.diff;
 exports.patch = native.patch;
-exports.diffStream = native.diffStream;
+exports.patchRange = native.patchRange;
+// new 为 Readable 时边接收边 diff(见 readable_new.js),其余参数原样交给原生实现
+const readableNew = require('./readable_new')(native);
+exports.diffStream = readableNew.wrap('diffStream');
 exports.patchStream = native.patchStream;
-exports.diffSingleStream = native.diffSingleStream;
+exports.diffSingleStream = readableNew.wrap('diffSingleStream');
 exports.patchSingleStream = native.patchSingleStream;
-exports.diffWindow = native.diffWindow;
+exports.diffWindow = readableNew.wrap('diffWindow');
+exports.diffFile = native.diffFile;
+exports.diffMany = native.diffMany;
+exports.diffBest = native.diffBest;
+exports.diffReuse = native.diffReuse;
+exports.patchChain = native.patchChain;
+exports.getDiffInfo = native.getDiffInfo;
+exports.nativeMemoryStats = native.nativeMemoryStats;
+exports.buildInfo = native.buildInfo;
+exports.configureArena = native.configureArena;
+exports.Patcher = native.Patcher;
+
+// ZIP/APK/IPA:展开可逐字节复现的 deflate 条目后再 diff(见 archive.js)
+const archive = require('./archive')(native);
+exports.diffArchive = archive.diffArchive;
+exports.patchArchive = archive.patchArchive;
+
+// 整批在一次原生调用中完成;省略回调时返回 Promise
+exports.patchMany = function patchMany(items, options, cb) {
+  if (typeof options === 'function') {
+    cb = options;
+    options = undefined;
+  }
+  if (typeof cb === 'function') {
+    native.patchMany(items, options, cb);
+    return undefined;
+  }
+  return new Promise((resolve, reject) => {
+    native.patchMany(items, options, (err, results) => (err ? reject(err) : resolve(results)));
+  });
+};
 
 // Every native diff entry point performs a complete apply-and-compare check
 // before returning. Consumers that would otherwise repeat the same round trip
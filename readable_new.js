@@ -0,0 +1,163 @@
+'use strict';
+
+// new 为 Node Readable 时的 diffStream()/diffSingleStream()/diffWindow()。
+//
+// 数据按到达顺序写入 outDiffPath 旁的 spool 文件(`<outDiffPath>.new.tmp`),
+// 每写完一块通知原生端(NewFeed.advance)。匹配器从前往后读 new,读到尚未写入
+// 的位置时在工作线程中等待,因此 diff 与 new 的生成同时进行;回看、生成后的
+// 回读校验与摘要从 spool 重读。diff 头部需要 new 的总长度,必须由
+// options.newSize 事先给出,流结束时字节数不符即报错。spool 在完成后删除。
+// 写入 spool 的速度只受磁盘限制,不受 diff 进度限制。spool 用异步 fs.write
+// 顺序写入(同一时刻至多一块,Writable 据此施加背压);等待中的 diff 在原生端
+// 独立线程中运行,不占 libuv 线程池,因此不会与这些写入互相等待。
+
+const fs = require('fs');
+const { Writable, pipeline } = require('stream');
+
+const kEngines = {
+  diffStream: 'stream',
+  diffSingleStream: 'single',
+  diffWindow: 'window',
+};
+
+function isReadable(value) {
+  return value !== null && typeof value === 'object' &&
+    typeof value.pipe === 'function' && typeof value.on === 'function';
+}
+
+// 把 chunk 完整写到 position 处,短写时接着写剩余部分
+function writeAll(fd, chunk, position, done) {
+  let offset = 0;
+  (function next() {
+    fs.write(fd, chunk, offset, chunk.length - offset, position + offset, (err, written) => {
+      if (err) return done(err);
+      offset += written;
+      if (offset < chunk.length) return next();
+      return done(null);
+    });
+  })();
+}
+
+// native 为原生模块(需要 diffFeed/NewFeed 与三个文件 diff 入口)
+module.exports = function createReadableNew(native) {
+  function diffReadable(engine, oldPath, source, outDiffPath, options, cb) {
+    const newSize = options.newSize;
+    if (!Number.isSafeInteger(newSize) || newSize < 0) {
+      throw new TypeError('Invalid newSize: a Readable new requires options.newSize (its byte length).');
+    }
+    if (typeof oldPath !== 'string' || typeof outDiffPath !== 'string') {
+      throw new TypeError('Invalid arguments: expected (oldPath, newReadable, outDiffPath).');
+    }
+    const nativeOptions = Object.assign({}, options);
+    delete nativeOptions.newSize;
+
+    const spoolPath = `${outDiffPath}.new.tmp`;
+    let fd;
+    try {
+      fd = fs.openSync(spoolPath, 'w');
+    } catch (err) {
+      process.nextTick(cb, err);
+      return undefined;
+    }
+    const feed = new native.NewFeed(spoolPath, newSize);
+    let position = 0;
+    // 进行中的写入结束前不能关闭 fd:destroy 等它完成后再结束管道
+    let writing = false;
+    let afterWrite = null;
+    const sink = new Writable({
+      write(chunk, encoding, done) {
+        if (chunk.length > newSize - position) {
+          return done(new Error(`new stream is longer than newSize (${newSize} bytes).`));
+        }
+        writing = true;
+        writeAll(fd, chunk, position, (err) => {
+          writing = false;
+          if (!err) {
+            position += chunk.length;
+            feed.advance(chunk.length);
+          }
+          done(err);
+          if (afterWrite) afterWrite();
+        });
+        return undefined;
+      },
+      final(done) {
+        if (position !== newSize) {
+          return done(new Error(`new stream ended after ${position} bytes; newSize is ${newSize}.`));
+        }
+        feed.end();
+        return done();
+      },
+      destroy(err, done) {
+        if (!writing) return done(err);
+        afterWrite = () => done(err);
+        return undefined;
+      },
+    });
+
+    // 两端都结束后再回调:原生端先失败时中止管道(同时销毁 source),
+    // 管道先失败时中止 feed,让等待中的读取立即失败;错误优先报告输入端的
+    let nativeDone = false;
+    let nativeErr = null;
+    let streamDone = false;
+    let streamErr = null;
+    let thrown = false;
+    function finish() {
+      if (!nativeDone || !streamDone) return;
+      fs.close(fd, () => {
+        fs.unlink(spoolPath, () => {
+          if (thrown) return;
+          const err = streamErr || nativeErr;
+          if (err) cb(err);
+          else cb(null, outDiffPath);
+        });
+      });
+    }
+    pipeline(source, sink, (err) => {
+      streamDone = true;
+      streamErr = err || null;
+      if (err) feed.abort();
+      finish();
+    });
+    try {
+      native.diffFeed(engine, oldPath, feed, outDiffPath, nativeOptions, (err) => {
+        nativeDone = true;
+        nativeErr = err || null;
+        if (err && !streamDone) sink.destroy(err);
+        finish();
+      });
+    } catch (err) {
+      // 参数错误同步抛出;管道停下后只做清理,不再回调
+      nativeDone = true;
+      thrown = true;
+      sink.destroy(err);
+      throw err;
+    }
+    return undefined;
+  }
+
+  // name 为 kEngines 中的入口;new 不是 Readable 时原样转发给原生实现
+  function wrap(name) {
+    const engine = kEngines[name];
+    const direct = native[name];
+    return function diffMaybeReadable(oldPath, newPath, ...rest) {
+      if (!isReadable(newPath)) return direct(oldPath, newPath, ...rest);
+      const outDiffPath = rest.shift();
+      const cb = typeof rest[rest.length - 1] === 'function' ? rest.pop() : undefined;
+      if (!cb) {
+        throw new TypeError('A Readable new requires a callback: diffing runs while the stream is read.');
+      }
+      const options = {};
+      if (engine === 'window' && typeof rest[0] === 'number') options.windowSize = rest.shift();
+      if (rest.length > 0) {
+        if (rest[0] === null || typeof rest[0] !== 'object') {
+          throw new TypeError('Invalid diff options: expected an object.');
+        }
+        Object.assign(options, rest[0]);
+      }
+      return diffReadable(engine, oldPath, newPath, outDiffPath, options, cb);
+    };
+  }
+
+  return { wrap };
+};
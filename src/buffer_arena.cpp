@@ -0,0 +1,154 @@
+#include "buffer_arena.h"
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#endif
+
+namespace {
+    const size_t kHugePageSize = (size_t)2 << 20;
+    // 复用时最多接受两倍大小的空闲块,避免小请求长期占住大块
+    const size_t kReuseSlack = 2;
+
+    std::mutex g_mutex;
+    std::atomic<bool> g_enabled(false);
+    ArenaOptions g_options;
+    // 块起址 → 按 kHugePageSize 取整后的字节数
+    std::map<void*, size_t> g_live;
+    std::multimap<size_t, void*> g_retained;
+    ArenaStats g_stats;
+
+    size_t round_up(size_t bytes) {
+        return (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    }
+
+    void unmap(void* p, size_t size) {
+#ifdef _WIN32
+        (void)size;
+        VirtualFree(p, 0, MEM_RELEASE);
+#else
+        munmap(p, size);
+#endif
+    }
+
+    // MAP_HUGETLB 失败改用透明大页时置 *out_fellBack(不持锁调用)
+    void* map_block(size_t size, HugePageMode mode, bool* out_fellBack) {
+#ifdef _WIN32
+        (void)mode;
+        (void)out_fellBack;
+        return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+#   if defined(MAP_HUGETLB)
+        if (mode == HugePageMode::HugeTlb) {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) return p;
+            // 没有预留大页(或超出 nr_hugepages):退回透明大页
+            *out_fellBack = true;
+            mode = HugePageMode::Transparent;
+        }
+#   endif
+        // 透明大页要求 2MB 对齐:多映射一页再裁掉首尾
+        const size_t mapSize = (mode == HugePageMode::Off) ? size : size + kHugePageSize;
+        void* p = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+        uint8_t* base = (uint8_t*)p;
+        if (mode != HugePageMode::Off) {
+            uint8_t* aligned = (uint8_t*)(((uintptr_t)base + kHugePageSize - 1) &
+                                          ~(uintptr_t)(kHugePageSize - 1));
+            const size_t head = (size_t)(aligned - base);
+            const size_t tail = mapSize - head - size;
+            if (head) munmap(base, head);
+            if (tail) munmap(aligned + size, tail);
+            base = aligned;
+#   if defined(MADV_HUGEPAGE)
+            madvise(base, size, MADV_HUGEPAGE);
+#   endif
+        }
+        return base;
+#endif
+    }
+
+    // 调用方持有 g_mutex
+    void trim_retained(uint64_t limit) {
+        while (g_stats.retainedBytes > limit && !g_retained.empty()) {
+            // 先归还最大的块
+            auto it = std::prev(g_retained.end());
+            g_stats.retainedBytes -= it->first;
+            unmap(it->second, it->first);
+            g_retained.erase(it);
+        }
+    }
+}
+
+void arena_configure(const ArenaOptions& options) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_options = options;
+    g_enabled.store(options.enabled, std::memory_order_relaxed);
+    trim_retained(options.enabled ? options.retainBytes : 0);
+}
+
+ArenaOptions arena_options() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_options;
+}
+
+ArenaStats arena_stats() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_stats;
+}
+
+void* arena_alloc(size_t bytes) {
+    if (bytes < kArenaMinAlloc || !g_enabled.load(std::memory_order_relaxed)) return nullptr;
+    const size_t size = round_up(bytes);
+    if (size < bytes) return nullptr;  // 取整溢出
+    std::unique_lock<std::mutex> lock(g_mutex);
+    auto it = g_retained.lower_bound(size);
+    if (it != g_retained.end() && it->first <= size * kReuseSlack) {
+        void* p = it->second;
+        const size_t blockSize = it->first;
+        g_retained.erase(it);
+        g_stats.retainedBytes -= blockSize;
+        g_live[p] = blockSize;
+        g_stats.liveBytes += blockSize;
+        ++g_stats.allocations;
+        ++g_stats.reused;
+        return p;
+    }
+    const HugePageMode mode = g_options.hugePages;
+    lock.unlock();
+
+    bool fellBack = false;
+    void* p = map_block(size, mode, &fellBack);
+    lock.lock();
+    if (fellBack) ++g_stats.hugeTlbFallbacks;
+    if (!p) return nullptr;
+    g_live[p] = size;
+    g_stats.liveBytes += size;
+    ++g_stats.allocations;
+    return p;
+}
+
+bool arena_free(void* p) {
+    if (!p) return false;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_live.find(p);
+    if (it == g_live.end()) return false;
+    const size_t blockSize = it->second;
+    g_live.erase(it);
+    g_stats.liveBytes -= blockSize;
+    const uint64_t limit = g_options.enabled ? g_options.retainBytes : 0;
+    if (g_stats.retainedBytes + blockSize <= limit) {
+        g_retained.emplace(blockSize, p);
+        g_stats.retainedBytes += blockSize;
+    } else {
+        unmap(p, blockSize);
+    }
+    return true;
+}
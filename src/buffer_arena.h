@@ -0,0 +1,49 @@
+/**
+ * buffer_arena - 大块工作缓冲的进程级分配池
+ * 不小于 kArenaMinAlloc 的缓冲直接向内核映射(按 2MB 取整),可选透明大页
+ * (madvise MADV_HUGEPAGE)或 hugetlbfs 预留页(MAP_HUGETLB,失败时退回透明大页);
+ * 释放后在 retainBytes 以内保留,供后续任务复用,省去重复的缺页与清零。
+ * 默认关闭:未配置时 arena_alloc() 返回 nullptr,调用方按原路径分配。
+ * 只服务经 PatchBuffer 分配的缓冲(patch 输出与工作区、diffFile 的输入副本);
+ * HDiffPatch 内部的后缀数组、匹配器与 LZMA 状态仍走 malloc。
+ * 大页仅 Linux 支持,其他平台只提供保留复用。
+ */
+
+#ifndef HDIFFPATCH_BUFFER_ARENA_H
+#define HDIFFPATCH_BUFFER_ARENA_H
+#include <stddef.h>
+#include <stdint.h>
+
+enum class HugePageMode {
+    Off,
+    Transparent,  // THP:映射对齐到 2MB 并 madvise(MADV_HUGEPAGE)
+    HugeTlb,      // MAP_HUGETLB,需预留 vm.nr_hugepages
+};
+
+struct ArenaOptions {
+    bool enabled = false;
+    HugePageMode hugePages = HugePageMode::Off;
+    uint64_t retainBytes = 0;  // 空闲块保留上限,0 表示释放即归还内核
+};
+
+struct ArenaStats {
+    uint64_t liveBytes = 0;          // 已分配出去的块
+    uint64_t retainedBytes = 0;      // 空闲但保留的块
+    uint64_t allocations = 0;        // 经 arena 分配的次数
+    uint64_t reused = 0;             // 其中复用保留块的次数
+    uint64_t hugeTlbFallbacks = 0;   // MAP_HUGETLB 失败后改用透明大页的次数
+};
+
+const size_t kArenaMinAlloc = (size_t)1 << 20;
+
+// 重新配置;保留量超出新上限的空闲块立即归还
+void arena_configure(const ArenaOptions& options);
+ArenaOptions arena_options();
+ArenaStats arena_stats();
+
+// 未启用、尺寸小于 kArenaMinAlloc 或映射失败时返回 nullptr
+void* arena_alloc(size_t bytes);
+// p 不是 arena 分配的块时返回 false(由调用方按原路径释放)
+bool arena_free(void* p);
+
+#endif
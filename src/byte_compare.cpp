@@ -0,0 +1,191 @@
+#include "byte_compare.h"
+#include "cpu_dispatch.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define HDP_BYTE_COMPARE_SSE2 1
+#   include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   define HDP_BYTE_COMPARE_NEON 1
+#   include <arm_neon.h>
+#endif
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+// AVX2 变体单独以 target 属性编译,运行时 CPU 支持时才选用;整个模块仍按基线构建
+#if HDP_BYTE_COMPARE_SSE2 && (defined(__x86_64__) || defined(_M_X64)) && \
+    (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#   define HDP_BYTE_COMPARE_AVX2 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       define HDP_TARGET_AVX2
+#   else
+#       define HDP_TARGET_AVX2 __attribute__((target("avx2")))
+#   endif
+#endif
+
+namespace {
+    const size_t kLane = 16;
+
+#if HDP_BYTE_COMPARE_SSE2
+    inline unsigned lowest_bit(unsigned v) {
+#   if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward(&idx, v);
+        return (unsigned)idx;
+#   else
+        return (unsigned)__builtin_ctz(v);
+#   endif
+    }
+
+    inline unsigned highest_bit(unsigned v) {
+#   if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse(&idx, v);
+        return (unsigned)idx;
+#   else
+        return 31u - (unsigned)__builtin_clz(v);
+#   endif
+    }
+
+    // 16 字节中不相等位置的位掩码,全部相等时为 0
+    inline unsigned mismatch_mask(const uint8_t* a, const uint8_t* b) {
+        const __m128i va = _mm_loadu_si128((const __m128i*)a);
+        const __m128i vb = _mm_loadu_si128((const __m128i*)b);
+        return (~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb))) & 0xffffu;
+    }
+#elif HDP_BYTE_COMPARE_NEON
+    inline bool lane_equal(const uint8_t* a, const uint8_t* b) {
+        return vminvq_u8(vceqq_u8(vld1q_u8(a), vld1q_u8(b))) == 0xff;
+    }
+#else
+    inline bool lane_equal(const uint8_t* a, const uint8_t* b) {
+        uint64_t a0, a1, b0, b1;
+        std::memcpy(&a0, a, 8);
+        std::memcpy(&a1, a + 8, 8);
+        std::memcpy(&b0, b, 8);
+        std::memcpy(&b1, b + 8, 8);
+        return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+    }
+#endif
+}
+
+namespace {
+    size_t prefix_base(const uint8_t* a, const uint8_t* b, size_t size) {
+        size_t pos = 0;
+        for (; pos + kLane <= size; pos += kLane) {
+#if HDP_BYTE_COMPARE_SSE2
+            const unsigned mask = mismatch_mask(a + pos, b + pos);
+            if (mask != 0) return pos + lowest_bit(mask);
+#else
+            if (!lane_equal(a + pos, b + pos)) break;
+#endif
+        }
+        while (pos < size && a[pos] == b[pos]) ++pos;
+        return pos;
+    }
+
+    size_t suffix_base(const uint8_t* a_end, const uint8_t* b_end, size_t size) {
+        size_t len = 0;
+        for (; len + kLane <= size; len += kLane) {
+            const uint8_t* a = a_end - len - kLane;
+            const uint8_t* b = b_end - len - kLane;
+#if HDP_BYTE_COMPARE_SSE2
+            const unsigned mask = mismatch_mask(a, b);
+            if (mask != 0) return len + (kLane - 1 - highest_bit(mask));
+#else
+            if (!lane_equal(a, b)) break;
+#endif
+        }
+        while (len < size && a_end[-(ptrdiff_t)len - 1] == b_end[-(ptrdiff_t)len - 1]) ++len;
+        return len;
+    }
+
+#if HDP_BYTE_COMPARE_AVX2
+    const size_t kWideLane = 32;
+
+    HDP_TARGET_AVX2
+    inline unsigned wide_mismatch_mask(const uint8_t* a, const uint8_t* b) {
+        const __m256i va = _mm256_loadu_si256((const __m256i*)a);
+        const __m256i vb = _mm256_loadu_si256((const __m256i*)b);
+        return ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+    }
+
+    // 32 字节一组比较,尾部不足一组时交给基线内核
+    HDP_TARGET_AVX2
+    size_t prefix_avx2(const uint8_t* a, const uint8_t* b, size_t size) {
+        size_t pos = 0;
+        for (; pos + kWideLane <= size; pos += kWideLane) {
+            const unsigned mask = wide_mismatch_mask(a + pos, b + pos);
+            if (mask != 0) return pos + lowest_bit(mask);
+        }
+        return pos + prefix_base(a + pos, b + pos, size - pos);
+    }
+
+    HDP_TARGET_AVX2
+    size_t suffix_avx2(const uint8_t* a_end, const uint8_t* b_end, size_t size) {
+        size_t len = 0;
+        for (; len + kWideLane <= size; len += kWideLane) {
+            const unsigned mask = wide_mismatch_mask(a_end - len - kWideLane,
+                                                     b_end - len - kWideLane);
+            if (mask != 0) return len + (kWideLane - 1 - highest_bit(mask));
+        }
+        return len + suffix_base(a_end - len, b_end - len, size - len);
+    }
+#endif
+
+    typedef size_t (*CompareFn)(const uint8_t*, const uint8_t*, size_t);
+
+    struct Kernels {
+        CompareFn prefix = prefix_base;
+        CompareFn suffix = suffix_base;
+        const char* name = nullptr;
+    };
+
+    Kernels select_kernels() {
+        Kernels kernels;
+#if HDP_BYTE_COMPARE_AVX2
+        if (cpu_features().avx2) {
+            kernels.prefix = prefix_avx2;
+            kernels.suffix = suffix_avx2;
+            kernels.name = "avx2";
+            return kernels;
+        }
+#endif
+#if HDP_BYTE_COMPARE_SSE2
+        kernels.name = "sse2";
+#elif HDP_BYTE_COMPARE_NEON
+        kernels.name = "neon";
+#else
+        kernels.name = "scalar";
+#endif
+        return kernels;
+    }
+
+    const Kernels& kernels() {
+        static const Kernels selected = select_kernels();
+        return selected;
+    }
+}
+
+size_t common_prefix_size(const uint8_t* a, const uint8_t* b, size_t size) {
+    return kernels().prefix(a, b, size);
+}
+
+size_t common_suffix_size(const uint8_t* a_end, const uint8_t* b_end, size_t size) {
+    return kernels().suffix(a_end, b_end, size);
+}
+
+size_t identical_block_bytes(const uint8_t* a, const uint8_t* b, size_t size, size_t blockSize) {
+    if (blockSize == 0) return 0;
+    const CompareFn prefix = kernels().prefix;
+    size_t total = 0;
+    for (size_t pos = 0; pos + blockSize <= size; pos += blockSize) {
+        if (prefix(a + pos, b + pos, blockSize) == blockSize) total += blockSize;
+    }
+    return total;
+}
+
+const char* byte_compare_variant() {
+    return kernels().name;
+}
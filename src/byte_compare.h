@@ -0,0 +1,20 @@
+/**
+ * byte_compare - 新旧数据逐字节比较的向量化内核(AVX2 / SSE2 / NEON / 标量)
+ * 用于 diff 前快速统计相同区域:公共前缀、公共后缀以及同偏移的相同块。
+ */
+
+#ifndef HDIFFPATCH_BYTE_COMPARE_H
+#define HDIFFPATCH_BYTE_COMPARE_H
+#include <stddef.h>
+#include <stdint.h>
+
+// a、b 从头开始相同的字节数(不超过 size)
+size_t common_prefix_size(const uint8_t* a, const uint8_t* b, size_t size);
+// a_end、b_end 之前向前相同的字节数(不超过 size)
+size_t common_suffix_size(const uint8_t* a_end, const uint8_t* b_end, size_t size);
+// [0, size) 内按 blockSize 对齐、同偏移完全相同的块的总字节数
+size_t identical_block_bytes(const uint8_t* a, const uint8_t* b, size_t size, size_t blockSize);
+// 当前选用的内核名:"avx2"(x64 且 CPU 支持时运行时选用)/ "sse2" / "neon" / "scalar"
+const char* byte_compare_variant();
+
+#endif
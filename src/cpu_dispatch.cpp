@@ -0,0 +1,105 @@
+#include "cpu_dispatch.h"
+#include <mutex>
+#include "../lzma/C/LzFind.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <immintrin.h>
+#   include <intrin.h>
+#   define HDP_CPU_X86_MSVC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   define HDP_CPU_X86_GNU 1
+#endif
+
+namespace {
+    CpuFeatures detect() {
+        CpuFeatures features;
+#if HDP_CPU_X86_MSVC
+        int regs[4];
+        __cpuid(regs, 0);
+        const int maxLeaf = regs[0];
+        __cpuid(regs, 1);
+        features.sse2 = (regs[3] & (1 << 26)) != 0;
+        features.sse41 = (regs[2] & (1 << 19)) != 0;
+        const bool osxsave = (regs[2] & (1 << 27)) != 0;
+        const bool avx = (regs[2] & (1 << 28)) != 0;
+        // XCR0 的 XMM|YMM 位:操作系统会在上下文切换时保存 AVX 寄存器
+        const bool ymmSaved = osxsave && avx && ((_xgetbv(0) & 0x6) == 0x6);
+        if (maxLeaf >= 7) {
+            __cpuidex(regs, 7, 0);
+            features.avx2 = ymmSaved && (regs[1] & (1 << 5)) != 0;
+            features.bmi2 = (regs[1] & (1 << 8)) != 0;
+        }
+#elif HDP_CPU_X86_GNU
+        // libgcc / compiler-rt 的检测已包含 XGETBV 对 AVX 状态的检查
+        __builtin_cpu_init();
+        features.sse2 = __builtin_cpu_supports("sse2") != 0;
+        features.sse41 = __builtin_cpu_supports("sse4.1") != 0;
+        features.avx2 = __builtin_cpu_supports("avx2") != 0;
+        features.bmi2 = __builtin_cpu_supports("bmi2") != 0;
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        features.neon = true;  // AArch64 基线即包含 ASIMD
+#endif
+        return features;
+    }
+
+    std::once_flag g_lzmaPrepared;
+}
+
+const CpuFeatures& cpu_features() {
+    static const CpuFeatures features = detect();
+    return features;
+}
+
+void cpu_dispatch_init() {
+    std::call_once(g_lzmaPrepared, [] { LzFindPrepare(); });
+}
+
+// 与 LzFind.c 的条件保持一致:x86 上 GCC 4.7.1+/clang 4+ 同时启用 128/256 位
+// 例程,MSVC 2010+ 启用 128 位、2015+ 再启用 256 位;ARM64 上 GCC 8+/clang 8+
+// 或 MSVC 2017+ 启用 128 位(NEON)
+#if HDP_CPU_X86_GNU
+#   if (defined(__clang__) && __clang_major__ >= 4) || \
+       (!defined(__clang__) && (__GNUC__ * 10000 + __GNUC_MINOR__ * 100 + __GNUC_PATCHLEVEL__) >= 40701)
+#       define HDP_LZFIND_SATUR_SUB_128 1
+#       define HDP_LZFIND_SATUR_SUB_256 1
+#   endif
+#elif HDP_CPU_X86_MSVC
+#   if _MSC_VER >= 1600
+#       define HDP_LZFIND_SATUR_SUB_128 1
+#   endif
+#   if _MSC_VER >= 1900
+#       define HDP_LZFIND_SATUR_SUB_256 1
+#   endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   if (defined(__clang__) && __clang_major__ >= 8) || \
+       (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8) || \
+       (defined(_MSC_VER) && _MSC_VER >= 1910)
+#       define HDP_LZFIND_SATUR_SUB_128 1
+#   endif
+#endif
+
+const char* lzma_match_finder_variant() {
+    const CpuFeatures& features = cpu_features();
+#if HDP_LZFIND_SATUR_SUB_128
+#   if defined(__aarch64__) || defined(_M_ARM64)
+    if (features.neon) return "neon";
+#   else
+    if (features.sse41) {
+#       if HDP_LZFIND_SATUR_SUB_256
+        if (features.avx2) return "avx2";
+#       endif
+        return "sse4.1";
+    }
+#   endif
+#endif
+    (void)features;
+    return "generic";
+}
+
+const char* lzma_match_finder_cpu_capable() {
+    const CpuFeatures& features = cpu_features();
+    if (features.avx2) return "avx2";
+    if (features.sse41) return "sse4.1";
+    if (features.neon) return "neon";
+    return "generic";
+}
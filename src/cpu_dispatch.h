@@ -0,0 +1,31 @@
+/**
+ * cpu_dispatch - 运行时 CPU 特性检测
+ * 预编译包按基线指令集(x64 SSE2 / arm64 NEON)构建;本模块在运行时检测
+ * AVX2 等扩展,供 byte_compare 选择内核,并调用 LzFindPrepare() 让 LZMA
+ * 匹配器在其编译时启用的归一化例程中按 CPU 选择。
+ */
+
+#ifndef HDIFFPATCH_CPU_DISPATCH_H
+#define HDIFFPATCH_CPU_DISPATCH_H
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool sse41 = false;
+    bool avx2 = false;   // 同时要求操作系统保存 YMM 状态
+    bool bmi2 = false;
+    bool neon = false;
+};
+
+// 首次调用时检测,之后返回同一结果(线程安全)
+const CpuFeatures& cpu_features();
+// 进程内只需调用一次(重复调用无副作用):按 CPU 初始化 LZMA 的分派表
+void cpu_dispatch_init();
+// 本 CPU 能运行的最高一档 LZMA 匹配器归一化例程:
+// "avx2" / "sse4.1" / "neon" / "generic",不考虑 lzma 的编译选项。
+const char* lzma_match_finder_cpu_capable();
+// LzFindPrepare 选中的例程。选择结果存放在 LzFind.c 的静态变量中无法读回,
+// 这里按 LzFind.c 启用 USE_LZFIND_SATUR_SUB_128/256 的编译器条件(本文件与
+// lzma 用同一编译器构建)结合 CPU 特性推出同样的结果。
+const char* lzma_match_finder_variant();
+
+#endif
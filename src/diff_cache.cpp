@@ -0,0 +1,577 @@
+#include "diff_cache.h"
+#include "buffer_arena.h"
+#include "diff_checksum.h"
+#include "hdiff.h"
+#include "hpatch.h"
+#include "mapped_file.h"
+#include "xxh64.h"
+#include "../HDiffPatch/libHDiffPatch/HDiff/diff.h"
+#include "../HDiffPatch/file_for_patch.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#   include <direct.h>
+#   include <io.h>
+#   include <process.h>
+#   include <sys/utime.h>
+#   include <windows.h>
+#else
+#   include <dirent.h>
+#   include <unistd.h>
+#   include <utime.h>
+#endif
+
+namespace {
+    // 条目布局: 8 字节魔数 | 8 字节 payload XXH64(小端) | payload(diff 原样字节)
+    const char kEntryMagic[8] = {'H', 'D', 'P', 'C', '0', '0', '0', '1'};
+    const size_t kEntryHeaderSize = 16;
+    const char kEntrySuffix[] = ".hdpc";
+    const char kTempSuffix[] = ".tmp";
+    // 崩溃进程遗留的临时文件超过该时长后在淘汰扫描时清理
+    const time_t kStaleTempSeconds = 60 * 60;
+    const size_t kCopyBufSize = 1024 * 1024;
+
+    std::atomic<uint64_t> g_tempSeq(0);
+
+    struct FileCloser {
+        FILE* file;
+        explicit FileCloser(FILE* f) : file(f) {}
+        ~FileCloser() { if (file) std::fclose(file); }
+        bool close() {
+            FILE* f = file;
+            file = nullptr;
+            return std::fclose(f) == 0;
+        }
+    };
+
+    void putLE64(uint8_t* out, uint64_t v) {
+        for (int i = 0; i < 8; ++i) out[i] = (uint8_t)(v >> (8 * i));
+    }
+
+    uint64_t getLE64(const uint8_t* in) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v |= (uint64_t)in[i] << (8 * i);
+        return v;
+    }
+
+    std::string toHex64(uint64_t v) {
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)v);
+        return buf;
+    }
+
+    bool endsWith(const std::string& s, const char* suffix) {
+        const size_t n = std::strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+
+    std::string joinPath(const std::string& dir, const std::string& name) {
+        if (!dir.empty() && (dir.back() == '/' || dir.back() == '\\')) return dir + name;
+        return dir + "/" + name;
+    }
+
+    bool ensureDir(const std::string& dir) {
+#ifdef _WIN32
+        if (_mkdir(dir.c_str()) == 0) return true;
+#else
+        if (mkdir(dir.c_str(), 0777) == 0) return true;
+#endif
+        if (errno != EEXIST) return false;
+        struct stat st;
+        return (stat(dir.c_str(), &st) == 0) && ((st.st_mode & S_IFMT) == S_IFDIR);
+    }
+
+    void touchFile(const std::string& path) {
+#ifdef _WIN32
+        _utime(path.c_str(), nullptr);
+#else
+        utime(path.c_str(), nullptr);
+#endif
+    }
+
+    bool publishFile(const std::string& tempPath, const std::string& finalPath) {
+#ifdef _WIN32
+        return MoveFileExA(tempPath.c_str(), finalPath.c_str(),
+                           MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return std::rename(tempPath.c_str(), finalPath.c_str()) == 0;
+#endif
+    }
+
+    std::string makeTempPath(const std::string& finalPath) {
+#ifdef _WIN32
+        const unsigned long pid = (unsigned long)_getpid();
+#else
+        const unsigned long pid = (unsigned long)getpid();
+#endif
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), ".%lu-%llu", pid,
+                      (unsigned long long)g_tempSeq.fetch_add(1));
+        return finalPath + buf + kTempSuffix;
+    }
+
+    uint64_t hashFile(const char* path, uint64_t* outSize) {
+        hpatch_TFileStreamInput in;
+        hpatch_TFileStreamInput_init(&in);
+        if (!hpatch_TFileStreamInput_open(&in, path)) {
+            throw std::runtime_error("open file for cache key failed.");
+        }
+        *outSize = in.base.streamSize;
+        try {
+            const uint64_t hash = xxh64_stream(&in.base);
+            hpatch_TFileStreamInput_close(&in);
+            return hash;
+        } catch (...) {
+            hpatch_TFileStreamInput_close(&in);
+            throw;
+        }
+    }
+
+    // 带校验尾部的产物与不带的字节不同,需区分条目
+    std::string withChecksumTag(const std::string& modeTag, bool withChecksum) {
+        return withChecksum ? modeTag + "-xxh64" : modeTag;
+    }
+
+    // 文件名即缓存键: <old 摘要><new 摘要>-<old 长度>-<new 长度>-<模式与参数>
+    std::string makeEntryName(uint64_t oldHash, uint64_t oldSize,
+                              uint64_t newHash, uint64_t newSize,
+                              const std::string& modeTag) {
+        char sizes[48];
+        std::snprintf(sizes, sizeof(sizes), "-%llx-%llx-",
+                      (unsigned long long)oldSize, (unsigned long long)newSize);
+        return toHex64(oldHash) + toHex64(newHash) + sizes + modeTag + kEntrySuffix;
+    }
+
+    bool readEntryHeader(FILE* f, uint64_t* payloadHash) {
+        uint8_t header[kEntryHeaderSize];
+        if (std::fread(header, 1, kEntryHeaderSize, f) != kEntryHeaderSize) return false;
+        if (std::memcmp(header, kEntryMagic, sizeof(kEntryMagic)) != 0) return false;
+        *payloadHash = getLE64(header + sizeof(kEntryMagic));
+        return true;
+    }
+
+    bool loadEntry(const std::string& entryPath, std::vector<uint8_t>& out) {
+        FileCloser in(std::fopen(entryPath.c_str(), "rb"));
+        if (!in.file) return false;
+        uint64_t expectHash = 0;
+        if (!readEntryHeader(in.file, &expectHash)) return false;
+
+        std::vector<uint8_t> payload;
+        std::vector<uint8_t> buf(kCopyBufSize);
+        size_t got;
+        while ((got = std::fread(buf.data(), 1, buf.size(), in.file)) > 0) {
+            payload.insert(payload.end(), buf.begin(), buf.begin() + got);
+        }
+        if (std::ferror(in.file)) return false;
+        if (xxh64(payload.data(), payload.size()) != expectHash) return false;
+        out.swap(payload);
+        return true;
+    }
+
+    // 先拷到 outPath 旁的临时文件,摘要核对通过后才改名为 outPath;
+    // 失败时 outPath 保持原样,由调用方重新生成
+    bool loadEntryToFile(const std::string& entryPath, const char* outPath) {
+        FileCloser in(std::fopen(entryPath.c_str(), "rb"));
+        if (!in.file) return false;
+        uint64_t expectHash = 0;
+        if (!readEntryHeader(in.file, &expectHash)) return false;
+
+        const std::string tempPath = makeTempPath(outPath);
+        bool ok = false;
+        {
+            FileCloser out(std::fopen(tempPath.c_str(), "wb"));
+            if (!out.file) return false;
+            Xxh64State state;
+            xxh64_init(&state);
+            std::vector<uint8_t> buf(kCopyBufSize);
+            size_t got;
+            ok = true;
+            while (ok && (got = std::fread(buf.data(), 1, buf.size(), in.file)) > 0) {
+                xxh64_update(&state, buf.data(), got);
+                ok = std::fwrite(buf.data(), 1, got, out.file) == got;
+            }
+            ok = ok && !std::ferror(in.file);
+            if (!out.close()) ok = false;
+            ok = ok && xxh64_digest(&state) == expectHash;
+        }
+        if (!ok || !publishFile(tempPath, outPath)) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool storeEntry(const std::string& entryPath, const uint8_t* data, size_t size) {
+        const std::string tempPath = makeTempPath(entryPath);
+        {
+            FileCloser out(std::fopen(tempPath.c_str(), "wb"));
+            if (!out.file) return false;
+            uint8_t header[kEntryHeaderSize];
+            std::memcpy(header, kEntryMagic, sizeof(kEntryMagic));
+            putLE64(header + sizeof(kEntryMagic), xxh64(data, size));
+            const bool ok = (std::fwrite(header, 1, kEntryHeaderSize, out.file) == kEntryHeaderSize) &&
+                            (size == 0 || std::fwrite(data, 1, size, out.file) == size);
+            if (!out.close() || !ok) {
+                std::remove(tempPath.c_str());
+                return false;
+            }
+        }
+        if (!publishFile(tempPath, entryPath)) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool storeEntryFromFile(const std::string& entryPath, const char* diffPath) {
+        const std::string tempPath = makeTempPath(entryPath);
+        bool ok = false;
+        {
+            FileCloser in(std::fopen(diffPath, "rb"));
+            FileCloser out(std::fopen(tempPath.c_str(), "wb"));
+            if (in.file && out.file) {
+                // 先写占位头,拷贝 payload 的同时求摘要,最后回填
+                uint8_t header[kEntryHeaderSize] = {0};
+                ok = std::fwrite(header, 1, kEntryHeaderSize, out.file) == kEntryHeaderSize;
+                Xxh64State state;
+                xxh64_init(&state);
+                std::vector<uint8_t> buf(kCopyBufSize);
+                size_t got;
+                while (ok && (got = std::fread(buf.data(), 1, buf.size(), in.file)) > 0) {
+                    xxh64_update(&state, buf.data(), got);
+                    ok = std::fwrite(buf.data(), 1, got, out.file) == got;
+                }
+                ok = ok && !std::ferror(in.file);
+                if (ok) {
+                    std::memcpy(header, kEntryMagic, sizeof(kEntryMagic));
+                    putLE64(header + sizeof(kEntryMagic), xxh64_digest(&state));
+                    ok = (std::fseek(out.file, 0, SEEK_SET) == 0) &&
+                         (std::fwrite(header, 1, kEntryHeaderSize, out.file) == kEntryHeaderSize);
+                }
+            }
+            if (out.file && !out.close()) ok = false;
+        }
+        if (!ok || !publishFile(tempPath, entryPath)) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    struct EntryStat {
+        std::string path;
+        uint64_t size;
+        time_t mtime;
+    };
+
+    void listDir(const std::string& dir, std::vector<EntryStat>& entries,
+                 std::vector<EntryStat>& temps) {
+#ifdef _WIN32
+        struct _finddatai64_t fd;
+        intptr_t h = _findfirsti64(joinPath(dir, "*").c_str(), &fd);
+        if (h == -1) return;
+        do {
+            const std::string name = fd.name;
+            EntryStat st{joinPath(dir, name), (uint64_t)fd.size, (time_t)fd.time_write};
+            if (endsWith(name, kEntrySuffix)) entries.push_back(st);
+            else if (endsWith(name, kTempSuffix)) temps.push_back(st);
+        } while (_findnexti64(h, &fd) == 0);
+        _findclose(h);
+#else
+        DIR* d = opendir(dir.c_str());
+        if (!d) return;
+        while (struct dirent* ent = readdir(d)) {
+            const std::string name = ent->d_name;
+            const bool isEntry = endsWith(name, kEntrySuffix);
+            if (!isEntry && !endsWith(name, kTempSuffix)) continue;
+            EntryStat st{joinPath(dir, name), 0, 0};
+            struct stat sb;
+            if (stat(st.path.c_str(), &sb) != 0) continue;
+            st.size = (uint64_t)sb.st_size;
+            st.mtime = sb.st_mtime;
+            (isEntry ? entries : temps).push_back(st);
+        }
+        closedir(d);
+#endif
+    }
+
+    // 其他进程可能同时淘汰同一条目,删除失败直接忽略
+    void evictOverLimit(const DiffCacheOptions& cache) {
+        std::vector<EntryStat> entries;
+        std::vector<EntryStat> temps;
+        listDir(cache.dir, entries, temps);
+
+        const time_t now = std::time(nullptr);
+        for (const EntryStat& t : temps) {
+            if (now - t.mtime > kStaleTempSeconds) std::remove(t.path.c_str());
+        }
+        if (cache.maxBytes == 0) return;
+
+        uint64_t total = 0;
+        for (const EntryStat& e : entries) total += e.size;
+        if (total <= cache.maxBytes) return;
+
+        std::sort(entries.begin(), entries.end(),
+                  [](const EntryStat& a, const EntryStat& b) { return a.mtime < b.mtime; });
+        for (const EntryStat& e : entries) {
+            if (total <= cache.maxBytes) break;
+            if (std::remove(e.path.c_str()) == 0) total -= e.size;
+        }
+    }
+
+    // arena 以大页提供块时,整文件输入复制进 arena 而不直接使用映射:
+    // 匹配器按后缀数组随机访问 old,页缓存映射只有 4KB 页。多一遍拷贝是否
+    // 划算尚未测量(见 benchmark-arena-diff.js)
+    bool load_into_huge_pages() {
+        const ArenaOptions options = arena_options();
+        return options.enabled && options.hugePages != HugePageMode::Off;
+    }
+
+    // 整个文件的只读视图:优先映射,映射失败(例如 32 位地址空间不足)时读入内存
+    struct WholeFile {
+        MappedFile mapped;
+        PatchBuffer loaded;  // 读入或复制的副本;大文件可由 buffer_arena 提供
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+
+        void open(const char* path, const char* errorMessage) {
+            if (mapped.open(path)) {
+                if (load_into_huge_pages()) {
+                    mapped.advise(MapAdvice::Sequential);
+                    loaded.assign(mapped.data(), mapped.data() + mapped.size());
+                    mapped.close();
+                    data = loaded.data();
+                    size = loaded.size();
+                    return;
+                }
+                // 内存版 diff 会访问整个文件(后缀数组/逐字节匹配),提前异步读入
+                mapped.advise(MapAdvice::WillNeed);
+                data = mapped.data();
+                size = mapped.size();
+                return;
+            }
+            FileCloser in(std::fopen(path, "rb"));
+            if (!in.file) throw std::runtime_error(errorMessage);
+            std::vector<uint8_t> buf(kCopyBufSize);
+            size_t got;
+            while ((got = std::fread(buf.data(), 1, buf.size(), in.file)) > 0) {
+                loaded.insert(loaded.end(), buf.begin(), buf.begin() + got);
+            }
+            if (std::ferror(in.file)) throw std::runtime_error(errorMessage);
+            data = loaded.data();
+            size = loaded.size();
+        }
+    };
+
+    void runFileCached(const DiffCacheOptions& cache,
+                       const char* oldPath, const char* newPath, const char* outDiffPath,
+                       const std::string& modeTag,
+                       const std::function<void()>& runDiff) {
+        if (cache.dir.empty()) {
+            runDiff();
+            return;
+        }
+        if (!oldPath || !newPath || !outDiffPath) {
+            throw std::runtime_error("Invalid file path.");
+        }
+        uint64_t oldSize = 0;
+        uint64_t newSize = 0;
+        const uint64_t oldHash = hashFile(oldPath, &oldSize);
+        const uint64_t newHash = hashFile(newPath, &newSize);
+        const std::string entryPath = joinPath(cache.dir,
+            makeEntryName(oldHash, oldSize, newHash, newSize, modeTag));
+        if (loadEntryToFile(entryPath, outDiffPath)) {
+            touchFile(entryPath);
+            return;
+        }
+
+        runDiff();
+        if (ensureDir(cache.dir) && storeEntryFromFile(entryPath, outDiffPath)) {
+            evictOverLimit(cache);
+        }
+    }
+
+    void runBufferCached(const DiffCacheOptions& cache,
+                         const uint8_t* old, size_t oldsize, const uint8_t* _new, size_t newsize,
+                         std::vector<uint8_t>& out_codeBuf, const std::string& modeTag,
+                         const std::function<void()>& runDiff) {
+        if (cache.dir.empty()) {
+            runDiff();
+            return;
+        }
+        const std::string entryPath = joinPath(cache.dir,
+            makeEntryName(xxh64(old, oldsize), oldsize, xxh64(_new, newsize), newsize, modeTag));
+        if (loadEntry(entryPath, out_codeBuf)) {
+            touchFile(entryPath);
+            return;
+        }
+
+        runDiff();
+        if (ensureDir(cache.dir) &&
+            storeEntry(entryPath, out_codeBuf.data(), out_codeBuf.size())) {
+            evictOverLimit(cache);
+        }
+    }
+
+    std::string windowModeTag(size_t windowSize) {
+        // 0 与显式默认值产物相同,归一后共享同一条目
+        if (windowSize == 0) windowSize = kDefaultWindowOldSize;
+        char modeTag[40];
+        std::snprintf(modeTag, sizeof(modeTag), "window%llx", (unsigned long long)windowSize);
+        return modeTag;
+    }
+}
+
+void hdiff_cached(const DiffCacheOptions& cache,
+                  const uint8_t* old, size_t oldsize, const uint8_t* _new, size_t newsize,
+                  std::vector<uint8_t>& out_codeBuf, size_t compressionThreads,
+                  bool withChecksum, bool trimIdentical, size_t maxIndexMemory) {
+    std::string modeTag = trimIdentical ? "memtrim" : "mem";
+    if (maxIndexMemory != 0) {
+        char idxTag[24];
+        std::snprintf(idxTag, sizeof(idxTag), "idx%llx", (unsigned long long)maxIndexMemory);
+        modeTag += idxTag;
+    }
+    runBufferCached(cache, old, oldsize, _new, newsize, out_codeBuf,
+                    withChecksumTag(modeTag, withChecksum), [&]() {
+        hdiff(old, oldsize, _new, newsize, out_codeBuf, compressionThreads, withChecksum,
+              trimIdentical, maxIndexMemory);
+    });
+}
+
+void hdiff_single_stream_cached(const DiffCacheOptions& cache,
+                                const uint8_t* old, size_t oldsize,
+                                const uint8_t* _new, size_t newsize,
+                                std::vector<uint8_t>& out_codeBuf, size_t compressionThreads,
+                                bool withChecksum) {
+    runBufferCached(cache, old, oldsize, _new, newsize, out_codeBuf,
+                    withChecksumTag("single", withChecksum), [&]() {
+        hdiff_single_stream(old, oldsize, _new, newsize, out_codeBuf, compressionThreads,
+                            withChecksum);
+    });
+}
+
+void hdiff_window_cached(const DiffCacheOptions& cache,
+                         const uint8_t* old, size_t oldsize, const uint8_t* _new, size_t newsize,
+                         std::vector<uint8_t>& out_codeBuf, size_t windowSize,
+                         size_t compressionThreads, bool withChecksum) {
+    runBufferCached(cache, old, oldsize, _new, newsize, out_codeBuf,
+                    withChecksumTag(windowModeTag(windowSize), withChecksum), [&]() {
+        hdiff_window(old, oldsize, _new, newsize, out_codeBuf, windowSize, compressionThreads,
+                     withChecksum);
+    });
+}
+
+namespace {
+    // prevDiff 是否恰好把 old 还原成 _new:总是实际 patch 一遍(线性时间,
+    // 远低于重新匹配)后逐字节比较。校验尾部只用于提前排除,尾部摘要相符
+    // 不代表正文完好,不能据此复用
+    bool diff_reproduces(const uint8_t* old, size_t oldsize, const uint8_t* _new, size_t newsize,
+                         const uint8_t* diff, size_t diffsize, bool withChecksum) {
+        try {
+            const HpatchDiffInfo info = hpatch_diff_info(diff, diffsize);
+            if (info.hasChecksum != withChecksum || info.oldDataSize != oldsize ||
+                info.newDataSize != newsize) {
+                return false;
+            }
+            if (withChecksum) {
+                const DiffChecksum checksum = read_diff_checksum(diff, diffsize);
+                if (checksum.oldHash != xxh64(old, oldsize) ||
+                    checksum.newHash != xxh64(_new, newsize)) {
+                    return false;
+                }
+            }
+            PatchBuffer restored;
+            hpatch(old, oldsize, diff, diffsize, restored);
+            return restored.size() == newsize &&
+                   (newsize == 0 || std::memcmp(restored.data(), _new, newsize) == 0);
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+}
+
+bool hdiff_reuse_cached(const DiffCacheOptions& cache,
+                        const uint8_t* old, size_t oldsize,
+                        const uint8_t* _new, size_t newsize,
+                        const uint8_t* prevDiff, size_t prevDiffSize,
+                        std::vector<uint8_t>& out_codeBuf,
+                        size_t compressionThreads, bool withChecksum,
+                        bool trimIdentical, size_t maxIndexMemory) {
+    if (diff_reproduces(old, oldsize, _new, newsize, prevDiff, prevDiffSize, withChecksum)) {
+        out_codeBuf.assign(prevDiff, prevDiff + prevDiffSize);
+        return true;
+    }
+    hdiff_cached(cache, old, oldsize, _new, newsize, out_codeBuf, compressionThreads,
+                 withChecksum, trimIdentical, maxIndexMemory);
+    return false;
+}
+
+void hdiff_stream_cached(const DiffCacheOptions& cache,
+                         const char* oldPath, const char* newPath, const char* outDiffPath,
+                         size_t compressionThreads, bool withChecksum,
+                         const FileIoOptions& io) {
+    runFileCached(cache, oldPath, newPath, outDiffPath,
+                  withChecksumTag("stream", withChecksum), [&]() {
+        hdiff_stream(oldPath, newPath, outDiffPath, compressionThreads, withChecksum, io);
+    });
+}
+
+void hdiff_single_stream_cached(const DiffCacheOptions& cache,
+                                const char* oldPath, const char* newPath, const char* outDiffPath,
+                                size_t compressionThreads, bool withChecksum,
+                                const FileIoOptions& io) {
+    runFileCached(cache, oldPath, newPath, outDiffPath,
+                  withChecksumTag("single", withChecksum), [&]() {
+        hdiff_single_stream(oldPath, newPath, outDiffPath, compressionThreads, withChecksum,
+                            io);
+    });
+}
+
+void hdiff_window_cached(const DiffCacheOptions& cache,
+                         const char* oldPath, const char* newPath, const char* outDiffPath,
+                         size_t windowSize, size_t compressionThreads,
+                         bool withChecksum, const FileIoOptions& io) {
+    runFileCached(cache, oldPath, newPath, outDiffPath,
+                  withChecksumTag(windowModeTag(windowSize), withChecksum), [&]() {
+        hdiff_window(oldPath, newPath, outDiffPath, windowSize, compressionThreads,
+                     withChecksum, io);
+    });
+}
+
+void hdiff_file_cached(const DiffCacheOptions& cache,
+                       const char* oldPath, const char* newPath, const char* outDiffPath,
+                       size_t compressionThreads, bool withChecksum,
+                       bool trimIdentical, size_t maxIndexMemory) {
+    if (!oldPath || !newPath || !outDiffPath) {
+        throw std::runtime_error("Invalid file path.");
+    }
+    WholeFile oldFile;
+    WholeFile newFile;
+    oldFile.open(oldPath, "open old file failed.");
+    newFile.open(newPath, "open new file failed.");
+
+    std::vector<uint8_t> codeBuf;
+    hdiff_cached(cache, oldFile.data, oldFile.size, newFile.data, newFile.size, codeBuf,
+                 compressionThreads, withChecksum, trimIdentical, maxIndexMemory);
+
+    FileCloser out(std::fopen(outDiffPath, "wb"));
+    if (!out.file) {
+        throw std::runtime_error("open diff file for write failed.");
+    }
+    if (!codeBuf.empty() &&
+        std::fwrite(codeBuf.data(), 1, codeBuf.size(), out.file) != codeBuf.size()) {
+        throw std::runtime_error("write diff file failed.");
+    }
+    if (!out.close()) {
+        throw std::runtime_error("close diff file failed.");
+    }
+}
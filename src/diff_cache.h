@@ -0,0 +1,69 @@
+/**
+ * diff_cache - 内容寻址的磁盘 patch 缓存
+ * 键由 old/new 内容的 XXH64 与影响产物字节的参数组成;条目先写临时文件再
+ * rename 发布,多个进程可共享同一缓存目录。总字节超过上限时按最近使用
+ * 时间(文件 mtime,命中时刷新)淘汰最旧条目。
+ * 缓存读写失败一律按未命中/放弃写入处理,不影响 diff 本身的结果。
+ */
+
+#ifndef HDIFFPATCH_DIFF_CACHE_H
+#define HDIFFPATCH_DIFF_CACHE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "file_stream.h"
+
+struct DiffCacheOptions {
+    std::string dir;        // 为空表示不启用缓存;目录不存在时自动创建(仅末级)
+    uint64_t maxBytes = 0;  // 缓存目录条目总字节上限,0 表示不限制
+};
+
+// 与 hdiff.h 中同名函数语义一致;cache.dir 为空时直接转发。
+// compressionThreads 不影响产物字节(1/2 线程输出相同),io 只影响读写方式,均不参与缓存键。
+void hdiff_cached(const DiffCacheOptions& cache,
+                  const uint8_t* old,size_t oldsize,const uint8_t* _new,size_t newsize,
+                  std::vector<uint8_t>& out_codeBuf,size_t compressionThreads=1,
+                  bool withChecksum=false,bool trimIdentical=false,
+                  size_t maxIndexMemory=0);
+void hdiff_stream_cached(const DiffCacheOptions& cache,
+                         const char* oldPath,const char* newPath,const char* outDiffPath,
+                         size_t compressionThreads=1,bool withChecksum=false,
+                         const FileIoOptions& io=FileIoOptions());
+void hdiff_single_stream_cached(const DiffCacheOptions& cache,
+                                const char* oldPath,const char* newPath,const char* outDiffPath,
+                                size_t compressionThreads=1,bool withChecksum=false,
+                                const FileIoOptions& io=FileIoOptions());
+void hdiff_window_cached(const DiffCacheOptions& cache,
+                         const char* oldPath,const char* newPath,const char* outDiffPath,
+                         size_t windowSize=0,size_t compressionThreads=1,
+                         bool withChecksum=false,
+                         const FileIoOptions& io=FileIoOptions());
+// 内存版 single/window 引擎:与文件版产物字节相同,共享缓存条目
+void hdiff_single_stream_cached(const DiffCacheOptions& cache,
+                                const uint8_t* old,size_t oldsize,
+                                const uint8_t* _new,size_t newsize,
+                                std::vector<uint8_t>& out_codeBuf,
+                                size_t compressionThreads=1,bool withChecksum=false);
+void hdiff_window_cached(const DiffCacheOptions& cache,
+                         const uint8_t* old,size_t oldsize,const uint8_t* _new,size_t newsize,
+                         std::vector<uint8_t>& out_codeBuf,size_t windowSize=0,
+                         size_t compressionThreads=1,bool withChecksum=false);
+// prevDiff 仍能把 old 还原成 _new(checksum 设置也一致)时原样复用并返回 true,
+// 否则按 hdiff_cached 重新生成并返回 false。检查不运行匹配器:带校验尾部时
+// 比对摘要,否则 patch 一遍后比较。prevDiff 无法解析按不可复用处理。
+bool hdiff_reuse_cached(const DiffCacheOptions& cache,
+                        const uint8_t* old,size_t oldsize,const uint8_t* _new,size_t newsize,
+                        const uint8_t* prevDiff,size_t prevDiffSize,
+                        std::vector<uint8_t>& out_codeBuf,
+                        size_t compressionThreads=1,
+                        bool withChecksum=false,bool trimIdentical=false,
+                        size_t maxIndexMemory=0);
+// 内存版 hdiff() 直接作用于只读映射的 old/new 文件(映射失败时读入内存),
+// 产物写到 outDiffPath;与 hdiff_cached 字节相同并共享缓存条目。
+void hdiff_file_cached(const DiffCacheOptions& cache,
+                       const char* oldPath,const char* newPath,const char* outDiffPath,
+                       size_t compressionThreads=1,bool withChecksum=false,
+                       bool trimIdentical=false,size_t maxIndexMemory=0);
+
+#endif
@@ -0,0 +1,156 @@
+#include "diff_checksum.h"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    const char kTrailerMagic[8] = {'H', 'D', 'P', 'X', 'X', 'H', '6', '4'};
+    const size_t kTrailerSize = 8 + 8 + sizeof(kTrailerMagic);
+    const size_t kHashBufSize = 1024 * 1024;
+
+    void putLE64(uint8_t* out, uint64_t v) {
+        for (int i = 0; i < 8; ++i) out[i] = (uint8_t)(v >> (8 * i));
+    }
+
+    uint64_t getLE64(const uint8_t* in) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v |= (uint64_t)in[i] << (8 * i);
+        return v;
+    }
+
+    void makeTrailer(uint8_t* trailer, uint64_t oldHash, uint64_t newHash) {
+        putLE64(trailer, oldHash);
+        putLE64(trailer + 8, newHash);
+        std::memcpy(trailer + 16, kTrailerMagic, sizeof(kTrailerMagic));
+    }
+
+    DiffChecksum parseTrailer(const uint8_t* trailer, hpatch_StreamPos_t diffSize) {
+        DiffChecksum checksum;
+        checksum.payloadSize = diffSize;
+        if (std::memcmp(trailer + 16, kTrailerMagic, sizeof(kTrailerMagic)) != 0) {
+            return checksum;
+        }
+        checksum.present = true;
+        checksum.oldHash = getLE64(trailer);
+        checksum.newHash = getLE64(trailer + 8);
+        checksum.payloadSize = diffSize - kTrailerSize;
+        return checksum;
+    }
+
+    bool hashStreamOutput(const hpatch_TStreamOutput* stream, hpatch_StreamPos_t size,
+                          uint64_t* out_hash) {
+        Xxh64State state;
+        xxh64_init(&state);
+        std::vector<uint8_t> buf(kHashBufSize);
+        for (hpatch_StreamPos_t pos = 0; pos < size;) {
+            hpatch_StreamPos_t len = size - pos;
+            if (len > (hpatch_StreamPos_t)buf.size()) len = (hpatch_StreamPos_t)buf.size();
+            if (!stream->read_writed(stream, pos, buf.data(), buf.data() + (size_t)len)) {
+                return false;
+            }
+            xxh64_update(&state, buf.data(), (size_t)len);
+            pos += len;
+        }
+        *out_hash = xxh64_digest(&state);
+        return true;
+    }
+}
+
+uint64_t xxh64_stream(const hpatch_TStreamInput* stream) {
+    Xxh64State state;
+    xxh64_init(&state);
+    std::vector<uint8_t> buf(kHashBufSize);
+    for (hpatch_StreamPos_t pos = 0; pos < stream->streamSize;) {
+        hpatch_StreamPos_t len = stream->streamSize - pos;
+        if (len > (hpatch_StreamPos_t)buf.size()) len = (hpatch_StreamPos_t)buf.size();
+        if (!stream->read(stream, pos, buf.data(), buf.data() + (size_t)len)) {
+            throw std::runtime_error("read stream for checksum failed.");
+        }
+        xxh64_update(&state, buf.data(), (size_t)len);
+        pos += len;
+    }
+    return xxh64_digest(&state);
+}
+
+void append_diff_checksum(std::vector<uint8_t>& diff, uint64_t oldHash, uint64_t newHash) {
+    uint8_t trailer[kTrailerSize];
+    makeTrailer(trailer, oldHash, newHash);
+    diff.insert(diff.end(), trailer, trailer + kTrailerSize);
+}
+
+void append_diff_checksum(const char* diffPath, uint64_t oldHash, uint64_t newHash) {
+    uint8_t trailer[kTrailerSize];
+    makeTrailer(trailer, oldHash, newHash);
+    FILE* f = std::fopen(diffPath, "ab");
+    if (!f) {
+        throw std::runtime_error("open diff file for checksum failed.");
+    }
+    const bool writeOk = std::fwrite(trailer, 1, kTrailerSize, f) == kTrailerSize;
+    if ((std::fclose(f) != 0) || !writeOk) {
+        throw std::runtime_error("write diff checksum failed.");
+    }
+}
+
+DiffChecksum read_diff_checksum(const uint8_t* diff, size_t diffSize) {
+    if (diffSize < kTrailerSize) {
+        DiffChecksum checksum;
+        checksum.payloadSize = diffSize;
+        return checksum;
+    }
+    return parseTrailer(diff + diffSize - kTrailerSize, diffSize);
+}
+
+DiffChecksum read_diff_checksum(const hpatch_TStreamInput* diff) {
+    uint8_t trailer[kTrailerSize];
+    if ((diff->streamSize < kTrailerSize) ||
+        !diff->read(diff, diff->streamSize - kTrailerSize, trailer, trailer + kTrailerSize)) {
+        DiffChecksum checksum;
+        checksum.payloadSize = diff->streamSize;
+        return checksum;
+    }
+    return parseTrailer(trailer, diff->streamSize);
+}
+
+HashingStreamOutput::HashingStreamOutput(const hpatch_TStreamOutput* target)
+    : target_(target) {
+    base.streamImport = this;
+    base.streamSize = target->streamSize;
+    base.read_writed = read_writed;
+    base.write = write;
+    xxh64_init(&state_);
+}
+
+bool HashingStreamOutput::digest(uint64_t* out_hash) const {
+    if (sequential_) {
+        *out_hash = xxh64_digest(&state_);
+        return true;
+    }
+    return hashStreamOutput(target_, writtenEnd_, out_hash);
+}
+
+hpatch_BOOL HashingStreamOutput::read_writed(const hpatch_TStreamOutput* stream,
+                                             hpatch_StreamPos_t readFromPos,
+                                             unsigned char* out_data, unsigned char* out_data_end) {
+    const HashingStreamOutput* self = (const HashingStreamOutput*)stream->streamImport;
+    return self->target_->read_writed(self->target_, readFromPos, out_data, out_data_end);
+}
+
+hpatch_BOOL HashingStreamOutput::write(const hpatch_TStreamOutput* stream,
+                                       hpatch_StreamPos_t writeToPos,
+                                       const unsigned char* data, const unsigned char* data_end) {
+    HashingStreamOutput* self = (HashingStreamOutput*)stream->streamImport;
+    if (!self->target_->write(self->target_, writeToPos, data, data_end)) {
+        return hpatch_FALSE;
+    }
+    const hpatch_StreamPos_t end = writeToPos + (hpatch_StreamPos_t)(data_end - data);
+    if (end > self->writtenEnd_) self->writtenEnd_ = end;
+    if (self->sequential_) {
+        if (writeToPos == self->hashedSize_) {
+            xxh64_update(&self->state_, data, (size_t)(data_end - data));
+            self->hashedSize_ = end;
+        } else {
+            self->sequential_ = false;
+        }
+    }
+    return hpatch_TRUE;
+}
@@ -0,0 +1,55 @@
+/**
+ * diff_checksum - diff 文件尾部可选的 old/new 校验和
+ * 布局: <原 diff 字节> | old XXH64(8 字节小端) | new XXH64(8 字节小端) | "HDPXXH64"
+ * 文件头不变;应用端先校验 old(基准不符时在写出任何数据前拒绝),
+ * 再在写出 new 的同时求摘要,省去事后重读结果文件的一整遍 I/O。
+ */
+
+#ifndef HDIFFPATCH_DIFF_CHECKSUM_H
+#define HDIFFPATCH_DIFF_CHECKSUM_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "xxh64.h"
+#include "../HDiffPatch/libHDiffPatch/HPatch/patch_types.h"
+
+struct DiffChecksum {
+    bool present = false;
+    uint64_t oldHash = 0;
+    uint64_t newHash = 0;
+    hpatch_StreamPos_t payloadSize = 0;  // 去掉尾部后的原 diff 长度
+};
+
+uint64_t xxh64_stream(const hpatch_TStreamInput* stream);
+
+void append_diff_checksum(std::vector<uint8_t>& diff, uint64_t oldHash, uint64_t newHash);
+void append_diff_checksum(const char* diffPath, uint64_t oldHash, uint64_t newHash);
+
+// 没有尾部时 present=false 且 payloadSize 为整个 diff 长度
+DiffChecksum read_diff_checksum(const uint8_t* diff, size_t diffSize);
+DiffChecksum read_diff_checksum(const hpatch_TStreamInput* diff);
+
+// 把写入转发给 target,顺序写入时顺带累计 XXH64;出现非顺序写入时
+// digest() 退回为从 target 重读已写出的数据,重读失败返回 false。
+struct HashingStreamOutput {
+    hpatch_TStreamOutput base;
+
+    explicit HashingStreamOutput(const hpatch_TStreamOutput* target);
+    HashingStreamOutput(const HashingStreamOutput&) = delete;
+    HashingStreamOutput& operator=(const HashingStreamOutput&) = delete;
+    bool digest(uint64_t* out_hash) const;
+
+private:
+    static hpatch_BOOL read_writed(const hpatch_TStreamOutput* stream, hpatch_StreamPos_t readFromPos,
+                                   unsigned char* out_data, unsigned char* out_data_end);
+    static hpatch_BOOL write(const hpatch_TStreamOutput* stream, hpatch_StreamPos_t writeToPos,
+                             const unsigned char* data, const unsigned char* data_end);
+
+    const hpatch_TStreamOutput* target_;
+    Xxh64State state_;
+    hpatch_StreamPos_t hashedSize_ = 0;
+    hpatch_StreamPos_t writtenEnd_ = 0;
+    bool sequential_ = true;
+};
+
+#endif
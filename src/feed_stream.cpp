@@ -0,0 +1,121 @@
+#include "feed_stream.h"
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+bool StreamFeed::advance(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bytes > size_ - available_) {
+        aborted_ = true;
+        cond_.notify_all();
+        return false;
+    }
+    available_ += bytes;
+    cond_.notify_all();
+    return true;
+}
+
+void StreamFeed::end() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ended_ = true;
+    cond_.notify_all();
+}
+
+void StreamFeed::abort() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    aborted_ = true;
+    cond_.notify_all();
+}
+
+bool StreamFeed::waitFor(uint64_t end) {
+    if (end > size_) return false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&] { return aborted_ || ended_ || available_ >= end; });
+    return !aborted_ && available_ >= end;
+}
+
+FeedInputStream::FeedInputStream() : base() {}
+
+FeedInputStream::~FeedInputStream() {
+    close();
+}
+
+bool FeedInputStream::open(const char* spoolPath, std::shared_ptr<StreamFeed> feed) {
+    if (opened_ || !feed) return false;
+#ifdef _WIN32
+    // 写入方(Node 的 fs)仍持有该文件,必须允许共享写
+    HANDLE file = CreateFileA(spoolPath, GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    handle_ = file;
+#else
+    const int fd = ::open(spoolPath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    fd_ = fd;
+#endif
+    feed_ = std::move(feed);
+    base = hpatch_TStreamInput();
+    base.streamImport = this;
+    base.streamSize = feed_->size();
+    base.read = read;
+    opened_ = true;
+    return true;
+}
+
+bool FeedInputStream::close() {
+    if (!opened_) return true;
+    opened_ = false;
+    base = hpatch_TStreamInput();
+    feed_.reset();
+#ifdef _WIN32
+    const bool ok = CloseHandle((HANDLE)handle_) != 0;
+    handle_ = nullptr;
+#else
+    const bool ok = (::close(fd_) == 0);
+    fd_ = -1;
+#endif
+    return ok;
+}
+
+hpatch_BOOL FeedInputStream::read(const hpatch_TStreamInput* stream,
+                                  hpatch_StreamPos_t readFromPos,
+                                  unsigned char* out_data, unsigned char* out_data_end) {
+    FeedInputStream* self = (FeedInputStream*)stream->streamImport;
+    const hpatch_StreamPos_t size = (hpatch_StreamPos_t)(out_data_end - out_data);
+    if (readFromPos > stream->streamSize || size > stream->streamSize - readFromPos) {
+        return hpatch_FALSE;
+    }
+    if (!self->feed_->waitFor(readFromPos + size)) return hpatch_FALSE;
+    while (out_data < out_data_end) {
+#ifdef _WIN32
+        const size_t want = (size_t)(out_data_end - out_data);
+        const DWORD chunk = want > (size_t)(1u << 30) ? (DWORD)(1u << 30) : (DWORD)want;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)readFromPos;
+        overlapped.OffsetHigh = (DWORD)(readFromPos >> 32);
+        DWORD got = 0;
+        if (!ReadFile((HANDLE)self->handle_, out_data, chunk, &got, &overlapped) || got == 0) {
+            return hpatch_FALSE;
+        }
+        const size_t n = got;
+#else
+        const ssize_t got = ::pread(self->fd_, out_data, (size_t)(out_data_end - out_data),
+                                    (off_t)readFromPos);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return hpatch_FALSE;
+        }
+        if (got == 0) return hpatch_FALSE;
+        const size_t n = (size_t)got;
+#endif
+        out_data += n;
+        readFromPos += n;
+    }
+    return hpatch_TRUE;
+}
@@ -0,0 +1,69 @@
+/**
+ * feed_stream - 边生成边 diff 的 new 输入
+ * JS 把 Readable 的数据按顺序写入 spool 文件,每写完一块调用 StreamFeed::advance();
+ * diff 在工作线程中经 FeedInputStream 读取,读到尚未写入的位置时阻塞等待。
+ * 已写入的部分可以随机重读:匹配器会小幅回看,生成后的校验与 XXH64 摘要
+ * 也会从头重读 new,这些都由 spool 文件(通常仍在页缓存中)提供。
+ * new 的总长度必须事先给出:diff 头部与匹配器都需要 streamSize。
+ */
+
+#ifndef HDIFFPATCH_FEED_STREAM_H
+#define HDIFFPATCH_FEED_STREAM_H
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include "../HDiffPatch/libHDiffPatch/HPatch/patch_types.h"
+
+// 写入进度,JS 线程推进、工作线程等待
+class StreamFeed {
+public:
+    explicit StreamFeed(uint64_t size) : size_(size) {}
+
+    uint64_t size() const { return size_; }
+    // 又有 bytes 字节写入 spool;累计超过 size 时中止并返回 false
+    bool advance(uint64_t bytes);
+    // 输入结束;此时不足 size 的读取随即失败
+    void end();
+    // 输入出错或调用方放弃,唤醒并让所有等待中的读取失败
+    void abort();
+    // 等到 [0, end) 全部写入;输入提前结束或被中止时返回 false
+    bool waitFor(uint64_t end);
+
+private:
+    const uint64_t size_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    uint64_t available_ = 0;
+    bool ended_ = false;
+    bool aborted_ = false;
+};
+
+class FeedInputStream {
+public:
+    hpatch_TStreamInput base;
+
+    FeedInputStream();
+    ~FeedInputStream();
+    FeedInputStream(const FeedInputStream&) = delete;
+    FeedInputStream& operator=(const FeedInputStream&) = delete;
+
+    // spool 文件须已由写入方创建;streamSize 取 feed->size()
+    bool open(const char* spoolPath, std::shared_ptr<StreamFeed> feed);
+    bool close();
+
+private:
+    static hpatch_BOOL read(const hpatch_TStreamInput* stream, hpatch_StreamPos_t readFromPos,
+                            unsigned char* out_data, unsigned char* out_data_end);
+
+    std::shared_ptr<StreamFeed> feed_;
+#ifdef _WIN32
+    void* handle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    bool opened_ = false;
+};
+
+#endif
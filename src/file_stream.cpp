@@ -0,0 +1,418 @@
+#include "file_stream.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#   define HDP_FILE_STREAM_POSIX 1
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace {
+    // 顺序流在读写位置之后保留的页数:少量回退读(例如重读刚写过的头)仍命中缓存
+    const hpatch_StreamPos_t kDropBehindLag = 4 * 1024 * 1024;
+
+#if HDP_FILE_STREAM_POSIX
+    void file_advise(int fd, hpatch_StreamPos_t pos, hpatch_StreamPos_t len, int advice) {
+#   if defined(POSIX_FADV_NORMAL)
+        // 仅为提示,失败不影响正确性
+        (void)posix_fadvise(fd, (off_t)pos, (off_t)len, advice);
+#   else
+        (void)fd; (void)pos; (void)len; (void)advice;
+#   endif
+    }
+
+    bool pread_all(int fd, hpatch_StreamPos_t pos, unsigned char* out, unsigned char* out_end) {
+        while (out < out_end) {
+            const ssize_t n = ::pread(fd, out, (size_t)(out_end - out), (off_t)pos);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (n == 0) return false;
+            out += n;
+            pos += (hpatch_StreamPos_t)n;
+        }
+        return true;
+    }
+
+    bool pwrite_all(int fd, hpatch_StreamPos_t pos, const unsigned char* data, size_t size) {
+        while (size > 0) {
+            const ssize_t n = ::pwrite(fd, data, size, (off_t)pos);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            size -= (size_t)n;
+            pos += (hpatch_StreamPos_t)n;
+        }
+        return true;
+    }
+#endif
+
+    hpatch_BOOL read_mapped(const hpatch_TStreamInput* stream, hpatch_StreamPos_t readFromPos,
+                            unsigned char* out_data, unsigned char* out_data_end) {
+        const MappedFile* mapped = (const MappedFile*)stream->streamImport;
+        const size_t size = (size_t)(out_data_end - out_data);
+        if (readFromPos > mapped->size() || size > mapped->size() - readFromPos) {
+            return hpatch_FALSE;
+        }
+        if (size > 0) std::memcpy(out_data, mapped->data() + readFromPos, size);
+        return hpatch_TRUE;
+    }
+}
+
+#if HDP_FILE_STREAM_POSIX
+// pread + 内核预读提示:顺序访问时提前 WILLNEED 一个窗口(bufferSize × queueDepth),
+// 内核异步把后续数据读进页缓存,与 patch/diff 的计算重叠。
+struct FileInputStream::Posix {
+    int fd = -1;
+    bool sequential = false;
+    bool dropBehind = false;
+    hpatch_StreamPos_t window = 0;
+    hpatch_StreamPos_t lastEnd = 0;
+    hpatch_StreamPos_t adviseEnd = 0;  // 已提示预读到的位置
+    hpatch_StreamPos_t droppedTo = 0;  // 已丢弃页缓存到的位置
+
+    void readAhead(hpatch_StreamPos_t pos, hpatch_StreamPos_t end, hpatch_StreamPos_t size) {
+        // 剩余预读量不足半个窗口时再推进一个窗口,减少系统调用次数
+        if (adviseEnd < pos) adviseEnd = pos;
+        if (adviseEnd >= size || adviseEnd >= end + window / 2) return;
+        const hpatch_StreamPos_t next = std::min(size, std::max(adviseEnd, end) + window);
+        file_advise(fd, adviseEnd, next - adviseEnd, POSIX_FADV_WILLNEED);
+        adviseEnd = next;
+    }
+
+    void drop(hpatch_StreamPos_t pos) {
+        if (pos < droppedTo + window + kDropBehindLag) return;
+        const hpatch_StreamPos_t to = pos - kDropBehindLag;
+        file_advise(fd, droppedTo, to - droppedTo, POSIX_FADV_DONTNEED);
+        droppedTo = to;
+    }
+
+    static hpatch_BOOL read(const hpatch_TStreamInput* stream, hpatch_StreamPos_t readFromPos,
+                            unsigned char* out_data, unsigned char* out_data_end) {
+        Posix* self = (Posix*)stream->streamImport;
+        const hpatch_StreamPos_t size = (hpatch_StreamPos_t)(out_data_end - out_data);
+        if (readFromPos > stream->streamSize || size > stream->streamSize - readFromPos) {
+            return hpatch_FALSE;
+        }
+        const hpatch_StreamPos_t end = readFromPos + size;
+        if (self->sequential) {
+            self->readAhead(readFromPos, end, stream->streamSize);
+        }
+        if (!pread_all(self->fd, readFromPos, out_data, out_data_end)) return hpatch_FALSE;
+        // 只在前进式读取时丢弃;向回跳读(例如重读文件头)说明调用方还会用到旧页
+        if (self->sequential && self->dropBehind && readFromPos >= self->lastEnd) {
+            self->drop(readFromPos);
+        }
+        self->lastEnd = end;
+        return hpatch_TRUE;
+    }
+};
+
+// 写后台化:调用线程只做内存拷贝,满 bufferSize 的块交给写线程 pwrite;
+// 最多 queueDepth 个块在途,超出时调用线程等待(背压)。
+// Linux 上每写完一块即 sync_file_range(WRITE) 触发异步回写,
+// 并等待上一块落盘后 DONTNEED,避免 GB 级输出把页缓存挤满脏页。
+struct FileOutputStream::Posix {
+    struct Block {
+        hpatch_StreamPos_t pos = 0;
+        std::vector<unsigned char> data;
+    };
+
+    int fd = -1;
+    size_t bufferSize = 0;
+    size_t queueDepth = 0;
+    bool dropBehind = false;
+    hpatch_StreamPos_t outLength = 0;  // 已写出的最大结束位置
+
+    Block current;                      // 调用线程正在填充的块
+    std::vector<std::vector<unsigned char>> freeBuffers;
+    std::deque<Block> queue;
+    size_t inFlight = 0;                // 写线程已取出尚未完成的块数
+    bool stopping = false;
+    bool failed = false;
+    std::mutex mutex;
+    std::condition_variable wake;       // 通知写线程有新块
+    std::condition_variable done;       // 通知调用线程有块完成
+    std::thread writer;
+
+    // 写线程回写/丢弃页缓存的进度
+    hpatch_StreamPos_t syncedPos = 0;
+    hpatch_StreamPos_t syncedEnd = 0;
+    bool hasSynced = false;
+
+    void start() {
+        writer = std::thread([this] { run(); });
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            Block block = std::move(queue.front());
+            queue.pop_front();
+            ++inFlight;
+            lock.unlock();
+
+            bool ok = pwrite_all(fd, block.pos, block.data.data(), block.data.size());
+            if (ok) writeBehind(block.pos, block.data.size());
+
+            lock.lock();
+            if (!ok) failed = true;
+            block.data.clear();
+            freeBuffers.push_back(std::move(block.data));
+            --inFlight;
+            done.notify_all();
+        }
+    }
+
+    void writeBehind(hpatch_StreamPos_t pos, size_t size) {
+#if defined(__linux__) && defined(SYNC_FILE_RANGE_WRITE)
+        (void)sync_file_range(fd, (off_t)pos, (off_t)size, SYNC_FILE_RANGE_WRITE);
+        if (dropBehind && hasSynced) {
+            (void)sync_file_range(fd, (off_t)syncedPos, (off_t)(syncedEnd - syncedPos),
+                                  SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                                  SYNC_FILE_RANGE_WAIT_AFTER);
+            file_advise(fd, syncedPos, syncedEnd - syncedPos, POSIX_FADV_DONTNEED);
+        }
+        syncedPos = pos;
+        syncedEnd = pos + size;
+        hasSynced = true;
+#else
+        (void)pos; (void)size;
+#endif
+    }
+
+    // 把 current 交给写线程;在途块已满 queueDepth 时等待
+    bool submit() {
+        if (current.data.empty()) return true;
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return failed || queue.size() + inFlight < queueDepth; });
+        if (failed) return false;
+        queue.push_back(std::move(current));
+        current = Block();
+        if (!freeBuffers.empty()) {
+            current.data = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+        wake.notify_one();
+        return true;
+    }
+
+    // 等待全部在途块写完
+    bool drain() {
+        if (!submit()) return false;
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return failed || (queue.empty() && inFlight == 0); });
+        return !failed;
+    }
+
+    bool stop() {
+        const bool ok = drain();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (writer.joinable()) writer.join();
+        return ok;
+    }
+
+    static hpatch_BOOL write(const hpatch_TStreamOutput* stream, hpatch_StreamPos_t writeToPos,
+                             const unsigned char* data, const unsigned char* data_end) {
+        Posix* self = (Posix*)stream->streamImport;
+        size_t size = (size_t)(data_end - data);
+        if (writeToPos > stream->streamSize || size > stream->streamSize - writeToPos) {
+            return hpatch_FALSE;
+        }
+        // 与当前块不相接的写(例如 diff 生成回写文件头)先提交当前块,从新位置开块
+        if (!self->current.data.empty() &&
+            writeToPos != self->current.pos + self->current.data.size()) {
+            if (!self->submit()) return hpatch_FALSE;
+        }
+        while (size > 0) {
+            if (self->current.data.empty()) {
+                self->current.pos = writeToPos;
+                self->current.data.reserve(self->bufferSize);
+            }
+            const size_t room = self->bufferSize - self->current.data.size();
+            const size_t n = std::min(room, size);
+            self->current.data.insert(self->current.data.end(), data, data + n);
+            data += n;
+            size -= n;
+            writeToPos += n;
+            if (self->current.data.size() == self->bufferSize && !self->submit()) {
+                return hpatch_FALSE;
+            }
+        }
+        if (writeToPos > self->outLength) self->outLength = writeToPos;
+        return hpatch_TRUE;
+    }
+
+    static hpatch_BOOL read_writed(const hpatch_TStreamOutput* stream,
+                                   hpatch_StreamPos_t readFromPos,
+                                   unsigned char* out_data, unsigned char* out_data_end) {
+        Posix* self = (Posix*)stream->streamImport;
+        const hpatch_StreamPos_t size = (hpatch_StreamPos_t)(out_data_end - out_data);
+        if (readFromPos > self->outLength || size > self->outLength - readFromPos) {
+            return hpatch_FALSE;
+        }
+        if (!self->drain()) return hpatch_FALSE;
+        return pread_all(self->fd, readFromPos, out_data, out_data_end) ? hpatch_TRUE : hpatch_FALSE;
+    }
+};
+#else
+struct FileInputStream::Posix {};
+struct FileOutputStream::Posix {};
+#endif
+
+FileInputStream::FileInputStream() : base() {
+    hpatch_TFileStreamInput_init(&file_);
+}
+
+FileInputStream::~FileInputStream() {
+    close();
+}
+
+bool FileInputStream::open(const char* path, const FileIoOptions& io, FileAccess access) {
+    if (opened_) return false;
+    if (io.mmap) {
+        std::unique_ptr<MappedFile> mapped(new MappedFile());
+        if (mapped->open(path)) {
+            mapped->advise(access == FileAccess::Sequential ? MapAdvice::Sequential
+                                                            : MapAdvice::Random);
+            mapped_ = std::move(mapped);
+            base = hpatch_TStreamInput();
+            base.streamImport = mapped_.get();
+            base.streamSize = mapped_->size();
+            base.read = read_mapped;
+            opened_ = true;
+            return true;
+        }
+    }
+#if HDP_FILE_STREAM_POSIX
+    if (io.enabled()) {
+        const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        posix_.reset(new Posix());
+        posix_->fd = fd;
+        posix_->sequential = (access == FileAccess::Sequential);
+        posix_->dropBehind = posix_->sequential && io.dropBehind;
+        posix_->window = (hpatch_StreamPos_t)io.bufferSize *
+                         (io.queueDepth ? io.queueDepth : kDefaultIoQueueDepth);
+        file_advise(fd, 0, 0, posix_->sequential ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_RANDOM);
+        base = hpatch_TStreamInput();
+        base.streamImport = posix_.get();
+        base.streamSize = (hpatch_StreamPos_t)st.st_size;
+        base.read = Posix::read;
+        opened_ = true;
+        return true;
+    }
+#else
+    (void)io; (void)access;
+#endif
+    if (!hpatch_TFileStreamInput_open(&file_, path)) return false;
+    base = file_.base;
+    opened_ = true;
+    return true;
+}
+
+bool FileInputStream::close() {
+    if (!opened_) return true;
+    opened_ = false;
+    base = hpatch_TStreamInput();
+    if (mapped_) {
+        mapped_.reset();
+        return true;
+    }
+#if HDP_FILE_STREAM_POSIX
+    if (posix_) {
+        const bool ok = (::close(posix_->fd) == 0);
+        posix_.reset();
+        return ok;
+    }
+#endif
+    return hpatch_TFileStreamInput_close(&file_) != hpatch_FALSE;
+}
+
+FileOutputStream::FileOutputStream() : base() {
+    hpatch_TFileStreamOutput_init(&file_);
+}
+
+FileOutputStream::~FileOutputStream() {
+    close();
+}
+
+bool FileOutputStream::open(const char* path, hpatch_StreamPos_t maxSize, const FileIoOptions& io) {
+    if (opened_) return false;
+#if HDP_FILE_STREAM_POSIX
+    if (io.enabled()) {
+        // O_RDWR:read_writed 需要读回已写出的数据(例如 checksum 求摘要)
+        const int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (fd < 0) return false;
+        posix_.reset(new Posix());
+        posix_->fd = fd;
+        posix_->bufferSize = io.bufferSize;
+        posix_->queueDepth = io.queueDepth ? io.queueDepth : kDefaultIoQueueDepth;
+        posix_->dropBehind = io.dropBehind;
+        try {
+            posix_->start();
+        } catch (...) {
+            ::close(fd);
+            posix_.reset();
+            return false;
+        }
+        base = hpatch_TStreamOutput();
+        base.streamImport = posix_.get();
+        base.streamSize = maxSize;
+        base.read_writed = Posix::read_writed;
+        base.write = Posix::write;
+        opened_ = true;
+        return true;
+    }
+#else
+    (void)io;
+#endif
+    if (!hpatch_TFileStreamOutput_open(&file_, path, maxSize)) return false;
+    base = file_.base;
+    opened_ = true;
+    return true;
+}
+
+void FileOutputStream::setRandomOut() {
+    if (opened_ && !posix_) {
+        hpatch_TFileStreamOutput_setRandomOut(&file_, hpatch_TRUE);
+        base = file_.base;
+    }
+}
+
+bool FileOutputStream::close() {
+    if (!opened_) return true;
+    opened_ = false;
+    base = hpatch_TStreamOutput();
+#if HDP_FILE_STREAM_POSIX
+    if (posix_) {
+        bool ok = posix_->stop();
+        if (::close(posix_->fd) != 0) ok = false;
+        posix_.reset();
+        return ok;
+    }
+#endif
+    return hpatch_TFileStreamOutput_close(&file_) != hpatch_FALSE;
+}
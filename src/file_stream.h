@@ -0,0 +1,86 @@
+/**
+ * file_stream - 流式 diff/patch 使用的文件流
+ * 默认转发到 file_for_patch 的同步实现;FileIoOptions 启用时(POSIX)改为:
+ *   - 输入:pread + posix_fadvise 预读(SEQUENTIAL/WILLNEED),顺序流可选
+ *     DONTNEED 丢弃已读过的页,超大文件不挤占页缓存;
+ *   - 输出:后台线程写出(queueDepth 个 bufferSize 缓冲),Linux 上用
+ *     sync_file_range 提前触发回写并丢弃已落盘的页。
+ * 计算与 I/O 因此可以重叠。Windows 上始终使用同步实现。
+ * 这里没有 io_uring:输入仍是同步 pread,只有输出由后台线程写出。
+ * mmap 启用时输入改为只读映射整个文件(见 mapped_file.h),read 只是一次
+ * memcpy;映射失败时回退到上面两种方式。
+ * 两个类都把 hpatch 流放在 base 成员,用法与 hpatch_TFileStream* 相同。
+ */
+
+#ifndef HDIFFPATCH_FILE_STREAM_H
+#define HDIFFPATCH_FILE_STREAM_H
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include "../HDiffPatch/file_for_patch.h"
+#include "mapped_file.h"
+
+struct FileIoOptions {
+    size_t bufferSize = 0;  // 0 表示不启用,使用 file_for_patch
+    size_t queueDepth = 0;  // 写出队列/预读窗口的缓冲个数
+    bool dropBehind = true; // 顺序流读写过后丢弃页缓存
+    bool mmap = false;      // 输入映射到内存(只影响 FileInputStream)
+
+    bool enabled() const { return bufferSize != 0; }
+};
+
+const size_t kDefaultIoBufferSize = 1024 * 1024;
+const size_t kDefaultIoQueueDepth = 4;
+
+enum class FileAccess {
+    Random,      // 例如 patch 时的 old:按需随机读,不做丢弃
+    Sequential,  // 例如 diff 时的 new、patch 时的 diff:顺序读,预读并可丢弃
+};
+
+class FileInputStream {
+public:
+    hpatch_TStreamInput base;
+
+    FileInputStream();
+    ~FileInputStream();
+    FileInputStream(const FileInputStream&) = delete;
+    FileInputStream& operator=(const FileInputStream&) = delete;
+
+    bool open(const char* path, const FileIoOptions& io = FileIoOptions(),
+              FileAccess access = FileAccess::Random);
+    bool close();
+    bool isOpen() const { return opened_; }
+
+    struct Posix;
+private:
+    hpatch_TFileStreamInput file_;
+    std::unique_ptr<Posix> posix_;
+    std::unique_ptr<MappedFile> mapped_;
+    bool opened_ = false;
+};
+
+class FileOutputStream {
+public:
+    hpatch_TStreamOutput base;
+
+    FileOutputStream();
+    ~FileOutputStream();
+    FileOutputStream(const FileOutputStream&) = delete;
+    FileOutputStream& operator=(const FileOutputStream&) = delete;
+
+    // maxSize 为允许写出的上限(~0 表示不限)
+    bool open(const char* path, hpatch_StreamPos_t maxSize,
+              const FileIoOptions& io = FileIoOptions());
+    // 允许非顺序写(diff 生成会回写文件头);后写实现本身总是允许
+    void setRandomOut();
+    bool close();
+    bool isOpen() const { return opened_; }
+
+    struct Posix;
+private:
+    hpatch_TFileStreamOutput file_;
+    std::unique_ptr<Posix> posix_;
+    bool opened_ = false;
+};
+
+#endif
@@ -1,9 +1,13 @@
 #include "hdiff.h"
+#include "byte_compare.h"
+#include "diff_checksum.h"
+#include "mem_stream.h"
 #include "../HDiffPatch/libHDiffPatch/HDiff/diff.h"
 #include "../HDiffPatch/libHDiffPatch/HPatch/patch.h"
 #include "../HDiffPatch/file_for_patch.h"
 #include <cstring>
 #include <stdexcept>
+#include <string>
 
 #define _CompressPlugin_lzma2
 #define _IsNeedIncludeDefaultCompressHead 0
@@ -39,75 +43,75 @@ namespace {
     // 显式固定为旧值,保证与既有版本产出行为连续。
     const int kSingleMatchScore = 3;
     const size_t kPatchStepMemSize = 1024 * 256;
+    // trimIdentical:输入不小于 kTrimMinSize 且相同区域(公共前后缀 +
+    // 同偏移相同块)至少占 new 的一半时,改走 window 引擎,后缀串只在滑动
+    // 窗口内构建。相同区域由 window 匹配器自己重新搜索,这里不传 cover。
+    const size_t kTrimMinSize = (size_t)8 * 1024 * 1024;
+    const size_t kTrimBlockSize = 64 * 1024;
+    // 内存版对整个 old 建后缀数组:old < 2GB 时每字节 4 字节(32 位下标),
+    // 否则 8 字节。maxIndexMemory 放不下时改用 window 引擎,窗口按预算取。
+    const hpatch_StreamPos_t kSuffixIndex32Limit = (hpatch_StreamPos_t)1 << 31;
     const char kSingleDiffPrefix[] = "HDIFFSF20&";
     const size_t kSingleDiffPrefixSize = sizeof(kSingleDiffPrefix) - 1;
 
+    // old 被匹配器随机读;new 与校验时读回的 diff 基本顺序,按顺序流预读
     struct FileStreamGuard {
-        hpatch_TFileStreamInput oldStream{};
-        hpatch_TFileStreamInput newStream{};
-        hpatch_TFileStreamOutput diffOutStream{};
-        hpatch_TFileStreamInput diffInStream{};
-        bool oldOpened = false;
-        bool newOpened = false;
-        bool diffOutOpened = false;
-        bool diffInOpened = false;
-
-        FileStreamGuard() {
-            hpatch_TFileStreamInput_init(&oldStream);
-            hpatch_TFileStreamInput_init(&newStream);
-            hpatch_TFileStreamOutput_init(&diffOutStream);
-            hpatch_TFileStreamInput_init(&diffInStream);
-        }
-        ~FileStreamGuard() {
-            if (diffInOpened) hpatch_TFileStreamInput_close(&diffInStream);
-            if (diffOutOpened) hpatch_TFileStreamOutput_close(&diffOutStream);
-            if (newOpened) hpatch_TFileStreamInput_close(&newStream);
-            if (oldOpened) hpatch_TFileStreamInput_close(&oldStream);
-        }
-        void openInputs(const char* oldPath, const char* newPath) {
-            if (!hpatch_TFileStreamInput_open(&oldStream, oldPath)) {
+        FileIoOptions io;
+        FileInputStream oldStream;
+        FileInputStream newStream;
+        FileOutputStream diffOutStream;
+        FileInputStream diffInStream;
+        // 指向 newStream.base,或调用方提供的 new 流(此时 newStream 不打开)
+        const hpatch_TStreamInput* newInput = nullptr;
+
+        explicit FileStreamGuard(const FileIoOptions& io_) : io(io_) {}
+        void openInputs(const char* oldPath, const char* newPath,
+                        const hpatch_TStreamInput* externalNew = nullptr) {
+            if (!oldStream.open(oldPath, io, FileAccess::Random)) {
                 throw std::runtime_error("open old file failed.");
             }
-            oldOpened = true;
-            if (!hpatch_TFileStreamInput_open(&newStream, newPath)) {
+            if (externalNew) {
+                newInput = externalNew;
+                return;
+            }
+            if (!newStream.open(newPath, io, FileAccess::Sequential)) {
                 throw std::runtime_error("open new file failed.");
             }
-            newOpened = true;
+            newInput = &newStream.base;
         }
         void openDiffOut(const char* outDiffPath) {
-            if (!hpatch_TFileStreamOutput_open(&diffOutStream, outDiffPath,
-                                               ~(hpatch_StreamPos_t)0)) {
+            if (!diffOutStream.open(outDiffPath, ~(hpatch_StreamPos_t)0, io)) {
                 throw std::runtime_error("open diff file for write failed.");
             }
-            diffOutOpened = true;
             // 两种流式生成都会回写文件头,必须允许随机写
-            hpatch_TFileStreamOutput_setRandomOut(&diffOutStream, hpatch_TRUE);
+            diffOutStream.setRandomOut();
         }
         void closeDiffOut() {
-            diffOutOpened = false;
-            if (!hpatch_TFileStreamOutput_close(&diffOutStream)) {
+            if (!diffOutStream.close()) {
                 throw std::runtime_error("close diff file failed.");
             }
         }
         void openDiffIn(const char* outDiffPath) {
-            if (!hpatch_TFileStreamInput_open(&diffInStream, outDiffPath)) {
+            if (!diffInStream.open(outDiffPath, io, FileAccess::Sequential)) {
                 throw std::runtime_error("open diff file for read failed.");
             }
-            diffInOpened = true;
+        }
+        // 校验通过后追加尾部:先释放 diff 读句柄,在输入关闭前求摘要
+        void appendChecksum(const char* outDiffPath) {
+            if (!diffInStream.close()) {
+                throw std::runtime_error("close diff file failed.");
+            }
+            append_diff_checksum(outDiffPath, xxh64_stream(&oldStream.base),
+                                 xxh64_stream(newInput));
         }
         void closeAllOrThrow() {
-            if (diffInOpened) {
-                diffInOpened = false;
-                if (!hpatch_TFileStreamInput_close(&diffInStream)) {
-                    throw std::runtime_error("close diff file failed.");
-                }
+            if (!diffInStream.close()) {
+                throw std::runtime_error("close diff file failed.");
             }
-            newOpened = false;
-            if (!hpatch_TFileStreamInput_close(&newStream)) {
+            if (!newStream.close()) {
                 throw std::runtime_error("close new file failed.");
             }
-            oldOpened = false;
-            if (!hpatch_TFileStreamInput_close(&oldStream)) {
+            if (!oldStream.close()) {
                 throw std::runtime_error("close old file failed.");
             }
         }
@@ -261,116 +265,255 @@ namespace {
         }
         diffOut.close();
     }
+
+    size_t identical_region_size(const uint8_t* old, size_t oldsize,
+                                 const uint8_t* _new, size_t newsize) {
+        const size_t minSize = oldsize < newsize ? oldsize : newsize;
+        const size_t prefix = common_prefix_size(old, _new, minSize);
+        const size_t suffix = common_suffix_size(old + oldsize, _new + newsize, minSize - prefix);
+        // 中间部分只统计同偏移的相同块(原地修改的典型情形)
+        const size_t midEnd = minSize - suffix;
+        const size_t blockStart = (prefix + kTrimBlockSize - 1) / kTrimBlockSize * kTrimBlockSize;
+        size_t blocks = 0;
+        if (blockStart < midEnd) {
+            blocks = identical_block_bytes(old + blockStart, _new + blockStart,
+                                           midEnd - blockStart, kTrimBlockSize);
+        }
+        return prefix + suffix + blocks;
+    }
+
+    size_t suffix_index_bytes_per_byte(size_t oldsize) {
+        return ((hpatch_StreamPos_t)oldsize < kSuffixIndex32Limit) ? 4 : 8;
+    }
+
+    // 0 表示预算足够走内存版;否则返回窗口索引不超出预算的 window 字节数。
+    // 预算连默认窗口都放不下时报错,而不是悄悄超出预算
+    size_t compact_window_size(size_t oldsize, size_t maxIndexMemory) {
+        if (maxIndexMemory == 0) return 0;
+        if (oldsize <= maxIndexMemory / suffix_index_bytes_per_byte(oldsize)) return 0;
+        if (maxIndexMemory < hdiff_min_index_memory()) {
+            throw std::runtime_error("maxIndexMemory " + std::to_string(maxIndexMemory) +
+                                     " is below the minimum window index of " +
+                                     std::to_string(hdiff_min_index_memory()) + " bytes.");
+        }
+        size_t windowSize = maxIndexMemory / suffix_index_bytes_per_byte(0);
+        if (suffix_index_bytes_per_byte(windowSize) != suffix_index_bytes_per_byte(0)) {
+            windowSize = maxIndexMemory / suffix_index_bytes_per_byte(windowSize);
+        }
+        return windowSize;
+    }
+
+    bool should_trim_identical(const uint8_t* old, size_t oldsize,
+                               const uint8_t* _new, size_t newsize) {
+        if (oldsize < kTrimMinSize || newsize < kTrimMinSize) return false;
+        return identical_region_size(old, oldsize, _new, newsize) >= newsize / 2;
+    }
+
+    // 内存产物的收尾:与文件版相同地归一压缩类型、回读校验、按需追加校验尾
+    void finish_single_diff(const uint8_t* old, size_t oldsize,
+                            const uint8_t* _new, size_t newsize,
+                            std::vector<uint8_t>& out_codeBuf, bool withChecksum) {
+        normalize_single_raw_compress_type(out_codeBuf);
+        if (!check_single_compressed_diff(_new, _new + newsize, old, old + oldsize,
+                                          out_codeBuf.data(),
+                                          out_codeBuf.data() + out_codeBuf.size(),
+                                          &lzma2DecompressPlugin)) {
+            throw std::runtime_error("check_single_compressed_diff() failed, diff code error!");
+        }
+        if (withChecksum) {
+            append_diff_checksum(out_codeBuf, xxh64(old, oldsize), xxh64(_new, newsize));
+        }
+    }
 }
 
 void hdiff(const uint8_t* old, size_t oldsize, const uint8_t* _new, size_t newsize,
-           std::vector<uint8_t>& out_codeBuf, size_t compressionThreads) {
-    hpatch_TDecompress* decompressPlugin = &lzma2DecompressPlugin;
+           std::vector<uint8_t>& out_codeBuf, size_t compressionThreads,
+           bool withChecksum, bool trimIdentical, size_t maxIndexMemory) {
+    size_t windowSize = compact_window_size(oldsize, maxIndexMemory);
+    if ((windowSize == 0) && trimIdentical &&
+        should_trim_identical(old, oldsize, _new, newsize)) {
+        windowSize = kDefaultWindowOldSize;
+    }
+    if (windowSize != 0) {
+        hdiff_window(old, oldsize, _new, newsize, out_codeBuf, windowSize,
+                     compressionThreads, withChecksum);
+        return;
+    }
+
     TCompressPlugin_lzma2 compressPlugin;
     configure_lzma2(compressPlugin, compressionThreads);
-
     create_single_compressed_diff(_new, _new + newsize, old, old + oldsize, out_codeBuf,
                                   &compressPlugin.base, kPatchStepMemSize,
                                   kSingleMatchScore);
-    normalize_single_raw_compress_type(out_codeBuf);
-
-    if (!check_single_compressed_diff(_new, _new + newsize, old, old + oldsize,
-                                      out_codeBuf.data(),
-                                      out_codeBuf.data() + out_codeBuf.size(),
-                                      decompressPlugin)) {
-        throw std::runtime_error("check_single_compressed_diff() failed, diff code error!");
-    }
+    finish_single_diff(old, oldsize, _new, newsize, out_codeBuf, withChecksum);
 }
 
-void hdiff_stream(const char* oldPath,const char* newPath,const char* outDiffPath,
-                  size_t compressionThreads){
-    if (!oldPath || !newPath || !outDiffPath) {
-        throw std::runtime_error("Invalid file path.");
-    }
-
-    hpatch_TDecompress* decompressPlugin = &lzma2DecompressPlugin;
+void hdiff_single_stream(const uint8_t* old, size_t oldsize, const uint8_t* _new, size_t newsize,
+                         std::vector<uint8_t>& out_codeBuf, size_t compressionThreads,
+                         bool withChecksum) {
     TCompressPlugin_lzma2 compressPlugin;
     configure_lzma2(compressPlugin, compressionThreads);
 
-    FileStreamGuard streams;
-    streams.openInputs(oldPath, newPath);
-    streams.openDiffOut(outDiffPath);
-
-    create_compressed_diff_stream(&streams.newStream.base, &streams.oldStream.base,
-                                  &streams.diffOutStream.base,
-                                  &compressPlugin.base, kMatchBlockSize_default);
-
-    streams.closeDiffOut();
-    streams.openDiffIn(outDiffPath);
-    if (!check_compressed_diff(&streams.newStream.base, &streams.oldStream.base,
-                               &streams.diffInStream.base, decompressPlugin)) {
-        throw std::runtime_error("check_compressed_diff() failed, diff code error!");
-    }
-    streams.closeAllOrThrow();
+    hpatch_TStreamInput oldStream;
+    hpatch_TStreamInput newStream;
+    mem_as_hStreamInput(&oldStream, old, old + oldsize);
+    mem_as_hStreamInput(&newStream, _new, _new + newsize);
+    out_codeBuf.clear();
+    VectorStreamOutput diffOut(out_codeBuf);
+    create_single_compressed_diff_stream(&newStream, &oldStream, &diffOut.base,
+                                         &compressPlugin.base, kPatchStepMemSize,
+                                         kMatchBlockSize_default);
+    finish_single_diff(old, oldsize, _new, newsize, out_codeBuf, withChecksum);
 }
 
-void hdiff_window(const char* oldPath,const char* newPath,const char* outDiffPath,
-                  size_t windowSize,size_t compressionThreads){
-    if (!oldPath || !newPath || !outDiffPath) {
-        throw std::runtime_error("Invalid file path.");
-    }
-
-    hpatch_TDecompress* decompressPlugin = &lzma2DecompressPlugin;
+void hdiff_window(const uint8_t* old, size_t oldsize, const uint8_t* _new, size_t newsize,
+                  std::vector<uint8_t>& out_codeBuf, size_t windowSize,
+                  size_t compressionThreads, bool withChecksum) {
     TCompressPlugin_lzma2 compressPlugin;
     configure_lzma2(compressPlugin, compressionThreads);
 
-    FileStreamGuard streams;
-    streams.openInputs(oldPath, newPath);
-    streams.openDiffOut(outDiffPath);
-
-    // window 模式:大块流式匹配拿大 cover,再在 old 数据的滑动窗口内做
-    // 后缀串精修。窗口默认 2MB,可调大以捕获更长距离的内容移动;
-    // kSegSize 传 0 由上游自动取 windowSize/64。除 patchStepMemSize/
-    // 匹配分沿用本库固定值外,其余参数取 v5 默认。
+    hpatch_TStreamInput oldStream;
+    hpatch_TStreamInput newStream;
+    mem_as_hStreamInput(&oldStream, old, old + oldsize);
+    mem_as_hStreamInput(&newStream, _new, _new + newsize);
+    out_codeBuf.clear();
+    VectorStreamOutput diffOut(out_codeBuf);
+    // 参数与文件版 hdiff_window 相同,产物字节一致
     if (windowSize == 0) windowSize = kDefaultWindowOldSize;
-    create_single_compressed_diff_window(&streams.newStream.base, &streams.oldStream.base,
-                                         &streams.diffOutStream.base,
+    create_single_compressed_diff_window(&newStream, &oldStream, &diffOut.base,
                                          &compressPlugin.base, kPatchStepMemSize,
                                          windowSize, 0,
                                          kDefaultBigCoverSize, kMatchWindowsBlockSize_default,
                                          kDefaultFastMatchBlockSize,
                                          kSingleMatchScore);
+    finish_single_diff(old, oldsize, _new, newsize, out_codeBuf, withChecksum);
+}
 
-    streams.closeDiffOut();
-    normalize_single_raw_compress_type(outDiffPath);
-    streams.openDiffIn(outDiffPath);
-    if (!check_single_compressed_diff(&streams.newStream.base, &streams.oldStream.base,
-                                      &streams.diffInStream.base, decompressPlugin)) {
-        throw std::runtime_error("check_single_compressed_diff() failed, diff code error!");
-    }
-    streams.closeAllOrThrow();
+size_t hdiff_memory_estimate(size_t oldsize, size_t newsize, size_t maxIndexMemory) {
+    const size_t windowSize = compact_window_size(oldsize, maxIndexMemory);
+    if (windowSize != 0) return hdiff_window_memory_estimate(newsize, windowSize);
+    return oldsize * suffix_index_bytes_per_byte(oldsize) + newsize;
 }
 
-void hdiff_single_stream(const char* oldPath,const char* newPath,const char* outDiffPath,
-                         size_t compressionThreads){
-    if (!oldPath || !newPath || !outDiffPath) {
-        throw std::runtime_error("Invalid file path.");
-    }
+size_t hdiff_min_index_memory() {
+    return kDefaultWindowOldSize * suffix_index_bytes_per_byte(kDefaultWindowOldSize);
+}
 
-    hpatch_TDecompress* decompressPlugin = &lzma2DecompressPlugin;
-    TCompressPlugin_lzma2 compressPlugin;
-    configure_lzma2(compressPlugin, compressionThreads);
+size_t hdiff_window_memory_estimate(size_t newsize, size_t windowSize) {
+    if (windowSize == 0) windowSize = kDefaultWindowOldSize;
+    return windowSize * (1 + suffix_index_bytes_per_byte(windowSize)) + newsize;
+}
 
-    FileStreamGuard streams;
-    streams.openInputs(oldPath, newPath);
-    streams.openDiffOut(outDiffPath);
+size_t hdiff_single_stream_memory_estimate(size_t oldsize, size_t newsize) {
+    // 每个匹配块一个滚动哈希与一个排序下标
+    return (oldsize / kMatchBlockSize_default + 1) * 16 + newsize;
+}
 
-    create_single_compressed_diff_stream(&streams.newStream.base, &streams.oldStream.base,
-                                         &streams.diffOutStream.base,
-                                         &compressPlugin.base, kPatchStepMemSize,
-                                         kMatchBlockSize_default);
+namespace {
+    // 三种文件版引擎的公共流程:打开输入与输出、生成、归一(single 格式)、
+    // 回读校验、按需追加校验尾。externalNew 非空时 new 取自该流,newPath 不使用。
+    enum class FileEngine { Stream, SingleStream, Window };
+
+    void diff_files(FileEngine engine, const char* oldPath, const char* newPath,
+                    const hpatch_TStreamInput* externalNew, const char* outDiffPath,
+                    size_t windowSize, size_t compressionThreads, bool withChecksum,
+                    const FileIoOptions& io) {
+        if (!oldPath || !(newPath || externalNew) || !outDiffPath) {
+            throw std::runtime_error("Invalid file path.");
+        }
 
-    streams.closeDiffOut();
-    normalize_single_raw_compress_type(outDiffPath);
-    streams.openDiffIn(outDiffPath);
-    if (!check_single_compressed_diff(&streams.newStream.base, &streams.oldStream.base,
-                                      &streams.diffInStream.base, decompressPlugin)) {
-        throw std::runtime_error("check_single_compressed_diff() failed, diff code error!");
+        hpatch_TDecompress* decompressPlugin = &lzma2DecompressPlugin;
+        TCompressPlugin_lzma2 compressPlugin;
+        configure_lzma2(compressPlugin, compressionThreads);
+
+        FileStreamGuard streams(io);
+        streams.openInputs(oldPath, newPath, externalNew);
+        streams.openDiffOut(outDiffPath);
+
+        switch (engine) {
+            case FileEngine::Stream:
+                create_compressed_diff_stream(streams.newInput, &streams.oldStream.base,
+                                              &streams.diffOutStream.base,
+                                              &compressPlugin.base, kMatchBlockSize_default);
+                break;
+            case FileEngine::SingleStream:
+                create_single_compressed_diff_stream(streams.newInput, &streams.oldStream.base,
+                                                     &streams.diffOutStream.base,
+                                                     &compressPlugin.base, kPatchStepMemSize,
+                                                     kMatchBlockSize_default);
+                break;
+            case FileEngine::Window:
+                // window 模式:大块流式匹配拿大 cover,再在 old 数据的滑动窗口内做
+                // 后缀串精修。窗口默认 2MB,可调大以捕获更长距离的内容移动;
+                // kSegSize 传 0 由上游自动取 windowSize/64。除 patchStepMemSize/
+                // 匹配分沿用本库固定值外,其余参数取 v5 默认。
+                if (windowSize == 0) windowSize = kDefaultWindowOldSize;
+                create_single_compressed_diff_window(streams.newInput, &streams.oldStream.base,
+                                                     &streams.diffOutStream.base,
+                                                     &compressPlugin.base, kPatchStepMemSize,
+                                                     windowSize, 0,
+                                                     kDefaultBigCoverSize,
+                                                     kMatchWindowsBlockSize_default,
+                                                     kDefaultFastMatchBlockSize,
+                                                     kSingleMatchScore);
+                break;
+        }
+
+        streams.closeDiffOut();
+        if (engine != FileEngine::Stream) normalize_single_raw_compress_type(outDiffPath);
+        streams.openDiffIn(outDiffPath);
+        if (engine == FileEngine::Stream) {
+            if (!check_compressed_diff(streams.newInput, &streams.oldStream.base,
+                                       &streams.diffInStream.base, decompressPlugin)) {
+                throw std::runtime_error("check_compressed_diff() failed, diff code error!");
+            }
+        } else if (!check_single_compressed_diff(streams.newInput, &streams.oldStream.base,
+                                                 &streams.diffInStream.base, decompressPlugin)) {
+            throw std::runtime_error("check_single_compressed_diff() failed, diff code error!");
+        }
+        if (withChecksum) streams.appendChecksum(outDiffPath);
+        streams.closeAllOrThrow();
     }
-    streams.closeAllOrThrow();
+}
+
+void hdiff_stream(const char* oldPath,const char* newPath,const char* outDiffPath,
+                  size_t compressionThreads,bool withChecksum,
+                  const FileIoOptions& io){
+    diff_files(FileEngine::Stream, oldPath, newPath, nullptr, outDiffPath, 0,
+               compressionThreads, withChecksum, io);
+}
+
+void hdiff_window(const char* oldPath,const char* newPath,const char* outDiffPath,
+                  size_t windowSize,size_t compressionThreads,bool withChecksum,
+                  const FileIoOptions& io){
+    diff_files(FileEngine::Window, oldPath, newPath, nullptr, outDiffPath, windowSize,
+               compressionThreads, withChecksum, io);
+}
+
+void hdiff_single_stream(const char* oldPath,const char* newPath,const char* outDiffPath,
+                         size_t compressionThreads,bool withChecksum,
+                  const FileIoOptions& io){
+    diff_files(FileEngine::SingleStream, oldPath, newPath, nullptr, outDiffPath, 0,
+               compressionThreads, withChecksum, io);
+}
+
+void hdiff_stream(const char* oldPath,const hpatch_TStreamInput* newStream,
+                  const char* outDiffPath,size_t compressionThreads,bool withChecksum,
+                  const FileIoOptions& io){
+    diff_files(FileEngine::Stream, oldPath, nullptr, newStream, outDiffPath, 0,
+               compressionThreads, withChecksum, io);
+}
+
+void hdiff_window(const char* oldPath,const hpatch_TStreamInput* newStream,
+                  const char* outDiffPath,size_t windowSize,size_t compressionThreads,
+                  bool withChecksum,const FileIoOptions& io){
+    diff_files(FileEngine::Window, oldPath, nullptr, newStream, outDiffPath, windowSize,
+               compressionThreads, withChecksum, io);
+}
+
+void hdiff_single_stream(const char* oldPath,const hpatch_TStreamInput* newStream,
+                         const char* outDiffPath,size_t compressionThreads,bool withChecksum,
+                         const FileIoOptions& io){
+    diff_files(FileEngine::SingleStream, oldPath, nullptr, newStream, outDiffPath, 0,
+               compressionThreads, withChecksum, io);
 }
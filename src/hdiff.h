@@ -7,21 +7,65 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <vector>
+#include "file_stream.h"
 
+// withChecksum 为 true 时在产物尾部追加 old/new 的 XXH64(见 diff_checksum.h),
+// 校验通过后才追加,本库各 patch 入口会自动识别并校验。
+// trimIdentical 为 true 时是启发式的引擎切换:先用向量化比较统计公共前后缀
+// 与同偏移相同块,大输入且相同区域过半时改用 window 引擎(产物仍为
+// HDIFFSF20,但字节与大小都与默认路径不同),不建整个 old 的后缀数组。
+// 统计出的区域只用于判断,不作为 cover 传给匹配器。
+// maxIndexMemory 非 0 时是引擎选择而不是压缩索引:后缀索引(old<2GB 时约
+// 4 字节/old 字节,否则 8 字节)放得下时产物与默认路径一致;放不下时改用
+// window 引擎,窗口取 maxIndexMemory/每字节索引开销,窗口索引不超过预算。
+// 预算低于 hdiff_min_index_memory()(2MB 默认窗口的索引)时抛出异常。
 void hdiff(const uint8_t* old,size_t oldsize,const uint8_t* _new,size_t newsize,
-		   std::vector<uint8_t>& out_codeBuf,size_t compressionThreads=1);
+		   std::vector<uint8_t>& out_codeBuf,size_t compressionThreads=1,
+		   bool withChecksum=false,bool trimIdentical=false,size_t maxIndexMemory=0);
+// 以下文件模式的 io 控制文件读写方式(见 file_stream.h),不影响产物字节。
 // HDIFF13 流式(生成端低内存,产物需 patchStream 应用)
 void hdiff_stream(const char* oldPath,const char* newPath,const char* outDiffPath,
-                  size_t compressionThreads=1);
+                  size_t compressionThreads=1,bool withChecksum=false,
+                  const FileIoOptions& io=FileIoOptions());
 // HDIFFSF20 single 格式的流式生成(生成端低内存,产物与 diff() 同格式,
 // 任何既有 single 应用端可直接使用)
 void hdiff_single_stream(const char* oldPath,const char* newPath,const char* outDiffPath,
-                         size_t compressionThreads=1);
+                         size_t compressionThreads=1,bool withChecksum=false,
+                  const FileIoOptions& io=FileIoOptions());
 // HDIFFSF20 single 格式的 window 模式生成:大块流式匹配 + 窗口内后缀串
 // 精修,匹配质量接近内存版而内存占用保持流式档;产物与 diff() 同格式。
 // windowSize 为 old 数据滑动窗口字节数,0 表示用默认值(2MB);窗口越大
 // 能捕获越长距离的内容移动,内存占用近似随之线性增长。
 void hdiff_window(const char* oldPath,const char* newPath,const char* outDiffPath,
-                  size_t windowSize=0,size_t compressionThreads=1);
+                  size_t windowSize=0,size_t compressionThreads=1,bool withChecksum=false,
+                  const FileIoOptions& io=FileIoOptions());
+// 上面三种文件引擎的 new 改由调用方的流提供(例如 feed_stream.h 的边写边读输入),
+// 其余与文件版相同。new 会被重读(回看、校验、摘要),流须支持已读范围的随机读取。
+void hdiff_stream(const char* oldPath,const hpatch_TStreamInput* newStream,
+                  const char* outDiffPath,size_t compressionThreads=1,bool withChecksum=false,
+                  const FileIoOptions& io=FileIoOptions());
+void hdiff_single_stream(const char* oldPath,const hpatch_TStreamInput* newStream,
+                         const char* outDiffPath,size_t compressionThreads=1,
+                         bool withChecksum=false,const FileIoOptions& io=FileIoOptions());
+void hdiff_window(const char* oldPath,const hpatch_TStreamInput* newStream,
+                  const char* outDiffPath,size_t windowSize=0,size_t compressionThreads=1,
+                  bool withChecksum=false,const FileIoOptions& io=FileIoOptions());
+// 上面两种 single 格式流式引擎的内存版:old/new 以内存流输入,产物直接
+// 写入 out_codeBuf(不经过临时文件),字节与对应的文件版相同。
+void hdiff_single_stream(const uint8_t* old,size_t oldsize,const uint8_t* _new,size_t newsize,
+                         std::vector<uint8_t>& out_codeBuf,size_t compressionThreads=1,
+                         bool withChecksum=false);
+void hdiff_window(const uint8_t* old,size_t oldsize,const uint8_t* _new,size_t newsize,
+                  std::vector<uint8_t>& out_codeBuf,size_t windowSize=0,
+                  size_t compressionThreads=1,bool withChecksum=false);
+
+// 峰值工作集的估算(字节),用于原生内存统计与向 JS 引擎上报,不影响 diff。
+// 内存版为 old 的后缀索引(maxIndexMemory 不够时为 window 引擎)加 new
+// 量级的编码缓冲;window 为窗口数据与窗口内索引;single 流式为块摘要表。
+size_t hdiff_memory_estimate(size_t oldsize,size_t newsize,size_t maxIndexMemory=0);
+// maxIndexMemory 允许的最小非 0 值
+size_t hdiff_min_index_memory();
+size_t hdiff_window_memory_estimate(size_t newsize,size_t windowSize=0);
+size_t hdiff_single_stream_memory_estimate(size_t oldsize,size_t newsize);
 
 #endif
@@ -3,10 +3,16 @@
  * Created based on HDiffPatch library
  */
 #include "hpatch.h"
+#include "diff_checksum.h"
+#include "pipelined_decompress.h"
 #include "../HDiffPatch/libHDiffPatch/HPatch/patch.h"
 #include "../HDiffPatch/file_for_patch.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <limits>
 #include <stdexcept>
+#include <string>
 
 #define _CompressPlugin_lzma2
 #define _IsNeedIncludeDefaultCompressHead 0
@@ -17,7 +23,7 @@
 // Listener for patch_single_stream_by
 struct PatchListener {
     hpatch_TDecompress* decompressPlugin;
-    std::vector<uint8_t>* tempCache;
+    PatchBuffer* tempCache;
 };
 
 static hpatch_BOOL onDiffInfo(sspatch_listener_t* listener,
@@ -35,6 +41,7 @@ static hpatch_BOOL onDiffInfo(sspatch_listener_t* listener,
     }
 
     // Allocate temp cache: stepMemSize + I/O cache
+    // (复用的 tempCache 容量足够时 resize 不会重新分配)
     size_t cacheSize = (size_t)info->stepMemSize + hpatch_kStreamCacheSize * 4;
     self->tempCache->resize(cacheSize);
     
@@ -45,89 +52,276 @@ static hpatch_BOOL onDiffInfo(sspatch_listener_t* listener,
     return hpatch_TRUE;
 }
 
-void hpatch(const uint8_t* old, size_t oldsize,
-            const uint8_t* diff, size_t diffsize,
-            std::vector<uint8_t>& out_newBuf) {
-    
-    // Get diff info to determine output size
-    hpatch_singleCompressedDiffInfo diffInfo;
-    if (!getSingleCompressedDiffInfo_mem(&diffInfo, diff, diff + diffsize)) {
-        throw std::runtime_error("getSingleCompressedDiffInfo_mem() failed, invalid diff data!");
-    }
-    
-    // Verify old data size matches
-    if (diffInfo.oldDataSize != oldsize) {
-        throw std::runtime_error("Old data size mismatch!");
+namespace {
+    // 内存 diff 的头部信息:去掉可选校验尾部后解析,并做与 old 无关的尺寸检查
+    struct MemDiffHeader {
+        DiffChecksum checksum;
+        size_t payloadSize = 0;
+        size_t newSize = 0;
+    };
+
+    MemDiffHeader read_mem_diff_header(const uint8_t* diff, size_t diffsize, size_t oldsize) {
+        MemDiffHeader header;
+        header.checksum = read_diff_checksum(diff, diffsize);
+        header.payloadSize = (size_t)header.checksum.payloadSize;
+
+        hpatch_singleCompressedDiffInfo diffInfo;
+        if (!getSingleCompressedDiffInfo_mem(&diffInfo, diff, diff + header.payloadSize)) {
+            throw std::runtime_error("getSingleCompressedDiffInfo_mem() failed, invalid diff data!");
+        }
+        if (diffInfo.oldDataSize != oldsize) {
+            throw std::runtime_error("Old data size mismatch!");
+        }
+        // newDataSize 来自 diff 数据,防止 uint64 → size_t 截断(32 位平台)
+        if (diffInfo.newDataSize >
+            (hpatch_StreamPos_t)std::numeric_limits<size_t>::max()) {
+            throw std::runtime_error("Invalid diff data: declared new size is too large!");
+        }
+        header.newSize = (size_t)diffInfo.newDataSize;
+        return header;
     }
+}
 
-    // newDataSize 来自 diff 数据,防止 uint64 → size_t 截断(32 位平台)
-    if (diffInfo.newDataSize >
-        (hpatch_StreamPos_t)std::numeric_limits<size_t>::max()) {
-        throw std::runtime_error("Invalid diff data: declared new size is too large!");
+size_t hpatch_new_size(size_t oldsize, const uint8_t* diff, size_t diffsize) {
+    return read_mem_diff_header(diff, diffsize, oldsize).newSize;
+}
+
+size_t hpatch_into(const uint8_t* old, size_t oldsize,
+                   const uint8_t* diff, size_t diffsize,
+                   uint8_t* out_new, size_t outCapacity,
+                   PatchBuffer& tempCache) {
+    const MemDiffHeader header = read_mem_diff_header(diff, diffsize, oldsize);
+    if (header.newSize > outCapacity) {
+        throw std::runtime_error("Output buffer is too small!");
+    }
+    if (header.checksum.present && xxh64(old, oldsize) != header.checksum.oldHash) {
+        throw std::runtime_error("Old data checksum mismatch!");
     }
 
-    // Allocate output buffer
-    out_newBuf.resize((size_t)diffInfo.newDataSize);
-    
-    // Setup decompressor
-    hpatch_TDecompress* decompressPlugin = &lzma2DecompressPlugin;
-    
-    // Setup listener
-    std::vector<uint8_t> tempCache;
     PatchListener patchListener;
-    patchListener.decompressPlugin = decompressPlugin;
+    patchListener.decompressPlugin = &lzma2DecompressPlugin;
     patchListener.tempCache = &tempCache;
-    
+
     sspatch_listener_t listener;
     listener.import = &patchListener;
     listener.onDiffInfo = onDiffInfo;
     listener.onPatchFinish = nullptr;
-    
-    // Execute patch
+
     if (!patch_single_stream_mem(&listener,
-                                 out_newBuf.data(), out_newBuf.data() + out_newBuf.size(),
+                                 out_new, out_new + header.newSize,
                                  old, old + oldsize,
-                                 diff, diff + diffsize,
+                                 diff, diff + header.payloadSize,
                                  0 /*coversListener*/, 1 /*threadNum*/)) {
         throw std::runtime_error("patch_single_stream_mem() failed!");
     }
+    if (header.checksum.present &&
+        xxh64(out_new, header.newSize) != header.checksum.newHash) {
+        throw std::runtime_error("New data checksum mismatch!");
+    }
+    return header.newSize;
 }
 
-void hpatch_single_stream(const char* oldPath,const char* diffPath,const char* outNewPath){
-    if (!oldPath || !diffPath || !outNewPath) {
-        throw std::runtime_error("Invalid file path.");
+void hpatch(const uint8_t* old, size_t oldsize,
+            const uint8_t* diff, size_t diffsize,
+            PatchBuffer& out_newBuf) {
+    out_newBuf.resize(hpatch_new_size(oldsize, diff, diffsize));
+    PatchBuffer tempCache;
+    hpatch_into(old, oldsize, diff, diffsize, out_newBuf.data(), out_newBuf.size(), tempCache);
+}
+
+namespace {
+    // 只保留 [begin, end) 的输出流;写到 end 时返回失败以中止剩余解码,
+    // 由 complete 区分这次“失败”与真正的 patch 错误
+    // 只保留 [begin, end) 的输出流。范围写满且后面还有数据时,write 返回
+    // FALSE 让 patch 提前结束,并记下 stoppedEarly;调用方据此区分主动中止
+    // 与 diff 损坏,而不是凭 patch 的返回值猜测。范围延伸到末尾时不中止,
+    // patch 照常跑完并做完整的收尾检查。输出不可回读(read_writed 为空)。
+    struct RangeStreamOutput {
+        hpatch_TStreamOutput base{};
+        uint8_t* out;
+        hpatch_StreamPos_t begin;
+        hpatch_StreamPos_t end;
+        hpatch_StreamPos_t written = 0;  // 按顺序写到的位置
+        bool stoppedEarly = false;
+
+        RangeStreamOutput(uint8_t* out_, hpatch_StreamPos_t begin_, hpatch_StreamPos_t end_,
+                          hpatch_StreamPos_t newSize)
+            : out(out_), begin(begin_), end(end_) {
+            base.streamImport = this;
+            base.streamSize = newSize;
+            base.read_writed = nullptr;
+            base.write = write;
+        }
+
+        bool rangeWritten() const { return written >= end; }
+
+        static hpatch_BOOL write(const hpatch_TStreamOutput* stream,
+                                 hpatch_StreamPos_t writeToPos,
+                                 const unsigned char* data, const unsigned char* data_end) {
+            RangeStreamOutput* self = (RangeStreamOutput*)stream->streamImport;
+            // 中止后不再接受写入;single 格式按顺序输出,跳写视为损坏
+            if (self->stoppedEarly || writeToPos != self->written) return hpatch_FALSE;
+            const hpatch_StreamPos_t chunkEnd = writeToPos + (hpatch_StreamPos_t)(data_end - data);
+            const hpatch_StreamPos_t lo = std::max(writeToPos, self->begin);
+            const hpatch_StreamPos_t hi = std::min(chunkEnd, self->end);
+            if (lo < hi) {
+                std::memcpy(self->out + (size_t)(lo - self->begin),
+                            data + (size_t)(lo - writeToPos), (size_t)(hi - lo));
+            }
+            self->written = chunkEnd;
+            if (self->rangeWritten() && chunkEnd < stream->streamSize) {
+                self->stoppedEarly = true;
+                return hpatch_FALSE;
+            }
+            return hpatch_TRUE;
+        }
+    };
+}
+
+namespace {
+    void check_range(const MemDiffHeader& header, uint64_t offset, size_t length) {
+        if (offset > header.newSize || length > header.newSize - offset) {
+            throw std::runtime_error("Range is out of bounds of the new data!");
+        }
     }
 
-    hpatch_TDecompress* decompressPlugin = &lzma2DecompressPlugin;
+    void patch_range(const uint8_t* old, size_t oldsize, const uint8_t* diff,
+                     const MemDiffHeader& header, uint64_t offset, size_t length,
+                     uint8_t* out) {
+        if (length == 0) return;
+        if (header.checksum.present && xxh64(old, oldsize) != header.checksum.oldHash) {
+            throw std::runtime_error("Old data checksum mismatch!");
+        }
 
-    hpatch_TFileStreamInput oldStream;
-    hpatch_TFileStreamInput diffStream;
-    hpatch_TFileStreamOutput newStream;
-    hpatch_TFileStreamInput_init(&oldStream);
-    hpatch_TFileStreamInput_init(&diffStream);
-    hpatch_TFileStreamOutput_init(&newStream);
+        PatchBuffer tempCache;
+        PatchListener patchListener;
+        patchListener.decompressPlugin = &lzma2DecompressPlugin;
+        patchListener.tempCache = &tempCache;
 
-    bool oldOpened = false;
-    bool diffOpened = false;
-    bool newOpened = false;
+        sspatch_listener_t listener;
+        listener.import = &patchListener;
+        listener.onDiffInfo = onDiffInfo;
+        listener.onPatchFinish = nullptr;
 
-    try {
-        if (!hpatch_TFileStreamInput_open(&oldStream, oldPath)) {
-            throw std::runtime_error("open old file failed.");
+        hpatch_TStreamInput oldStream;
+        hpatch_TStreamInput diffStream;
+        mem_as_hStreamInput(&oldStream, old, old + oldsize);
+        mem_as_hStreamInput(&diffStream, diff, diff + header.payloadSize);
+        RangeStreamOutput rangeOut(out, offset, offset + length, header.newSize);
+        const hpatch_BOOL ok = patch_single_stream(&listener, &rangeOut.base, &oldStream, &diffStream,
+                                                   0 /*diffInfo_pos*/, 0 /*coversListener*/,
+                                                   1 /*threadNum*/);
+        if (rangeOut.stoppedEarly) return;  // 范围已写满,主动中止
+        if (!ok) {
+            throw std::runtime_error("patch_single_stream() failed!");
         }
-        oldOpened = true;
-        if (!hpatch_TFileStreamInput_open(&diffStream, diffPath)) {
-            throw std::runtime_error("open diff file failed.");
+        if (!rangeOut.rangeWritten()) {
+            throw std::runtime_error("patch_single_stream() ended before the requested range!");
         }
-        diffOpened = true;
-        if (!hpatch_TFileStreamOutput_open(&newStream, outNewPath, ~(hpatch_StreamPos_t)0)) {
-            throw std::runtime_error("open new file for write failed.");
+    }
+}
+
+void hpatch_range(const uint8_t* old, size_t oldsize,
+                  const uint8_t* diff, size_t diffsize,
+                  uint64_t offset, size_t length,
+                  PatchBuffer& out_range) {
+    const MemDiffHeader header = read_mem_diff_header(diff, diffsize, oldsize);
+    check_range(header, offset, length);
+    out_range.resize(length);
+    patch_range(old, oldsize, diff, header, offset, length, out_range.data());
+}
+
+size_t hpatch_range_into(const uint8_t* old, size_t oldsize,
+                         const uint8_t* diff, size_t diffsize,
+                         uint64_t offset, size_t length,
+                         uint8_t* out, size_t outCapacity) {
+    const MemDiffHeader header = read_mem_diff_header(diff, diffsize, oldsize);
+    check_range(header, offset, length);
+    if (outCapacity < length) {
+        throw std::runtime_error("Output buffer too small: need " + std::to_string(length) +
+                                 " bytes.");
+    }
+    patch_range(old, oldsize, diff, header, offset, length, out);
+    return length;
+}
+
+namespace {
+    struct FileInputGuard {
+        FileInputStream stream;
+
+        void open(const char* path, const char* errorMessage,
+                  const FileIoOptions& io = FileIoOptions(),
+                  FileAccess access = FileAccess::Random) {
+            if (!stream.open(path, io, access)) {
+                throw std::runtime_error(errorMessage);
+            }
+        }
+        void close(const char* errorMessage) {
+            if (!stream.close()) {
+                throw std::runtime_error(errorMessage);
+            }
+        }
+    };
+
+    struct FileOutputGuard {
+        FileOutputStream stream;
+
+        void open(const char* path, hpatch_StreamPos_t maxSize, const char* errorMessage,
+                  const FileIoOptions& io = FileIoOptions()) {
+            if (!stream.open(path, maxSize, io)) {
+                throw std::runtime_error(errorMessage);
+            }
+        }
+        void close(const char* errorMessage) {
+            if (!stream.close()) {
+                throw std::runtime_error(errorMessage);
+            }
         }
-        newOpened = true;
+    };
 
-        std::vector<uint8_t> tempCache;
+    // diff 流去掉可选校验尾部后的视图:读函数与 streamImport 不变,只收窄长度
+    struct DiffPayload {
+        DiffChecksum checksum;
+        hpatch_TStreamInput stream{};
+
+        void attach(const hpatch_TStreamInput* diff) {
+            checksum = read_diff_checksum(diff);
+            stream = *diff;
+            stream.streamSize = checksum.payloadSize;
+        }
+    };
+
+    // old 在 patch 期间被随机读取,无法边读边算,因此先顺序读一遍校验,
+    // 基准不符时在写出任何数据前拒绝;new 则在写出时顺带求摘要。
+    template <class PatchFn>
+    void patch_with_checksum(const hpatch_TStreamOutput* out_newData,
+                             const hpatch_TStreamInput* oldData,
+                             const DiffChecksum& checksum,
+                             PatchFn patchFn) {
+        if (!checksum.present) {
+            patchFn(out_newData);
+            return;
+        }
+        if (xxh64_stream(oldData) != checksum.oldHash) {
+            throw std::runtime_error("Old data checksum mismatch!");
+        }
+        HashingStreamOutput hashingOut(out_newData);
+        patchFn(&hashingOut.base);
+        uint64_t newHash = 0;
+        if (!hashingOut.digest(&newHash)) {
+            throw std::runtime_error("read new data for checksum failed.");
+        }
+        if (newHash != checksum.newHash) {
+            throw std::runtime_error("New data checksum mismatch!");
+        }
+    }
+
+    void patch_single_streams(const hpatch_TStreamOutput* out_newData,
+                              const hpatch_TStreamInput* oldData,
+                              const hpatch_TStreamInput* diff) {
+        PatchBuffer tempCache;
         PatchListener patchListener;
-        patchListener.decompressPlugin = decompressPlugin;
+        patchListener.decompressPlugin = &lzma2DecompressPlugin;
         patchListener.tempCache = &tempCache;
 
         sspatch_listener_t listener;
@@ -135,89 +329,329 @@ void hpatch_single_stream(const char* oldPath,const char* diffPath,const char* o
         listener.onDiffInfo = onDiffInfo;
         listener.onPatchFinish = nullptr;
 
-        if (!patch_single_stream(&listener, &newStream.base, &oldStream.base, &diffStream.base,
+        if (!patch_single_stream(&listener, out_newData, oldData, diff,
                                  0 /*diffInfo_pos*/, 0 /*coversListener*/, 1 /*threadNum*/)) {
             throw std::runtime_error("patch_single_stream() failed!");
         }
-    } catch (...) {
-        if (newOpened) hpatch_TFileStreamOutput_close(&newStream);
-        if (diffOpened) hpatch_TFileStreamInput_close(&diffStream);
-        if (oldOpened) hpatch_TFileStreamInput_close(&oldStream);
-        throw;
     }
 
-    if (newOpened && !hpatch_TFileStreamOutput_close(&newStream)) {
-        throw std::runtime_error("close new file failed.");
+    void check_compress_type(const hpatch_compressedDiffInfo& diffInfo) {
+        if (!lzma2DecompressPlugin.is_can_open(diffInfo.compressType)) {
+            throw std::runtime_error("Unsupported diff compress type.");
+        }
+    }
+
+    // pipelined 时各压缩子流在独立线程预解压,diff 流加锁供多线程读取
+    void patch_compressed_streams(const hpatch_TStreamOutput* out_newData,
+                                  const hpatch_TStreamInput* oldData,
+                                  const hpatch_TStreamInput* diff,
+                                  bool pipelined = false) {
+        hpatch_BOOL ok;
+        if (pipelined) {
+            LockedStreamInput lockedDiff(diff);
+            PipelinedDecompress pipeline(&lzma2DecompressPlugin);
+            ok = patch_decompress(out_newData, oldData, &lockedDiff.base, &pipeline.base);
+        } else {
+            ok = patch_decompress(out_newData, oldData, diff, &lzma2DecompressPlugin);
+        }
+        if (!ok) {
+            throw std::runtime_error("patch_decompress() failed!");
+        }
+    }
+
+    void patch_single_payload(const hpatch_TStreamOutput* out_newData,
+                              const hpatch_TStreamInput* oldData,
+                              const DiffPayload& diff) {
+        patch_with_checksum(out_newData, oldData, diff.checksum,
+                            [&](const hpatch_TStreamOutput* out) {
+            patch_single_streams(out, oldData, &diff.stream);
+        });
+    }
+
+    void patch_compressed_payload(const hpatch_TStreamOutput* out_newData,
+                                  const hpatch_TStreamInput* oldData,
+                                  const DiffPayload& diff,
+                                  bool pipelined = false) {
+        patch_with_checksum(out_newData, oldData, diff.checksum,
+                            [&](const hpatch_TStreamOutput* out) {
+            patch_compressed_streams(out, oldData, &diff.stream, pipelined);
+        });
+    }
+
+    // patchChain 的一跳:diff 文件已打开,格式与尺寸在规划阶段读出
+    struct ChainStage {
+        FileInputGuard diff;
+        DiffPayload payload;
+        bool isSingle = false;
+        hpatch_StreamPos_t oldDataSize = 0;
+        hpatch_StreamPos_t newDataSize = 0;
+        bool keepInMemory = false;
+        std::string tempPath;
+    };
+
+    void read_chain_stage_info(ChainStage& stage) {
+        stage.payload.attach(&stage.diff.stream.base);
+        const hpatch_TStreamInput* diff = &stage.payload.stream;
+        hpatch_singleCompressedDiffInfo singleInfo;
+        if (getSingleCompressedDiffInfo(&singleInfo, diff, 0)) {
+            stage.isSingle = true;
+            stage.oldDataSize = singleInfo.oldDataSize;
+            stage.newDataSize = singleInfo.newDataSize;
+            return;
+        }
+        hpatch_compressedDiffInfo info;
+        if (!getCompressedDiffInfo(&info, diff)) {
+            throw std::runtime_error("patchChain: invalid diff data!");
+        }
+        check_compress_type(info);
+        stage.isSingle = false;
+        stage.oldDataSize = info.oldDataSize;
+        stage.newDataSize = info.newDataSize;
     }
-    if (diffOpened && !hpatch_TFileStreamInput_close(&diffStream)) {
-        throw std::runtime_error("close diff file failed.");
+
+    // 删除 patchChain 落盘的中间文件(成功或失败都要清理)
+    struct TempFilesGuard {
+        std::vector<std::string> paths;
+        ~TempFilesGuard() {
+            for (const std::string& path : paths) std::remove(path.c_str());
+        }
+    };
+}
+
+namespace {
+    // LZMA2 解码器:字典按属性字节与 LzmaDec_Allocate 的对齐规则计算;概率表按
+    // Lzma2Dec 分配时的 lc+lp 上限 4:(NUM_BASE_PROBS + 0x300<<4) 个 UInt16。
+    const uint64_t kLzma2ProbsBytes = (1984 + (0x300 << 4)) * 2;
+    const uint8_t kLzma2DictProp8MB = 22;  // hdiff.cpp 固定的 8MB 字典
+
+    uint64_t lzma2_decoder_memory(uint8_t dictProp) {
+        if (dictProp > 40) {
+            throw std::runtime_error("Invalid diff data: bad LZMA2 dictionary property!");
+        }
+        const uint64_t dictSize = (dictProp == 40)
+            ? 0xFFFFFFFFull
+            : (uint64_t)(2 | (dictProp & 1)) << (dictProp / 2 + 11);
+        uint64_t mask = (1u << 12) - 1;
+        if (dictSize >= (1u << 30)) {
+            mask = (1u << 22) - 1;
+        } else if (dictSize >= (1u << 22)) {
+            mask = (1u << 20) - 1;
+        }
+        uint64_t dicBufSize = (dictSize + mask) & ~mask;
+        if (dicBufSize < dictSize) dicBufSize = dictSize;
+        return dicBufSize + kLzma2ProbsBytes;
+    }
+
+    HpatchDiffInfo read_diff_info(const hpatch_TStreamInput* diffStream) {
+        DiffPayload diff;
+        diff.attach(diffStream);
+        HpatchDiffInfo out;
+        out.hasChecksum = diff.checksum.present;
+
+        hpatch_singleCompressedDiffInfo singleInfo;
+        if (getSingleCompressedDiffInfo(&singleInfo, &diff.stream, 0)) {
+            out.isSingle = true;
+            out.oldDataSize = singleInfo.oldDataSize;
+            out.newDataSize = singleInfo.newDataSize;
+            out.stepMemSize = singleInfo.stepMemSize;
+            out.compressType = singleInfo.compressType;
+            out.workMemory = singleInfo.stepMemSize + hpatch_kStreamCacheSize * 4;
+            if (singleInfo.compressedSize > 0) {
+                // lzma2 插件在压缩数据的第一个字节写入字典属性
+                unsigned char dictProp = 0;
+                if (!diff.stream.read(&diff.stream, singleInfo.diffDataPos,
+                                      &dictProp, &dictProp + 1)) {
+                    throw std::runtime_error("read diff data failed.");
+                }
+                out.decoderMemory = lzma2_decoder_memory(dictProp);
+            }
+            return out;
+        }
+
+        hpatch_compressedDiffInfo info;
+        if (!getCompressedDiffInfo(&info, &diff.stream)) {
+            throw std::runtime_error("Invalid diff data: not an HDIFFSF20 or HDIFF13 diff!");
+        }
+        out.oldDataSize = info.oldDataSize;
+        out.newDataSize = info.newDataSize;
+        out.compressType = info.compressType;
+        // patch_decompress 的 IO 缓存在栈上;每个压缩子流各开一个解码器
+        out.decoderMemory = (uint64_t)info.compressedCount *
+                            lzma2_decoder_memory(kLzma2DictProp8MB);
+        out.decoderMemoryExact = (info.compressedCount == 0);
+        return out;
+    }
+}
+
+HpatchDiffInfo hpatch_diff_info(const uint8_t* diff, size_t diffsize) {
+    hpatch_TStreamInput diffStream;
+    mem_as_hStreamInput(&diffStream, diff, diff + diffsize);
+    return read_diff_info(&diffStream);
+}
+
+HpatchDiffInfo hpatch_diff_info(const char* diffPath) {
+    if (!diffPath) {
+        throw std::runtime_error("Invalid file path.");
     }
-    if (oldOpened && !hpatch_TFileStreamInput_close(&oldStream)) {
-        throw std::runtime_error("close old file failed.");
+    FileInputGuard diffFile;
+    diffFile.open(diffPath, "open diff file failed.");
+    HpatchDiffInfo out = read_diff_info(&diffFile.stream.base);
+    diffFile.close("close diff file failed.");
+    return out;
+}
+
+void hpatch_single_stream(const char* oldPath,const char* diffPath,const char* outNewPath,
+                          const FileIoOptions& io){
+    if (!oldPath || !diffPath || !outNewPath) {
+        throw std::runtime_error("Invalid file path.");
     }
+
+    FileInputGuard oldFile;
+    FileInputGuard diffFile;
+    FileOutputGuard newFile;
+    oldFile.open(oldPath, "open old file failed.", io);
+    diffFile.open(diffPath, "open diff file failed.", io, FileAccess::Sequential);
+    DiffPayload diff;
+    diff.attach(&diffFile.stream.base);
+    newFile.open(outNewPath, ~(hpatch_StreamPos_t)0, "open new file for write failed.", io);
+
+    patch_single_payload(&newFile.stream.base, &oldFile.stream.base, diff);
+
+    newFile.close("close new file failed.");
+    diffFile.close("close diff file failed.");
+    oldFile.close("close old file failed.");
 }
 
-void hpatch_stream(const char* oldPath,const char* diffPath,const char* outNewPath){
+void hpatch_stream(const char* oldPath,const char* diffPath,const char* outNewPath,
+                   const FileIoOptions& io,bool pipelined){
     if (!oldPath || !diffPath || !outNewPath) {
         throw std::runtime_error("Invalid file path.");
     }
 
-    hpatch_TDecompress* decompressPlugin = &lzma2DecompressPlugin;
+    FileInputGuard oldFile;
+    FileInputGuard diffFile;
+    FileOutputGuard newFile;
+    // HDIFF13 的多个压缩子流交错前进,diff 按随机访问处理,不做丢弃
+    oldFile.open(oldPath, "open old file failed.", io);
+    diffFile.open(diffPath, "open diff file failed.", io);
 
-    hpatch_TFileStreamInput oldStream;
-    hpatch_TFileStreamInput diffStream;
-    hpatch_TFileStreamOutput newStream;
-    hpatch_TFileStreamInput_init(&oldStream);
-    hpatch_TFileStreamInput_init(&diffStream);
-    hpatch_TFileStreamOutput_init(&newStream);
+    DiffPayload diff;
+    diff.attach(&diffFile.stream.base);
+    hpatch_compressedDiffInfo diffInfo;
+    if (!getCompressedDiffInfo(&diffInfo, &diff.stream)) {
+        throw std::runtime_error("getCompressedDiffInfo() failed, invalid diff data!");
+    }
+    if (diffInfo.oldDataSize != oldFile.stream.base.streamSize) {
+        throw std::runtime_error("Old data size mismatch!");
+    }
+    check_compress_type(diffInfo);
 
-    bool oldOpened = false;
-    bool diffOpened = false;
-    bool newOpened = false;
+    newFile.open(outNewPath, diffInfo.newDataSize, "open new file for write failed.", io);
+    patch_compressed_payload(&newFile.stream.base, &oldFile.stream.base, diff, pipelined);
 
-    try {
-        if (!hpatch_TFileStreamInput_open(&oldStream, oldPath)) {
-            throw std::runtime_error("open old file failed.");
-        }
-        oldOpened = true;
-        if (!hpatch_TFileStreamInput_open(&diffStream, diffPath)) {
-            throw std::runtime_error("open diff file failed.");
-        }
-        diffOpened = true;
+    newFile.close("close new file failed.");
+    diffFile.close("close diff file failed.");
+    oldFile.close("close old file failed.");
+}
 
-        hpatch_compressedDiffInfo diffInfo;
-        if (!getCompressedDiffInfo(&diffInfo, &diffStream.base)) {
-            throw std::runtime_error("getCompressedDiffInfo() failed, invalid diff data!");
+void hpatch_chain(const char* oldPath,const std::vector<std::string>& diffPaths,
+                  const char* outNewPath,size_t maxMemory,
+                  const FileIoOptions& io){
+    if (!oldPath || !outNewPath) {
+        throw std::runtime_error("Invalid file path.");
+    }
+    if (diffPaths.empty()) {
+        throw std::runtime_error("patchChain: expected at least one diff.");
+    }
+
+    FileInputGuard oldFile;
+    oldFile.open(oldPath, "open old file failed.", io);
+
+    // 规划:先读全部文件头,校验每一跳的 old 尺寸与上一跳输出一致,
+    // 在真正写出任何数据前拒绝断链或基准不符的输入。
+    const size_t stageCount = diffPaths.size();
+    std::vector<ChainStage> stages(stageCount);
+    hpatch_StreamPos_t expectOldSize = oldFile.stream.base.streamSize;
+    for (size_t i = 0; i < stageCount; ++i) {
+        // 规划时格式未知,diff 一律按随机访问打开
+        stages[i].diff.open(diffPaths[i].c_str(), "open diff file failed.", io);
+        read_chain_stage_info(stages[i]);
+        if (stages[i].oldDataSize != expectOldSize) {
+            throw std::runtime_error("patchChain: old data size mismatch at diff #" +
+                                     std::to_string(i) + "!");
         }
-        if (diffInfo.oldDataSize != oldStream.base.streamSize) {
-            throw std::runtime_error("Old data size mismatch!");
+        expectOldSize = stages[i].newDataSize;
+    }
+
+    // 每一跳随机读上一跳的完整输出,因此中间结果必须可随机访问。
+    // 同一时刻最多存活两份中间结果(本跳输入与输出),两者之和不超过
+    // maxMemory 时放在内存,否则落盘到 outNewPath 旁的临时文件。
+    TempFilesGuard tempFiles;
+    for (size_t i = 0; i + 1 < stageCount; ++i) {
+        ChainStage& stage = stages[i];
+        const hpatch_StreamPos_t liveInput =
+            (i > 0 && stages[i - 1].keepInMemory) ? stages[i - 1].newDataSize : 0;
+        stage.keepInMemory =
+            (stage.newDataSize <= (hpatch_StreamPos_t)maxMemory) &&
+            (liveInput <= (hpatch_StreamPos_t)maxMemory - stage.newDataSize);
+        if (!stage.keepInMemory) {
+            stage.tempPath = std::string(outNewPath) + ".chain" + std::to_string(i) + ".tmp";
+            tempFiles.paths.push_back(stage.tempPath);
         }
-        if (decompressPlugin && !decompressPlugin->is_can_open(diffInfo.compressType)) {
-            throw std::runtime_error("Unsupported diff compress type.");
+    }
+
+    PatchBuffer inputMem;
+    PatchBuffer outputMem;
+    FileInputGuard inputFile;
+    hpatch_TStreamInput memInput;
+    const hpatch_TStreamInput* input = &oldFile.stream.base;
+    for (size_t i = 0; i < stageCount; ++i) {
+        ChainStage& stage = stages[i];
+        const bool isLast = (i + 1 == stageCount);
+
+        hpatch_TStreamOutput memOutput;
+        FileOutputGuard outputFile;
+        const hpatch_TStreamOutput* output = nullptr;
+        if (!isLast && stage.keepInMemory) {
+            outputMem.resize((size_t)stage.newDataSize);
+            output = mem_as_hStreamOutput(&memOutput, outputMem.data(),
+                                          outputMem.data() + outputMem.size());
+        } else {
+            const char* path = isLast ? outNewPath : stage.tempPath.c_str();
+            outputFile.open(path, stage.isSingle ? ~(hpatch_StreamPos_t)0 : stage.newDataSize,
+                            "open new file for write failed.", io);
+            output = &outputFile.stream.base;
         }
 
-        if (!hpatch_TFileStreamOutput_open(&newStream, outNewPath, diffInfo.newDataSize)) {
-            throw std::runtime_error("open new file for write failed.");
+        if (stage.isSingle) {
+            patch_single_payload(output, input, stage.payload);
+        } else {
+            patch_compressed_payload(output, input, stage.payload);
         }
-        newOpened = true;
+        outputFile.close("close new file failed.");
+        stage.diff.close("close diff file failed.");
 
-        if (!patch_decompress(&newStream.base, &oldStream.base, &diffStream.base, decompressPlugin)) {
-            throw std::runtime_error("patch_decompress() failed!");
+        // 本跳输出成为下一跳的 old;上一份中间结果随即释放
+        inputFile.close("close old file failed.");
+        if (i == 0) oldFile.close("close old file failed.");
+        if (isLast) break;
+        if (stage.keepInMemory) {
+            inputMem.swap(outputMem);
+            PatchBuffer().swap(outputMem);
+            input = mem_as_hStreamInput(&memInput, inputMem.data(),
+                                        inputMem.data() + inputMem.size());
+        } else {
+            PatchBuffer().swap(inputMem);
+            inputFile.open(stage.tempPath.c_str(), "open old file failed.", io);
+            input = &inputFile.stream.base;
         }
-    } catch (...) {
-        if (newOpened) hpatch_TFileStreamOutput_close(&newStream);
-        if (diffOpened) hpatch_TFileStreamInput_close(&diffStream);
-        if (oldOpened) hpatch_TFileStreamInput_close(&oldStream);
-        throw;
     }
+}
 
-    if (newOpened && !hpatch_TFileStreamOutput_close(&newStream)) {
-        throw std::runtime_error("close new file failed.");
-    }
-    if (diffOpened && !hpatch_TFileStreamInput_close(&diffStream)) {
-        throw std::runtime_error("close diff file failed.");
-    }
-    if (oldOpened && !hpatch_TFileStreamInput_close(&oldStream)) {
-        throw std::runtime_error("close old file failed.");
+void hpatch_file(const char* oldPath,const char* diffPath,const char* outNewPath){
+    if (!diffPath) {
+        throw std::runtime_error("Invalid file path.");
     }
+    // 单跳 chain:头部识别与尺寸检查复用 patchChain 的规划逻辑,结果直接写 outNewPath
+    hpatch_chain(oldPath, std::vector<std::string>(1, diffPath), outNewPath, 0);
 }
@@ -7,12 +7,63 @@
 #define HDIFFPATCH_PATCH_H
 #include <stddef.h>
 #include <stdint.h>
+#include <string>
 #include <vector>
+#include "patch_buffer.h"
+#include "file_stream.h"
 
+// out_newBuf 不预先清零,patch 成功时被完整写满
 void hpatch(const uint8_t* old, size_t oldsize,
             const uint8_t* diff, size_t diffsize,
-            std::vector<uint8_t>& out_newBuf);
-void hpatch_single_stream(const char* oldPath,const char* diffPath,const char* outNewPath);
-void hpatch_stream(const char* oldPath,const char* diffPath,const char* outNewPath);
+            PatchBuffer& out_newBuf);
+// 只解析 diff 头,返回 new 的字节数(old 尺寸不符等错误与 hpatch() 一致)
+size_t hpatch_new_size(size_t oldsize, const uint8_t* diff, size_t diffsize);
+// 写入调用方提供的 out_new(容量须不小于 new 尺寸),返回写出的字节数。
+// tempCache 由调用方持有并可跨调用复用,容量足够时不再分配内存。
+size_t hpatch_into(const uint8_t* old, size_t oldsize,
+                   const uint8_t* diff, size_t diffsize,
+                   uint8_t* out_new, size_t outCapacity,
+                   PatchBuffer& tempCache);
+// 只生成 new 的 [offset, offset + length) 写入 out_range(HDIFFSF20,与 hpatch() 相同)。
+// new 按顺序解码,范围之前的字节直接丢弃,范围写满后立即停止:内存只随 length
+// 增长,耗时随 offset + length 增长。带校验尾部时只校验 old(new 未完整生成)。
+void hpatch_range(const uint8_t* old, size_t oldsize,
+                  const uint8_t* diff, size_t diffsize,
+                  uint64_t offset, size_t length,
+                  PatchBuffer& out_range);
+// 同上,写入调用方提供的 out(容量须不小于 length),返回写出的字节数
+size_t hpatch_range_into(const uint8_t* old, size_t oldsize,
+                         const uint8_t* diff, size_t diffsize,
+                         uint64_t offset, size_t length,
+                         uint8_t* out, size_t outCapacity);
+// 文件模式的 io 控制读写方式(见 file_stream.h),默认走 file_for_patch
+void hpatch_single_stream(const char* oldPath,const char* diffPath,const char* outNewPath,
+                          const FileIoOptions& io=FileIoOptions());
+// pipelined 为 true 时每个压缩子流由独立线程提前解压(见 pipelined_decompress.h),
+// 输出与串行路径相同
+void hpatch_stream(const char* oldPath,const char* diffPath,const char* outNewPath,
+                   const FileIoOptions& io=FileIoOptions(),bool pipelined=false);
+// 依次应用多个 diff(HDIFFSF20 与 HDIFF13 可混用),中间结果不超过
+// maxMemory 时留在内存,否则落盘到 outNewPath 旁的临时文件并在结束后删除。
+void hpatch_chain(const char* oldPath,const std::vector<std::string>& diffPaths,
+                  const char* outNewPath,size_t maxMemory,
+                  const FileIoOptions& io=FileIoOptions());
+// diff 文件头信息与 patch 所需的原生内存,不执行 patch
+struct HpatchDiffInfo {
+    bool isSingle = false;          // HDIFFSF20;否则为 HDIFF13
+    bool hasChecksum = false;       // 带 diff_checksum 尾部
+    uint64_t oldDataSize = 0;
+    uint64_t newDataSize = 0;
+    uint64_t stepMemSize = 0;       // 仅 HDIFFSF20
+    std::string compressType;       // 空串表示未压缩
+    uint64_t workMemory = 0;        // 本库为 patch 分配的工作区(tempCache)
+    uint64_t decoderMemory = 0;     // 解压插件的字典与概率表
+    bool decoderMemoryExact = true; // HDIFF13 的字典按本库产物的 8MB 估算
+};
+HpatchDiffInfo hpatch_diff_info(const uint8_t* diff, size_t diffsize);
+HpatchDiffInfo hpatch_diff_info(const char* diffPath);
+
+// 按文件头自动识别 HDIFFSF20 / HDIFF13 并应用
+void hpatch_file(const char* oldPath,const char* diffPath,const char* outNewPath);
 
 #endif
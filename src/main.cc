@@ -4,17 +4,36 @@
  * Created by housisong on 2021.04.07, refactored 2026.01.20
  */
 #include <napi.h>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <limits>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
+#include "buffer_arena.h"
+#include "byte_compare.h"
+#include "cpu_dispatch.h"
+#include "diff_cache.h"
+#include "feed_stream.h"
 #include "hdiff.h"
 #include "hpatch.h"
+#include "native_memory.h"
+#include "parallel.h"
 
 namespace hdiffpatchNode
 {
-    // Helper: 从参数获取数据指针和长度（支持 Buffer 和 TypedArray）
+    // Helper: 从参数获取数据指针和长度
+    // 支持 Buffer、TypedArray、DataView、ArrayBuffer 与 SharedArrayBuffer。
+    // TypedArray 直接取视图的数据指针:TypedArray::ArrayBuffer().Data() 经
+    // napi_get_arraybuffer_info,对 SharedArrayBuffer 背后的视图会失败。
     inline bool getBufferData(const Napi::Value& arg, const uint8_t** data, size_t* length) {
         if (arg.IsBuffer()) {
             Napi::Buffer<uint8_t> buf = arg.As<Napi::Buffer<uint8_t>>();
@@ -23,24 +42,74 @@ namespace hdiffpatchNode
             return true;
         }
         if (arg.IsTypedArray()) {
-            Napi::TypedArray typedArray = arg.As<Napi::TypedArray>();
-            Napi::ArrayBuffer arrayBuffer = typedArray.ArrayBuffer();
-            *data = static_cast<const uint8_t*>(arrayBuffer.Data()) + typedArray.ByteOffset();
-            *length = typedArray.ByteLength();
+            void* base = nullptr;
+            if (napi_get_typedarray_info(arg.Env(), arg, nullptr, nullptr, &base, nullptr,
+                                         nullptr) != napi_ok) {
+                return false;
+            }
+            *data = static_cast<const uint8_t*>(base);  // 已含 byteOffset
+            *length = arg.As<Napi::TypedArray>().ByteLength();
+            return true;
+        }
+        if (arg.IsDataView()) {
+            void* base = nullptr;
+            size_t byteLength = 0;
+            if (napi_get_dataview_info(arg.Env(), arg, &byteLength, &base, nullptr,
+                                       nullptr) != napi_ok) {
+                return false;
+            }
+            *data = static_cast<const uint8_t*>(base);
+            *length = byteLength;
+            return true;
+        }
+        if (arg.IsArrayBuffer()) {
+            Napi::ArrayBuffer arrayBuffer = arg.As<Napi::ArrayBuffer>();
+            *data = static_cast<const uint8_t*>(arrayBuffer.Data());
+            *length = arrayBuffer.ByteLength();
             return true;
         }
+        if (arg.IsObject() && !arg.IsFunction()) {
+            // Node-API 没有 SharedArrayBuffer 的取址接口:借一个 Uint8Array 视图。
+            // 视图与参数共享同一后备存储,调用方持有参数引用即可保证其存活
+            Napi::Env env = arg.Env();
+            Napi::Value sharedCtor = env.Global().Get("SharedArrayBuffer");
+            if (sharedCtor.IsFunction() &&
+                arg.As<Napi::Object>().InstanceOf(sharedCtor.As<Napi::Function>())) {
+                Napi::Function uint8Ctor = env.Global().Get("Uint8Array").As<Napi::Function>();
+                return getBufferData(uint8Ctor.New({arg}), data, length);
+            }
+        }
         return false;
     }
 
+    inline bool isBinaryArg(const Napi::Value& arg) {
+        const uint8_t* data = nullptr;
+        size_t length = 0;
+        return getBufferData(arg, &data, &length);
+    }
+
     inline bool getStringUtf8(const Napi::Value& arg, std::string& out) {
         if (!arg.IsString()) return false;
         out = arg.As<Napi::String>().Utf8Value();
         return true;
     }
 
+    const size_t kDefaultChainMaxMemory = (size_t)256 * 1024 * 1024;
+    const size_t kMaxPatchManyThreads = 64;
+    // 每个 diff 任务各建一份后缀索引(4–8 倍 old),并发上限远低于 patch
+    const size_t kMaxDiffThreads = 16;
+    const size_t kMinIoBufferSize = 4 * 1024;
+    const size_t kMaxIoBufferSize = (size_t)256 * 1024 * 1024;
+    const size_t kMaxIoQueueDepth = 64;
+
     struct NativeDiffOptions {
         size_t compressionThreads = 1;
         size_t windowSize = 0;
+        bool checksum = false;
+        bool trimIdentical = false;
+        size_t maxIndexMemory = 0;
+        FileIoOptions io;
+        DiffCacheOptions cache;
     };
 
     inline bool parseIntegerOption(const Napi::Value& value,
@@ -58,16 +127,105 @@ namespace hdiffpatchNode
         return true;
     }
 
+    // io: { bufferSize?, queueDepth?, dropBehind? },启用预读/后写文件流(见 file_stream.h)
+    inline bool parseIoOptions(Napi::Env env, const Napi::Value& value, FileIoOptions& out) {
+        if (!value.IsObject() || value.IsFunction()) {
+            Napi::TypeError::New(env, "Invalid io: expected { bufferSize, queueDepth, dropBehind }.")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        Napi::Object io = value.As<Napi::Object>();
+        out.bufferSize = kDefaultIoBufferSize;
+        out.queueDepth = kDefaultIoQueueDepth;
+        if (io.Has("bufferSize") &&
+            !parseIntegerOption(io.Get("bufferSize"), kMinIoBufferSize, kMaxIoBufferSize,
+                                out.bufferSize)) {
+            Napi::TypeError::New(env, "Invalid io.bufferSize: expected an integer within 4KB..256MB.")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        if (io.Has("queueDepth") &&
+            !parseIntegerOption(io.Get("queueDepth"), 1, kMaxIoQueueDepth, out.queueDepth)) {
+            Napi::TypeError::New(env, "Invalid io.queueDepth: expected an integer within 1..64.")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        if (io.Has("dropBehind")) {
+            Napi::Value dropBehind = io.Get("dropBehind");
+            if (!dropBehind.IsBoolean()) {
+                Napi::TypeError::New(env, "Invalid io.dropBehind: expected a boolean.")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            out.dropBehind = dropBehind.As<Napi::Boolean>().Value();
+        }
+        return true;
+    }
+
+    // 文件模式共用的 io / mmap 选项,写入同一个 FileIoOptions
+    inline bool parseFileIoOptions(Napi::Env env, const Napi::Object& options, FileIoOptions& out) {
+        if (options.Has("io") && !parseIoOptions(env, options.Get("io"), out)) {
+            return false;
+        }
+        if (options.Has("mmap")) {
+            Napi::Value mmap = options.Get("mmap");
+            if (!mmap.IsBoolean()) {
+                Napi::TypeError::New(env, "Invalid mmap: expected a boolean.")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            out.mmap = mmap.As<Napi::Boolean>().Value();
+        }
+        return true;
+    }
+
+    // patchStream()/patchSingleStream() 的选项:io 与 mmap;
+    // pipelined 只对 HDIFF13(patchStream)有意义,其余调用传 nullptr 拒绝
+    inline bool parsePatchFileOptions(Napi::Env env, const Napi::Value& value, FileIoOptions& out,
+                                      bool* outPipelined = nullptr) {
+        if (!value.IsObject() || value.IsFunction()) {
+            Napi::TypeError::New(env, "Invalid patch options: expected an object.")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        Napi::Object options = value.As<Napi::Object>();
+        if (options.Has("pipelined")) {
+            Napi::Value pipelined = options.Get("pipelined");
+            if (!outPipelined) {
+                Napi::TypeError::New(env, "pipelined is only supported by patchStream().")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            if (!pipelined.IsBoolean()) {
+                Napi::TypeError::New(env, "Invalid pipelined: expected a boolean.")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            *outPipelined = pipelined.As<Napi::Boolean>().Value();
+        }
+        return parseFileIoOptions(env, options, out);
+    }
+
+    // allowOut:调用方自己读取 out(见 parseOutOption);其余入口不返回单个
+    // Buffer,给出 out 时报错而不是悄悄忽略
     inline bool parseDiffOptions(Napi::Env env,
                                  const Napi::Value& value,
                                  bool allowWindowSize,
-                                 NativeDiffOptions& out) {
+                                 NativeDiffOptions& out,
+                                 bool allowBufferOptions = false,
+                                 bool allowOut = false) {
         if (!value.IsObject() || value.IsFunction()) {
             Napi::TypeError::New(env, "Invalid diff options: expected an object.")
                 .ThrowAsJavaScriptException();
             return false;
         }
         Napi::Object options = value.As<Napi::Object>();
+        if (!allowOut && options.Has("out") && !options.Get("out").IsUndefined()) {
+            Napi::TypeError::New(env, "out is only supported by diff() and the Buffer forms "
+                                      "of diffSingleStream() and diffWindow().")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
         if (options.Has("compressionThreads")) {
             size_t threads = 0;
             if (!parseIntegerOption(options.Get("compressionThreads"), 1, 2, threads)) {
@@ -92,46 +250,287 @@ namespace hdiffpatchNode
             }
             out.windowSize = windowSize;
         }
+        if (!allowBufferOptions) {
+            // 只对 diff() 的内存引擎有意义的选项
+            for (const char* name : {"trimIdentical", "maxIndexMemory"}) {
+                if (options.Has(name)) {
+                    Napi::TypeError::New(env, std::string(name) +
+                                         " is only supported by diff() and diffFile().")
+                        .ThrowAsJavaScriptException();
+                    return false;
+                }
+            }
+        } else {
+            // diff()/diffFile() 整块读入或映射输入,不经过文件流
+            for (const char* name : {"io", "mmap"}) {
+                if (options.Has(name)) {
+                    Napi::TypeError::New(env, std::string(name) +
+                                         " is only supported by the streaming file diffs.")
+                        .ThrowAsJavaScriptException();
+                    return false;
+                }
+            }
+        }
+        if (!parseFileIoOptions(env, options, out.io)) {
+            return false;
+        }
+        if (options.Has("trimIdentical")) {
+            Napi::Value trimIdentical = options.Get("trimIdentical");
+            if (!trimIdentical.IsBoolean()) {
+                Napi::TypeError::New(env, "Invalid trimIdentical: expected a boolean.")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            out.trimIdentical = trimIdentical.As<Napi::Boolean>().Value();
+        }
+        if (options.Has("maxIndexMemory")) {
+            size_t maxIndexMemory = 0;
+            if (!parseIntegerOption(options.Get("maxIndexMemory"), 0,
+                                    std::numeric_limits<size_t>::max(), maxIndexMemory)) {
+                Napi::TypeError::New(env, "Invalid maxIndexMemory: expected a non-negative integer.")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            // 低于默认窗口的索引时无法守住预算,直接拒绝
+            if (maxIndexMemory != 0 && maxIndexMemory < hdiff_min_index_memory()) {
+                Napi::TypeError::New(env, "Invalid maxIndexMemory: expected 0 or at least " +
+                                      std::to_string(hdiff_min_index_memory()) +
+                                      " bytes (the index of the smallest window).")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            out.maxIndexMemory = maxIndexMemory;
+        }
+        if (options.Has("checksum")) {
+            Napi::Value checksum = options.Get("checksum");
+            if (!checksum.IsBoolean()) {
+                Napi::TypeError::New(env, "Invalid checksum: expected a boolean.")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            out.checksum = checksum.As<Napi::Boolean>().Value();
+        }
+        if (options.Has("cache")) {
+            Napi::Value cacheValue = options.Get("cache");
+            if (!cacheValue.IsObject() || cacheValue.IsFunction()) {
+                Napi::TypeError::New(env, "Invalid cache: expected { dir[, maxBytes] }.")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            Napi::Object cache = cacheValue.As<Napi::Object>();
+            if (!getStringUtf8(cache.Get("dir"), out.cache.dir) || out.cache.dir.empty()) {
+                Napi::TypeError::New(env, "Invalid cache.dir: expected a non-empty string.")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            if (cache.Has("maxBytes")) {
+                size_t maxBytes = 0;
+                if (!parseIntegerOption(cache.Get("maxBytes"), 0,
+                                        std::numeric_limits<size_t>::max(), maxBytes)) {
+                    Napi::TypeError::New(env, "Invalid cache.maxBytes: expected a non-negative integer.")
+                        .ThrowAsJavaScriptException();
+                    return false;
+                }
+                out.cache.maxBytes = maxBytes;
+            }
+        }
         return true;
     }
 
-    inline Napi::Buffer<uint8_t> bufferFromVector(Napi::Env env, std::vector<uint8_t>&& data) {
+    // 原生内存对 V8 不可见,GC 只按 JS 堆大小决定时机:这里把字节同时记入
+    // native_memory 统计并用 napi_adjust_external_memory 上报
+    inline void adjustExternalMemory(napi_env env, int64_t delta) {
+        int64_t adjusted = 0;
+        napi_adjust_external_memory(env, delta, &adjusted);
+    }
+
+    // 任务运行期间的工作集估算:构造(JS 线程)时上报,析构时撤回。
+    // AsyncWorker 在 JS 线程上析构,因此可作为 worker 成员随任务结束释放。
+    class ExternalMemoryCharge {
+    public:
+        ExternalMemoryCharge(Napi::Env env, NativeMemoryKind kind, uint64_t bytes)
+            : env_(env), kind_(kind), bytes_(bytes) {
+            native_memory_add(kind_, bytes_);
+            adjustExternalMemory(env_, (int64_t)bytes_);
+        }
+        ~ExternalMemoryCharge() {
+            native_memory_sub(kind_, bytes_);
+            adjustExternalMemory(env_, -(int64_t)bytes_);
+        }
+        ExternalMemoryCharge(const ExternalMemoryCharge&) = delete;
+        ExternalMemoryCharge& operator=(const ExternalMemoryCharge&) = delete;
+
+    private:
+        napi_env env_;
+        NativeMemoryKind kind_;
+        uint64_t bytes_;
+    };
+
+    // patch 任务:new 缓冲 + 工作区 + 解压字典;diff 无法解析时记 0,错误留给 hpatch 报告
+    inline uint64_t patchMemoryEstimate(const uint8_t* diffData, size_t diffLen) {
+        try {
+            const HpatchDiffInfo diffInfo = hpatch_diff_info(diffData, diffLen);
+            return diffInfo.newDataSize + diffInfo.workMemory + diffInfo.decoderMemory;
+        } catch (const std::exception&) {
+            return 0;
+        }
+    }
+
+    // 结果 Buffer 由 vector 直接接管(不拷贝),其字节计入 Result 直到被 GC 回收
+    template <class Alloc>
+    inline Napi::Buffer<uint8_t> bufferFromVector(Napi::Env env,
+                                                  std::vector<uint8_t, Alloc>&& data) {
+        typedef std::vector<uint8_t, Alloc> Vector;
         if (data.empty()) {
             return Napi::Buffer<uint8_t>::New(env, 0);
         }
-        auto* vec = new std::vector<uint8_t>(std::move(data));
+        auto* vec = new Vector(std::move(data));
+        const uint64_t size = vec->size();
+        native_memory_add(NativeMemoryKind::Result, size);
+        adjustExternalMemory(env, (int64_t)size);
         return Napi::Buffer<uint8_t>::New(
             env,
             vec->data(),
             vec->size(),
-            [](Napi::Env /*env*/, uint8_t* /*data*/, std::vector<uint8_t>* vecPtr) {
+            [](Napi::Env env, uint8_t* /*data*/, Vector* vecPtr) {
+                const uint64_t size = vecPtr->size();
                 delete vecPtr;
+                native_memory_sub(NativeMemoryKind::Result, size);
+                adjustExternalMemory(env, -(int64_t)size);
             },
             vec
         );
     }
 
+    // 内存输入可选的引擎:diff() 的内存版,或 diffSingleStream()/diffWindow()
+    // 的流式匹配器直接作用于 Buffer(不落临时文件)
+    enum class DiffEngine {
+        Memory,
+        SingleStream,
+        Window,
+    };
+
+    inline uint64_t diffMemoryEstimate(DiffEngine engine, const NativeDiffOptions& options,
+                                       size_t oldLen, size_t newLen) {
+        switch (engine) {
+            case DiffEngine::SingleStream:
+                return hdiff_single_stream_memory_estimate(oldLen, newLen);
+            case DiffEngine::Window:
+                return hdiff_window_memory_estimate(newLen, options.windowSize);
+            default:
+                return hdiff_memory_estimate(oldLen, newLen, options.maxIndexMemory);
+        }
+    }
+
+    inline void runBufferDiff(DiffEngine engine, const NativeDiffOptions& options,
+                              const uint8_t* oldData, size_t oldLen,
+                              const uint8_t* newData, size_t newLen,
+                              std::vector<uint8_t>& out) {
+        switch (engine) {
+            case DiffEngine::SingleStream:
+                hdiff_single_stream_cached(options.cache, oldData, oldLen, newData, newLen, out,
+                                           options.compressionThreads, options.checksum);
+                break;
+            case DiffEngine::Window:
+                hdiff_window_cached(options.cache, oldData, oldLen, newData, newLen, out,
+                                    options.windowSize, options.compressionThreads,
+                                    options.checksum);
+                break;
+            default:
+                hdiff_cached(options.cache, oldData, oldLen, newData, newLen, out,
+                             options.compressionThreads, options.checksum,
+                             options.trimIdentical, options.maxIndexMemory);
+                break;
+        }
+    }
+
+    // Buffer 输入的 diff 选项:windowSize 只给 window 引擎,trimIdentical/
+    // maxIndexMemory 只给内存版;io/mmap 只对文件路径有意义
+    inline bool parseBufferDiffOptions(Napi::Env env, const Napi::Value& value,
+                                       DiffEngine engine, NativeDiffOptions& out,
+                                       bool allowOut = false) {
+        if (value.IsObject() && !value.IsFunction() && engine != DiffEngine::Memory) {
+            Napi::Object raw = value.As<Napi::Object>();
+            for (const char* name : {"io", "mmap"}) {
+                if (raw.Has(name)) {
+                    Napi::TypeError::New(env, std::string(name) +
+                                         " is only supported with file paths.")
+                        .ThrowAsJavaScriptException();
+                    return false;
+                }
+            }
+        }
+        return parseDiffOptions(env, value, engine == DiffEngine::Window, out,
+                                engine == DiffEngine::Memory, allowOut);
+    }
+
+    // 调用方提供的输出区(Buffer/TypedArray/ArrayBuffer/SharedArrayBuffer)
+    struct OutputRegion {
+        bool enabled = false;
+        uint8_t* data = nullptr;
+        size_t length = 0;
+    };
+
+    inline bool getOutputRegion(const Napi::Value& arg, OutputRegion& out) {
+        const uint8_t* data = nullptr;
+        if (!getBufferData(arg, &data, &out.length)) return false;
+        out.data = const_cast<uint8_t*>(data);
+        out.enabled = true;
+        return true;
+    }
+
+    // diff 选项里的 out;未给出时 out.enabled 为 false
+    inline bool parseOutOption(Napi::Env env, const Napi::Value& options,
+                               Napi::Value& outValue, OutputRegion& out) {
+        Napi::Object raw = options.As<Napi::Object>();
+        if (!raw.Has("out") || raw.Get("out").IsUndefined()) return true;
+        outValue = raw.Get("out");
+        if (!getOutputRegion(outValue, out)) {
+            Napi::TypeError::New(env, "Invalid out: expected Buffer, TypedArray, ArrayBuffer or SharedArrayBuffer.")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    // diff 的尺寸事先未知:编码完成后整体拷入 out,容量不足时报错且不写 out
+    inline void copyToOutput(const std::vector<uint8_t>& result, const OutputRegion& out) {
+        if (result.size() > out.length) {
+            throw std::runtime_error("Output buffer too small: need " +
+                                     std::to_string(result.size()) + " bytes.");
+        }
+        if (!result.empty()) std::memcpy(out.data, result.data(), result.size());
+    }
+
     // ============ 异步 Diff Worker ============
     class DiffAsyncWorker : public Napi::AsyncWorker {
     public:
         DiffAsyncWorker(Napi::Function& callback,
                         const Napi::Value& oldValue, const uint8_t* oldData, size_t oldLen,
                         const Napi::Value& newValue, const uint8_t* newData, size_t newLen,
-                        size_t compressionThreads)
+                        NativeDiffOptions options,
+                        DiffEngine engine = DiffEngine::Memory,
+                        const Napi::Value& outValue = Napi::Value(),
+                        OutputRegion out = OutputRegion())
             : Napi::AsyncWorker(callback),
+              engine_(engine),
+              charge_(callback.Env(), NativeMemoryKind::Diff,
+                      diffMemoryEstimate(engine, options, oldLen, newLen)),
               oldData_(oldData),
               oldLen_(oldLen),
               newData_(newData),
               newLen_(newLen),
-              compressionThreads_(compressionThreads),
+              options_(std::move(options)),
+              out_(out),
               oldRef_(Napi::Persistent(oldValue)),
               newRef_(Napi::Persistent(newValue)) {
+            if (out_.enabled) outRef_ = Napi::Persistent(outValue);
         }
 
         void Execute() override {
             try {
-                hdiff(oldData_, oldLen_,
-                      newData_, newLen_, result_, compressionThreads_);
+                runBufferDiff(engine_, options_, oldData_, oldLen_, newData_, newLen_, result_);
+                if (out_.enabled) copyToOutput(result_, out_);
             } catch (const std::exception& e) {
                 SetError(e.what());
             }
@@ -140,50 +539,112 @@ namespace hdiffpatchNode
         void OnOK() override {
             Napi::Env env = Env();
             Napi::HandleScope scope(env);
-            Napi::Buffer<uint8_t> resultBuf = bufferFromVector(env, std::move(result_));
-            Callback().Call({env.Null(), resultBuf});
-            oldRef_.Reset();
-            newRef_.Reset();
+            if (out_.enabled) {
+                Callback().Call({env.Null(), Napi::Number::New(env, static_cast<double>(result_.size()))});
+            } else {
+                Napi::Buffer<uint8_t> resultBuf = bufferFromVector(env, std::move(result_));
+                Callback().Call({env.Null(), resultBuf});
+            }
+            Release();
         }
 
         void OnError(const Napi::Error& e) override {
             Napi::Env env = Env();
             Napi::HandleScope scope(env);
             Callback().Call({e.Value()});
+            Release();
+        }
+
+    private:
+        void Release() {
             oldRef_.Reset();
             newRef_.Reset();
+            outRef_.Reset();
         }
 
-    private:
+        DiffEngine engine_;
+        ExternalMemoryCharge charge_;
         const uint8_t* oldData_;
         size_t oldLen_;
         const uint8_t* newData_;
         size_t newLen_;
-        size_t compressionThreads_;
+        NativeDiffOptions options_;
+        OutputRegion out_;
         Napi::Reference<Napi::Value> oldRef_;
         Napi::Reference<Napi::Value> newRef_;
+        Napi::Reference<Napi::Value> outRef_;
         std::vector<uint8_t> result_;
     };
 
+    // patchRange() 的输出区间;enabled 为 false 时生成整个 new
+    struct PatchRange {
+        bool enabled = false;
+        uint64_t offset = 0;
+        size_t length = 0;
+    };
+
+    // 区间 patch 不分配整个 new:工作区 + 解压字典 + 区间本身
+    inline uint64_t patchRangeMemoryEstimate(const uint8_t* diffData, size_t diffLen,
+                                             const PatchRange& range) {
+        try {
+            const HpatchDiffInfo diffInfo = hpatch_diff_info(diffData, diffLen);
+            return diffInfo.workMemory + diffInfo.decoderMemory + range.length;
+        } catch (const std::exception&) {
+            return 0;
+        }
+    }
+
+    // 写入调用方输出区时不分配 new:只有工作区 + 解压字典
+    inline uint64_t patchIntoMemoryEstimate(const uint8_t* diffData, size_t diffLen) {
+        try {
+            const HpatchDiffInfo diffInfo = hpatch_diff_info(diffData, diffLen);
+            return diffInfo.workMemory + diffInfo.decoderMemory;
+        } catch (const std::exception&) {
+            return 0;
+        }
+    }
+
     // ============ 异步 Patch Worker ============
     class PatchAsyncWorker : public Napi::AsyncWorker {
     public:
         PatchAsyncWorker(Napi::Function& callback,
                          const Napi::Value& oldValue, const uint8_t* oldData, size_t oldLen,
-                         const Napi::Value& diffValue, const uint8_t* diffData, size_t diffLen)
+                         const Napi::Value& diffValue, const uint8_t* diffData, size_t diffLen,
+                         PatchRange range = PatchRange(),
+                         const Napi::Value& outValue = Napi::Value(),
+                         OutputRegion out = OutputRegion())
             : Napi::AsyncWorker(callback),
+              charge_(callback.Env(), NativeMemoryKind::Patch,
+                      range.enabled ? patchRangeMemoryEstimate(diffData, diffLen, range)
+                      : out.enabled ? patchIntoMemoryEstimate(diffData, diffLen)
+                                    : patchMemoryEstimate(diffData, diffLen)),
               oldData_(oldData),
               oldLen_(oldLen),
               diffData_(diffData),
               diffLen_(diffLen),
+              range_(range),
+              out_(out),
               oldRef_(Napi::Persistent(oldValue)),
               diffRef_(Napi::Persistent(diffValue)) {
+            if (out_.enabled) outRef_ = Napi::Persistent(outValue);
         }
 
         void Execute() override {
             try {
-                hpatch(oldData_, oldLen_,
-                       diffData_, diffLen_, result_);
+                if (range_.enabled && out_.enabled) {
+                    written_ = hpatch_range_into(oldData_, oldLen_, diffData_, diffLen_,
+                                                 range_.offset, range_.length,
+                                                 out_.data, out_.length);
+                } else if (range_.enabled) {
+                    hpatch_range(oldData_, oldLen_, diffData_, diffLen_,
+                                 range_.offset, range_.length, result_);
+                } else if (out_.enabled) {
+                    written_ = hpatch_into(oldData_, oldLen_, diffData_, diffLen_,
+                                           out_.data, out_.length, result_);
+                } else {
+                    hpatch(oldData_, oldLen_,
+                           diffData_, diffLen_, result_);
+                }
             } catch (const std::exception& e) {
                 SetError(e.what());
             }
@@ -192,28 +653,42 @@ namespace hdiffpatchNode
         void OnOK() override {
             Napi::Env env = Env();
             Napi::HandleScope scope(env);
-            Napi::Buffer<uint8_t> resultBuf = bufferFromVector(env, std::move(result_));
-            Callback().Call({env.Null(), resultBuf});
-            oldRef_.Reset();
-            diffRef_.Reset();
+            if (out_.enabled) {
+                Callback().Call({env.Null(), Napi::Number::New(env, static_cast<double>(written_))});
+            } else {
+                Napi::Buffer<uint8_t> resultBuf = bufferFromVector(env, std::move(result_));
+                Callback().Call({env.Null(), resultBuf});
+            }
+            Release();
         }
 
         void OnError(const Napi::Error& e) override {
             Napi::Env env = Env();
             Napi::HandleScope scope(env);
             Callback().Call({e.Value()});
+            Release();
+        }
+
+    private:
+        void Release() {
             oldRef_.Reset();
             diffRef_.Reset();
+            outRef_.Reset();
         }
 
-    private:
+        ExternalMemoryCharge charge_;
         const uint8_t* oldData_;
         size_t oldLen_;
         const uint8_t* diffData_;
         size_t diffLen_;
+        PatchRange range_;
+        OutputRegion out_;
+        size_t written_ = 0;
         Napi::Reference<Napi::Value> oldRef_;
         Napi::Reference<Napi::Value> diffRef_;
-        std::vector<uint8_t> result_;
+        Napi::Reference<Napi::Value> outRef_;
+        // 写入 out 时作为工作区,否则为结果
+        PatchBuffer result_;
     };
 
     // ============ 异步 Stream Diff Worker ============
@@ -223,18 +698,19 @@ namespace hdiffpatchNode
                               std::string oldPath,
                               std::string newPath,
                               std::string outDiffPath,
-                              size_t compressionThreads)
+                              NativeDiffOptions options)
             : Napi::AsyncWorker(callback),
               oldPath_(std::move(oldPath)),
               newPath_(std::move(newPath)),
               outDiffPath_(std::move(outDiffPath)),
-              compressionThreads_(compressionThreads) {
+              options_(std::move(options)) {
         }
 
         void Execute() override {
             try {
-                hdiff_stream(oldPath_.c_str(), newPath_.c_str(), outDiffPath_.c_str(),
-                             compressionThreads_);
+                hdiff_stream_cached(options_.cache, oldPath_.c_str(), newPath_.c_str(),
+                                    outDiffPath_.c_str(), options_.compressionThreads,
+                                    options_.checksum, options_.io);
             } catch (const std::exception& e) {
                 SetError(e.what());
             }
@@ -256,7 +732,7 @@ namespace hdiffpatchNode
         std::string oldPath_;
         std::string newPath_;
         std::string outDiffPath_;
-        size_t compressionThreads_;
+        NativeDiffOptions options_;
     };
 
     // ============ 异步 Stream Patch Worker ============
@@ -265,16 +741,21 @@ namespace hdiffpatchNode
         PatchStreamAsyncWorker(Napi::Function& callback,
                                std::string oldPath,
                                std::string diffPath,
-                               std::string outNewPath)
+                               std::string outNewPath,
+                               FileIoOptions io,
+                               bool pipelined)
             : Napi::AsyncWorker(callback),
               oldPath_(std::move(oldPath)),
               diffPath_(std::move(diffPath)),
-              outNewPath_(std::move(outNewPath)) {
+              outNewPath_(std::move(outNewPath)),
+              io_(io),
+              pipelined_(pipelined) {
         }
 
         void Execute() override {
             try {
-                hpatch_stream(oldPath_.c_str(), diffPath_.c_str(), outNewPath_.c_str());
+                hpatch_stream(oldPath_.c_str(), diffPath_.c_str(), outNewPath_.c_str(), io_,
+                              pipelined_);
             } catch (const std::exception& e) {
                 SetError(e.what());
             }
@@ -296,6 +777,8 @@ namespace hdiffpatchNode
         std::string oldPath_;
         std::string diffPath_;
         std::string outNewPath_;
+        FileIoOptions io_;
+        bool pipelined_;
     };
 
     // ============ 异步 Single-compressed Patch Worker ============
@@ -304,16 +787,19 @@ namespace hdiffpatchNode
         PatchSingleStreamAsyncWorker(Napi::Function& callback,
                                      std::string oldPath,
                                      std::string diffPath,
-                                     std::string outNewPath)
+                                     std::string outNewPath,
+                                     FileIoOptions io)
             : Napi::AsyncWorker(callback),
               oldPath_(std::move(oldPath)),
               diffPath_(std::move(diffPath)),
-              outNewPath_(std::move(outNewPath)) {
+              outNewPath_(std::move(outNewPath)),
+              io_(io) {
         }
 
         void Execute() override {
             try {
-                hpatch_single_stream(oldPath_.c_str(), diffPath_.c_str(), outNewPath_.c_str());
+                hpatch_single_stream(oldPath_.c_str(), diffPath_.c_str(), outNewPath_.c_str(),
+                                     io_);
             } catch (const std::exception& e) {
                 SetError(e.what());
             }
@@ -335,6 +821,7 @@ namespace hdiffpatchNode
         std::string oldPath_;
         std::string diffPath_;
         std::string outNewPath_;
+        FileIoOptions io_;
     };
 
     // ============ 异步 Single-compressed Stream Diff Worker ============
@@ -344,18 +831,19 @@ namespace hdiffpatchNode
                                     std::string oldPath,
                                     std::string newPath,
                                     std::string outDiffPath,
-                                    size_t compressionThreads)
+                                    NativeDiffOptions options)
             : Napi::AsyncWorker(callback),
               oldPath_(std::move(oldPath)),
               newPath_(std::move(newPath)),
               outDiffPath_(std::move(outDiffPath)),
-              compressionThreads_(compressionThreads) {
+              options_(std::move(options)) {
         }
 
         void Execute() override {
             try {
-                hdiff_single_stream(oldPath_.c_str(), newPath_.c_str(), outDiffPath_.c_str(),
-                                    compressionThreads_);
+                hdiff_single_stream_cached(options_.cache, oldPath_.c_str(), newPath_.c_str(),
+                                           outDiffPath_.c_str(), options_.compressionThreads,
+                                           options_.checksum, options_.io);
             } catch (const std::exception& e) {
                 SetError(e.what());
             }
@@ -377,7 +865,52 @@ namespace hdiffpatchNode
         std::string oldPath_;
         std::string newPath_;
         std::string outDiffPath_;
-        size_t compressionThreads_;
+        NativeDiffOptions options_;
+    };
+
+    // ============ 异步 Patch Chain Worker ============
+    class PatchChainAsyncWorker : public Napi::AsyncWorker {
+    public:
+        PatchChainAsyncWorker(Napi::Function& callback,
+                              std::string oldPath,
+                              std::vector<std::string> diffPaths,
+                              std::string outNewPath,
+                              size_t maxMemory,
+                              FileIoOptions io)
+            : Napi::AsyncWorker(callback),
+              oldPath_(std::move(oldPath)),
+              diffPaths_(std::move(diffPaths)),
+              outNewPath_(std::move(outNewPath)),
+              maxMemory_(maxMemory),
+              io_(io) {
+        }
+
+        void Execute() override {
+            try {
+                hpatch_chain(oldPath_.c_str(), diffPaths_, outNewPath_.c_str(), maxMemory_, io_);
+            } catch (const std::exception& e) {
+                SetError(e.what());
+            }
+        }
+
+        void OnOK() override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Callback().Call({env.Null(), Napi::String::New(env, outNewPath_)});
+        }
+
+        void OnError(const Napi::Error& e) override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Callback().Call({e.Value()});
+        }
+
+    private:
+        std::string oldPath_;
+        std::vector<std::string> diffPaths_;
+        std::string outNewPath_;
+        size_t maxMemory_;
+        FileIoOptions io_;
     };
 
     // ============ 同步/异步 diff ============
@@ -398,9 +931,12 @@ namespace hdiffpatchNode
         }
 
         NativeDiffOptions options;
+        OutputRegion out;
+        Napi::Value outValue = env.Undefined();
         size_t argIdx = 2;
         if (info.Length() > argIdx && !info[argIdx].IsFunction()) {
-            if (!parseDiffOptions(env, info[argIdx], false, options)) {
+            if (!parseDiffOptions(env, info[argIdx], false, options, true, true) ||
+                !parseOutOption(env, info[argIdx], outValue, out)) {
                 return env.Undefined();
             }
             argIdx++;
@@ -410,8 +946,8 @@ namespace hdiffpatchNode
         if (info.Length() > argIdx && info[argIdx].IsFunction()) {
             Napi::Function callback = info[argIdx].As<Napi::Function>();
             DiffAsyncWorker* worker = new DiffAsyncWorker(
-                callback, info[0], oldData, oldLength, info[1], newData, newLength,
-                options.compressionThreads
+                callback, info[0], oldData, oldLength, info[1], newData, newLength, options,
+                DiffEngine::Memory, outValue, out
             );
             worker->Queue();
             return env.Undefined();
@@ -420,8 +956,15 @@ namespace hdiffpatchNode
         // 同步模式
         std::vector<uint8_t> codeBuf;
         try {
-            hdiff(oldData, oldLength, newData, newLength, codeBuf,
-                  options.compressionThreads);
+            ExternalMemoryCharge charge(env, NativeMemoryKind::Diff,
+                                        diffMemoryEstimate(DiffEngine::Memory, options,
+                                                           oldLength, newLength));
+            runBufferDiff(DiffEngine::Memory, options, oldData, oldLength, newData, newLength,
+                          codeBuf);
+            if (out.enabled) {
+                copyToOutput(codeBuf, out);
+                return Napi::Number::New(env, static_cast<double>(codeBuf.size()));
+            }
         } catch (const std::exception& e) {
             Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
             return env.Undefined();
@@ -453,19 +996,41 @@ namespace hdiffpatchNode
             return env.Undefined();
         }
 
+        // patch(old, diff[, out][, cb]):给出 out 时结果写入 out,返回字节数
+        OutputRegion out;
+        size_t argIdx = 2;
+        if (info.Length() > argIdx && !info[argIdx].IsFunction() && !info[argIdx].IsUndefined()) {
+            if (!getOutputRegion(info[argIdx], out)) {
+                Napi::TypeError::New(env, "Invalid out: expected Buffer, TypedArray, ArrayBuffer or SharedArrayBuffer.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+        }
+        if (info.Length() > argIdx && !info[argIdx].IsFunction()) argIdx++;
+
         // 如果提供了回调函数，使用异步模式
-        if (info.Length() > 2 && info[2].IsFunction()) {
-            Napi::Function callback = info[2].As<Napi::Function>();
+        if (info.Length() > argIdx && info[argIdx].IsFunction()) {
+            Napi::Function callback = info[argIdx].As<Napi::Function>();
             PatchAsyncWorker* worker = new PatchAsyncWorker(
-                callback, info[0], oldData, oldLength, info[1], diffData, diffLength
+                callback, info[0], oldData, oldLength, info[1], diffData, diffLength,
+                PatchRange(), out.enabled ? info[2] : env.Undefined(), out
             );
             worker->Queue();
             return env.Undefined();
         }
 
         // 同步模式
-        std::vector<uint8_t> newBuf;
+        PatchBuffer newBuf;
         try {
+            if (out.enabled) {
+                ExternalMemoryCharge charge(env, NativeMemoryKind::Patch,
+                                            patchIntoMemoryEstimate(diffData, diffLength));
+                const size_t written = hpatch_into(oldData, oldLength, diffData, diffLength,
+                                                   out.data, out.length, newBuf);
+                return Napi::Number::New(env, static_cast<double>(written));
+            }
+            ExternalMemoryCharge charge(env, NativeMemoryKind::Patch,
+                                        patchMemoryEstimate(diffData, diffLength));
             hpatch(oldData, oldLength, diffData, diffLength, newBuf);
         } catch (const std::exception& e) {
             Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
@@ -475,6 +1040,84 @@ namespace hdiffpatchNode
         return bufferFromVector(env, std::move(newBuf));
     }
 
+    // ============ 同步/异步 patchRange ============
+    // patchRange(old, diff, offset, length[, cb]):只生成 new 的一个字节区间
+    Napi::Value patchRange(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        const uint8_t* oldData = nullptr;
+        size_t oldLength = 0;
+        const uint8_t* diffData = nullptr;
+        size_t diffLength = 0;
+
+        if (info.Length() < 4 ||
+            !getBufferData(info[0], &oldData, &oldLength) ||
+            !getBufferData(info[1], &diffData, &diffLength)) {
+            Napi::TypeError::New(env, "Invalid arguments: expected (oldBuf, diffBuf, offset, length).")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        PatchRange range;
+        range.enabled = true;
+        size_t offset = 0;
+        if (!parseIntegerOption(info[2], 0, std::numeric_limits<size_t>::max(), offset) ||
+            !parseIntegerOption(info[3], 0, std::numeric_limits<size_t>::max(), range.length)) {
+            Napi::TypeError::New(env, "Invalid range: offset and length must be non-negative integers.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        range.offset = offset;
+
+        if (diffLength < 4) {
+            Napi::Error::New(env, "Invalid diff data: too short.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        // patchRange(old, diff, offset, length[, out][, cb]):与 patch() 相同,
+        // 给出 out 时范围直接写入 out,返回字节数
+        OutputRegion out;
+        size_t argIdx = 4;
+        if (info.Length() > argIdx && !info[argIdx].IsFunction() && !info[argIdx].IsUndefined()) {
+            if (!getOutputRegion(info[argIdx], out)) {
+                Napi::TypeError::New(env, "Invalid out: expected Buffer, TypedArray, ArrayBuffer or SharedArrayBuffer.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+        }
+        if (info.Length() > argIdx && !info[argIdx].IsFunction()) argIdx++;
+
+        if (info.Length() > argIdx && info[argIdx].IsFunction()) {
+            Napi::Function callback = info[argIdx].As<Napi::Function>();
+            PatchAsyncWorker* worker = new PatchAsyncWorker(
+                callback, info[0], oldData, oldLength, info[1], diffData, diffLength, range,
+                out.enabled ? info[4] : env.Undefined(), out
+            );
+            worker->Queue();
+            return env.Undefined();
+        }
+
+        PatchBuffer rangeBuf;
+        try {
+            ExternalMemoryCharge charge(env, NativeMemoryKind::Patch,
+                                        patchRangeMemoryEstimate(diffData, diffLength, range));
+            if (out.enabled) {
+                const size_t written = hpatch_range_into(oldData, oldLength, diffData, diffLength,
+                                                         range.offset, range.length,
+                                                         out.data, out.length);
+                return Napi::Number::New(env, static_cast<double>(written));
+            }
+            hpatch_range(oldData, oldLength, diffData, diffLength, range.offset, range.length,
+                         rangeBuf);
+        } catch (const std::exception& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        return bufferFromVector(env, std::move(rangeBuf));
+    }
+
     // ============ 同步/异步 diffStream ============
     Napi::Value diffStream(const Napi::CallbackInfo& info) {
         Napi::Env env = info.Env();
@@ -503,15 +1146,16 @@ namespace hdiffpatchNode
         if (info.Length() > argIdx && info[argIdx].IsFunction()) {
             Napi::Function callback = info[argIdx].As<Napi::Function>();
             DiffStreamAsyncWorker* worker = new DiffStreamAsyncWorker(
-                callback, oldPath, newPath, outDiffPath, options.compressionThreads
+                callback, oldPath, newPath, outDiffPath, options
             );
             worker->Queue();
             return env.Undefined();
         }
 
         try {
-            hdiff_stream(oldPath.c_str(), newPath.c_str(), outDiffPath.c_str(),
-                         options.compressionThreads);
+            hdiff_stream_cached(options.cache, oldPath.c_str(), newPath.c_str(),
+                                outDiffPath.c_str(), options.compressionThreads,
+                                options.checksum, options.io);
         } catch (const std::exception& e) {
             Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
             return env.Undefined();
@@ -536,17 +1180,27 @@ namespace hdiffpatchNode
             return env.Undefined();
         }
 
-        if (info.Length() > 3 && info[3].IsFunction()) {
-            Napi::Function callback = info[3].As<Napi::Function>();
+        FileIoOptions io;
+        bool pipelined = false;
+        size_t argIdx = 3;
+        if (info.Length() > argIdx && !info[argIdx].IsFunction()) {
+            if (!parsePatchFileOptions(env, info[argIdx], io, &pipelined)) {
+                return env.Undefined();
+            }
+            argIdx++;
+        }
+
+        if (info.Length() > argIdx && info[argIdx].IsFunction()) {
+            Napi::Function callback = info[argIdx].As<Napi::Function>();
             PatchStreamAsyncWorker* worker = new PatchStreamAsyncWorker(
-                callback, oldPath, diffPath, outNewPath
+                callback, oldPath, diffPath, outNewPath, io, pipelined
             );
             worker->Queue();
             return env.Undefined();
         }
 
         try {
-            hpatch_stream(oldPath.c_str(), diffPath.c_str(), outNewPath.c_str());
+            hpatch_stream(oldPath.c_str(), diffPath.c_str(), outNewPath.c_str(), io, pipelined);
         } catch (const std::exception& e) {
             Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
             return env.Undefined();
@@ -562,20 +1216,20 @@ namespace hdiffpatchNode
                               std::string oldPath,
                               std::string newPath,
                               std::string outDiffPath,
-                              size_t windowSize,
-                              size_t compressionThreads)
+                              NativeDiffOptions options)
             : Napi::AsyncWorker(callback),
               oldPath_(std::move(oldPath)),
               newPath_(std::move(newPath)),
               outDiffPath_(std::move(outDiffPath)),
-              windowSize_(windowSize),
-              compressionThreads_(compressionThreads) {
+              options_(std::move(options)) {
         }
 
         void Execute() override {
             try {
-                hdiff_window(oldPath_.c_str(), newPath_.c_str(), outDiffPath_.c_str(),
-                             windowSize_, compressionThreads_);
+                hdiff_window_cached(options_.cache, oldPath_.c_str(), newPath_.c_str(),
+                                    outDiffPath_.c_str(), options_.windowSize,
+                                    options_.compressionThreads, options_.checksum,
+                                    options_.io);
             } catch (const std::exception& e) {
                 SetError(e.what());
             }
@@ -597,23 +1251,91 @@ namespace hdiffpatchNode
         std::string oldPath_;
         std::string newPath_;
         std::string outDiffPath_;
-        size_t windowSize_;
-        size_t compressionThreads_;
+        NativeDiffOptions options_;
     };
 
-    // ============ 同步/异步 diffSingleStream ============
-    // single 格式(HDIFFSF20)的流式生成:低内存(块匹配),产物与 diff()
-    // 同格式,所有既有 single 应用端(含历史客户端)可直接应用。
-    Napi::Value diffSingleStream(const Napi::CallbackInfo& info) {
+    // ============ diffSingleStream()/diffWindow() 的 Buffer 形态 ============
+    // (oldBuf, newBuf[, windowSize][, options][, cb]):old/new 作为内存流交给
+    // 流式匹配器,产物以 Buffer 返回,字节与文件路径形态相同。
+    Napi::Value diffBuffersWithEngine(const Napi::CallbackInfo& info, DiffEngine engine) {
         Napi::Env env = info.Env();
 
-        std::string oldPath;
-        std::string newPath;
-        std::string outDiffPath;
-        if (info.Length() < 3 ||
-            !getStringUtf8(info[0], oldPath) ||
-            !getStringUtf8(info[1], newPath) ||
-            !getStringUtf8(info[2], outDiffPath)) {
+        const uint8_t* oldData = nullptr;
+        size_t oldLength = 0;
+        const uint8_t* newData = nullptr;
+        size_t newLength = 0;
+        if (info.Length() < 2 ||
+            !getBufferData(info[0], &oldData, &oldLength) ||
+            !getBufferData(info[1], &newData, &newLength)) {
+            Napi::TypeError::New(env, "Invalid arguments: expected (oldBuf, newBuf) or file paths.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        NativeDiffOptions options;
+        size_t argIdx = 2;
+        if (engine == DiffEngine::Window && info.Length() > argIdx && info[argIdx].IsNumber()) {
+            if (!parseIntegerOption(info[argIdx], 0, std::numeric_limits<size_t>::max(),
+                                    options.windowSize)) {
+                Napi::TypeError::New(env, "Invalid windowSize: expected a non-negative integer.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            argIdx++;
+        }
+        OutputRegion out;
+        Napi::Value outValue = env.Undefined();
+        if (info.Length() > argIdx && !info[argIdx].IsFunction()) {
+            if (!parseBufferDiffOptions(env, info[argIdx], engine, options, true) ||
+                !parseOutOption(env, info[argIdx], outValue, out)) {
+                return env.Undefined();
+            }
+            argIdx++;
+        }
+
+        if (info.Length() > argIdx && info[argIdx].IsFunction()) {
+            Napi::Function callback = info[argIdx].As<Napi::Function>();
+            DiffAsyncWorker* worker = new DiffAsyncWorker(
+                callback, info[0], oldData, oldLength, info[1], newData, newLength, options, engine,
+                outValue, out
+            );
+            worker->Queue();
+            return env.Undefined();
+        }
+
+        std::vector<uint8_t> codeBuf;
+        try {
+            ExternalMemoryCharge charge(env, NativeMemoryKind::Diff,
+                                        diffMemoryEstimate(engine, options, oldLength, newLength));
+            runBufferDiff(engine, options, oldData, oldLength, newData, newLength, codeBuf);
+            if (out.enabled) {
+                copyToOutput(codeBuf, out);
+                return Napi::Number::New(env, static_cast<double>(codeBuf.size()));
+            }
+        } catch (const std::exception& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        return bufferFromVector(env, std::move(codeBuf));
+    }
+
+    // ============ 同步/异步 diffSingleStream ============
+    // single 格式(HDIFFSF20)的流式生成:低内存(块匹配),产物与 diff()
+    // 同格式,所有既有 single 应用端(含历史客户端)可直接应用。
+    Napi::Value diffSingleStream(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() > 0 && isBinaryArg(info[0])) {
+            return diffBuffersWithEngine(info, DiffEngine::SingleStream);
+        }
+
+        std::string oldPath;
+        std::string newPath;
+        std::string outDiffPath;
+        if (info.Length() < 3 ||
+            !getStringUtf8(info[0], oldPath) ||
+            !getStringUtf8(info[1], newPath) ||
+            !getStringUtf8(info[2], outDiffPath)) {
             Napi::TypeError::New(env, "Invalid arguments: expected (oldPath, newPath, outDiffPath).")
                 .ThrowAsJavaScriptException();
             return env.Undefined();
@@ -631,15 +1353,16 @@ namespace hdiffpatchNode
         if (info.Length() > argIdx && info[argIdx].IsFunction()) {
             Napi::Function callback = info[argIdx].As<Napi::Function>();
             DiffSingleStreamAsyncWorker* worker = new DiffSingleStreamAsyncWorker(
-                callback, oldPath, newPath, outDiffPath, options.compressionThreads
+                callback, oldPath, newPath, outDiffPath, options
             );
             worker->Queue();
             return env.Undefined();
         }
 
         try {
-            hdiff_single_stream(oldPath.c_str(), newPath.c_str(), outDiffPath.c_str(),
-                                options.compressionThreads);
+            hdiff_single_stream_cached(options.cache, oldPath.c_str(), newPath.c_str(),
+                                       outDiffPath.c_str(), options.compressionThreads,
+                                       options.checksum, options.io);
         } catch (const std::exception& e) {
             Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
             return env.Undefined();
@@ -657,6 +1380,9 @@ namespace hdiffpatchNode
     // 距离的内容移动,内存占用近似线性增长。
     Napi::Value diffWindow(const Napi::CallbackInfo& info) {
         Napi::Env env = info.Env();
+        if (info.Length() > 0 && isBinaryArg(info[0])) {
+            return diffBuffersWithEngine(info, DiffEngine::Window);
+        }
 
         std::string oldPath;
         std::string newPath;
@@ -694,16 +1420,321 @@ namespace hdiffpatchNode
         if (info.Length() > argIdx && info[argIdx].IsFunction()) {
             Napi::Function callback = info[argIdx].As<Napi::Function>();
             DiffWindowAsyncWorker* worker = new DiffWindowAsyncWorker(
-                callback, oldPath, newPath, outDiffPath, options.windowSize,
-                options.compressionThreads
+                callback, oldPath, newPath, outDiffPath, options
+            );
+            worker->Queue();
+            return env.Undefined();
+        }
+
+        try {
+            hdiff_window_cached(options.cache, oldPath.c_str(), newPath.c_str(),
+                                outDiffPath.c_str(), options.windowSize,
+                                options.compressionThreads, options.checksum,
+                                options.io);
+        } catch (const std::exception& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        return Napi::String::New(env, outDiffPath);
+    }
+
+    // ============ NewFeed ============
+    // new 来自 JS Readable 时的写入进度(见 feed_stream.h 与 readable_new.js):
+    // JS 把数据写入 spoolPath,每写完一块调用 advance(bytes),结束时 end(),
+    // 出错或放弃时 abort()。diffFeed() 的工作线程据此边写边读。
+    const napi_type_tag kNewFeedTypeTag = {0x6864705f6e657766ULL, 0x6565645f73706f6fULL};
+
+    class NewFeed : public Napi::ObjectWrap<NewFeed> {
+    public:
+        static Napi::Function Define(Napi::Env env) {
+            return DefineClass(env, "NewFeed", {
+                InstanceMethod("advance", &NewFeed::Advance),
+                InstanceMethod("end", &NewFeed::End),
+                InstanceMethod("abort", &NewFeed::Abort),
+            });
+        }
+
+        // new NewFeed(spoolPath, newSize)
+        explicit NewFeed(const Napi::CallbackInfo& info)
+            : Napi::ObjectWrap<NewFeed>(info) {
+            Napi::Env env = info.Env();
+            size_t size = 0;
+            if (info.Length() < 2 || !getStringUtf8(info[0], spoolPath_) ||
+                !parseIntegerOption(info[1], 0, std::numeric_limits<size_t>::max(), size)) {
+                Napi::TypeError::New(env, "Invalid arguments: expected (spoolPath, newSize).")
+                    .ThrowAsJavaScriptException();
+                return;
+            }
+            feed_ = std::make_shared<StreamFeed>((uint64_t)size);
+            info.This().As<Napi::Object>().TypeTag(&kNewFeedTypeTag);
+        }
+
+        ~NewFeed() override {
+            // 对象被回收时不会再有写入,避免工作线程永远等待
+            if (feed_) feed_->abort();
+        }
+
+        // 不是 NewFeed 实例时返回 nullptr
+        static NewFeed* From(const Napi::Value& value) {
+            if (!value.IsObject()) return nullptr;
+            Napi::Object object = value.As<Napi::Object>();
+            if (!object.CheckTypeTag(&kNewFeedTypeTag)) return nullptr;
+            return Unwrap(object);
+        }
+
+        const std::string& spoolPath() const { return spoolPath_; }
+        const std::shared_ptr<StreamFeed>& feed() const { return feed_; }
+
+    private:
+        Napi::Value Advance(const Napi::CallbackInfo& info) {
+            Napi::Env env = info.Env();
+            size_t bytes = 0;
+            if (info.Length() < 1 ||
+                !parseIntegerOption(info[0], 0, std::numeric_limits<size_t>::max(), bytes)) {
+                Napi::TypeError::New(env, "Invalid bytes: expected a non-negative integer.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            return Napi::Boolean::New(env, feed_->advance((uint64_t)bytes));
+        }
+
+        Napi::Value End(const Napi::CallbackInfo& info) {
+            feed_->end();
+            return info.Env().Undefined();
+        }
+
+        Napi::Value Abort(const Napi::CallbackInfo& info) {
+            feed_->abort();
+            return info.Env().Undefined();
+        }
+
+        std::string spoolPath_;
+        std::shared_ptr<StreamFeed> feed_;
+    };
+
+    enum class FeedEngine { Stream, SingleStream, Window };
+
+    // ============ Feed Diff 线程 ============
+    // 读到尚未写入的 new 时会阻塞等待 JS 写入 spool,而 spool 的 fs.write 走 libuv
+    // 线程池;等待放在池里会与写入互相占位(池被占满即死锁),因此每个 diffFeed
+    // 使用独立线程,结束时经 ThreadSafeFunction 回到 JS 线程回调。
+    struct FeedDiffJob {
+        FeedEngine engine;
+        std::string oldPath;
+        std::string spoolPath;
+        std::shared_ptr<StreamFeed> feed;
+        std::string outDiffPath;
+        NativeDiffOptions options;
+        Napi::Reference<Napi::Value> feedRef;
+        Napi::ThreadSafeFunction done;
+        std::thread thread;
+        bool failed = false;
+        std::string error;
+    };
+
+    void runFeedDiff(FeedDiffJob& job) {
+        try {
+            FeedInputStream newStream;
+            if (!newStream.open(job.spoolPath.c_str(), job.feed)) {
+                throw std::runtime_error("open new spool file failed.");
+            }
+            const NativeDiffOptions& options = job.options;
+            switch (job.engine) {
+                case FeedEngine::Stream:
+                    hdiff_stream(job.oldPath.c_str(), &newStream.base, job.outDiffPath.c_str(),
+                                 options.compressionThreads, options.checksum, options.io);
+                    break;
+                case FeedEngine::SingleStream:
+                    hdiff_single_stream(job.oldPath.c_str(), &newStream.base,
+                                        job.outDiffPath.c_str(), options.compressionThreads,
+                                        options.checksum, options.io);
+                    break;
+                case FeedEngine::Window:
+                    hdiff_window(job.oldPath.c_str(), &newStream.base, job.outDiffPath.c_str(),
+                                 options.windowSize, options.compressionThreads,
+                                 options.checksum, options.io);
+                    break;
+            }
+            if (!newStream.close()) {
+                throw std::runtime_error("close new spool file failed.");
+            }
+        } catch (const std::exception& e) {
+            job.failed = true;
+            job.error = e.what();
+        }
+    }
+
+    // ============ 异步 diffFeed ============
+    // diffFeed(engine, oldPath, feed, outDiffPath, options, cb):new 由 NewFeed 边写边读。
+    // engine 为 'stream' | 'single' | 'window'。只有异步形式:同步调用会阻塞
+    // 负责写入 new 的 JS 线程。diff 在独立线程中运行,不占 libuv 线程池(见
+    // FeedDiffJob)。JS 入口见 readable_new.js。
+    Napi::Value diffFeed(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        std::string engineName;
+        std::string oldPath;
+        std::string outDiffPath;
+        NewFeed* feed = info.Length() > 2 ? NewFeed::From(info[2]) : nullptr;
+        if (info.Length() < 6 ||
+            !getStringUtf8(info[0], engineName) ||
+            !getStringUtf8(info[1], oldPath) ||
+            !feed ||
+            !getStringUtf8(info[3], outDiffPath) ||
+            !info[5].IsFunction()) {
+            Napi::TypeError::New(env, "Invalid arguments: expected (engine, oldPath, feed, outDiffPath, options, cb).")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        FeedEngine engine;
+        if (engineName == "stream") {
+            engine = FeedEngine::Stream;
+        } else if (engineName == "single") {
+            engine = FeedEngine::SingleStream;
+        } else if (engineName == "window") {
+            engine = FeedEngine::Window;
+        } else {
+            Napi::TypeError::New(env, "Invalid engine: expected 'stream', 'single' or 'window'.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        NativeDiffOptions options;
+        if (!parseDiffOptions(env, info[4], engine == FeedEngine::Window, options)) {
+            return env.Undefined();
+        }
+        if (!options.cache.dir.empty()) {
+            // 缓存键需要事先哈希整个 new
+            Napi::TypeError::New(env, "cache is not supported when new is a Readable.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        FeedDiffJob* job = new FeedDiffJob();
+        job->engine = engine;
+        job->oldPath = std::move(oldPath);
+        job->spoolPath = feed->spoolPath();
+        job->feed = feed->feed();
+        job->outDiffPath = std::move(outDiffPath);
+        job->options = std::move(options);
+        job->feedRef = Napi::Persistent(info[2]);
+        // 回调之后 Release,finalizer 在 JS 线程中 join 并释放 job
+        job->done = Napi::ThreadSafeFunction::New(
+            env, info[5].As<Napi::Function>(), "hdiffpatch.diffFeed", 0, 1,
+            [](Napi::Env, FeedDiffJob* finished) {
+                if (finished->thread.joinable()) finished->thread.join();
+                finished->feedRef.Reset();
+                delete finished;
+            },
+            job);
+        try {
+            job->thread = std::thread([job] {
+                runFeedDiff(*job);
+                job->done.BlockingCall([job](Napi::Env env, Napi::Function callback) {
+                    if (job->failed) {
+                        callback.Call({Napi::Error::New(env, job->error).Value()});
+                    } else {
+                        callback.Call({env.Null(), Napi::String::New(env, job->outDiffPath)});
+                    }
+                });
+                job->done.Release();
+            });
+        } catch (const std::system_error& e) {
+            // 线程创建失败:Release 后由 finalizer 释放 job(thread 不可 join)
+            job->done.Release();
+            Napi::Error::New(env, std::string("start diff thread failed: ") + e.what())
+                .ThrowAsJavaScriptException();
+        }
+        return env.Undefined();
+    }
+
+    // ============ 异步 File Diff Worker ============
+    class DiffFileAsyncWorker : public Napi::AsyncWorker {
+    public:
+        DiffFileAsyncWorker(Napi::Function& callback,
+                            std::string oldPath,
+                            std::string newPath,
+                            std::string outDiffPath,
+                            NativeDiffOptions options)
+            : Napi::AsyncWorker(callback),
+              oldPath_(std::move(oldPath)),
+              newPath_(std::move(newPath)),
+              outDiffPath_(std::move(outDiffPath)),
+              options_(std::move(options)) {
+        }
+
+        void Execute() override {
+            try {
+                hdiff_file_cached(options_.cache, oldPath_.c_str(), newPath_.c_str(),
+                                  outDiffPath_.c_str(), options_.compressionThreads,
+                                  options_.checksum, options_.trimIdentical,
+                                  options_.maxIndexMemory);
+            } catch (const std::exception& e) {
+                SetError(e.what());
+            }
+        }
+
+        void OnOK() override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Callback().Call({env.Null(), Napi::String::New(env, outDiffPath_)});
+        }
+
+        void OnError(const Napi::Error& e) override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Callback().Call({e.Value()});
+        }
+
+    private:
+        std::string oldPath_;
+        std::string newPath_;
+        std::string outDiffPath_;
+        NativeDiffOptions options_;
+    };
+
+    // ============ 同步/异步 diffFile ============
+    // 内存版 diff() 直接作用于映射的文件:产物与 diff() 字节相同,
+    // old/new 不进入 JS 堆。签名:(oldPath, newPath, outDiffPath[, options][, cb])
+    Napi::Value diffFile(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        std::string oldPath;
+        std::string newPath;
+        std::string outDiffPath;
+        if (info.Length() < 3 ||
+            !getStringUtf8(info[0], oldPath) ||
+            !getStringUtf8(info[1], newPath) ||
+            !getStringUtf8(info[2], outDiffPath)) {
+            Napi::TypeError::New(env, "Invalid arguments: expected (oldPath, newPath, outDiffPath).")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        NativeDiffOptions options;
+        size_t argIdx = 3;
+        if (info.Length() > argIdx && !info[argIdx].IsFunction()) {
+            if (!parseDiffOptions(env, info[argIdx], false, options, true)) {
+                return env.Undefined();
+            }
+            argIdx++;
+        }
+
+        if (info.Length() > argIdx && info[argIdx].IsFunction()) {
+            Napi::Function callback = info[argIdx].As<Napi::Function>();
+            DiffFileAsyncWorker* worker = new DiffFileAsyncWorker(
+                callback, oldPath, newPath, outDiffPath, options
             );
             worker->Queue();
             return env.Undefined();
         }
 
         try {
-            hdiff_window(oldPath.c_str(), newPath.c_str(), outDiffPath.c_str(),
-                         options.windowSize, options.compressionThreads);
+            hdiff_file_cached(options.cache, oldPath.c_str(), newPath.c_str(),
+                              outDiffPath.c_str(), options.compressionThreads,
+                              options.checksum, options.trimIdentical,
+                              options.maxIndexMemory);
         } catch (const std::exception& e) {
             Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
             return env.Undefined();
@@ -728,17 +1759,97 @@ namespace hdiffpatchNode
             return env.Undefined();
         }
 
-        if (info.Length() > 3 && info[3].IsFunction()) {
-            Napi::Function callback = info[3].As<Napi::Function>();
+        FileIoOptions io;
+        size_t argIdx = 3;
+        if (info.Length() > argIdx && !info[argIdx].IsFunction()) {
+            if (!parsePatchFileOptions(env, info[argIdx], io)) {
+                return env.Undefined();
+            }
+            argIdx++;
+        }
+
+        if (info.Length() > argIdx && info[argIdx].IsFunction()) {
+            Napi::Function callback = info[argIdx].As<Napi::Function>();
             PatchSingleStreamAsyncWorker* worker = new PatchSingleStreamAsyncWorker(
-                callback, oldPath, diffPath, outNewPath
+                callback, oldPath, diffPath, outNewPath, io
+            );
+            worker->Queue();
+            return env.Undefined();
+        }
+
+        try {
+            hpatch_single_stream(oldPath.c_str(), diffPath.c_str(), outNewPath.c_str(), io);
+        } catch (const std::exception& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        return Napi::String::New(env, outNewPath);
+    }
+
+    // ============ 同步/异步 patchChain ============
+    // 依次应用多个 diff(跳过多个版本的设备),中间结果优先留在内存,
+    // 超出 maxMemory(缺省 256MB)的才落盘为临时文件。
+    // 签名:(oldPath, diffPaths[], outNewPath[, { maxMemory, io }][, cb])
+    Napi::Value patchChain(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        std::string oldPath;
+        std::vector<std::string> diffPaths;
+        std::string outNewPath;
+        bool validArgs = info.Length() >= 3 &&
+                         getStringUtf8(info[0], oldPath) &&
+                         info[1].IsArray() &&
+                         getStringUtf8(info[2], outNewPath);
+        if (validArgs) {
+            Napi::Array diffArray = info[1].As<Napi::Array>();
+            for (uint32_t i = 0; validArgs && i < diffArray.Length(); ++i) {
+                std::string diffPath;
+                validArgs = getStringUtf8(diffArray.Get(i), diffPath);
+                diffPaths.push_back(std::move(diffPath));
+            }
+            validArgs = validArgs && !diffPaths.empty();
+        }
+        if (!validArgs) {
+            Napi::TypeError::New(env, "Invalid arguments: expected (oldPath, diffPaths[], outNewPath).")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        size_t maxMemory = kDefaultChainMaxMemory;
+        FileIoOptions io;
+        size_t argIdx = 3;
+        if (info.Length() > argIdx && !info[argIdx].IsFunction()) {
+            if (!info[argIdx].IsObject()) {
+                Napi::TypeError::New(env, "Invalid patchChain options: expected an object.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            Napi::Object options = info[argIdx].As<Napi::Object>();
+            if (options.Has("maxMemory") &&
+                !parseIntegerOption(options.Get("maxMemory"), 0,
+                                    std::numeric_limits<size_t>::max(), maxMemory)) {
+                Napi::TypeError::New(env, "Invalid maxMemory: expected a non-negative integer.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            if (!parseFileIoOptions(env, options, io)) {
+                return env.Undefined();
+            }
+            argIdx++;
+        }
+
+        if (info.Length() > argIdx && info[argIdx].IsFunction()) {
+            Napi::Function callback = info[argIdx].As<Napi::Function>();
+            PatchChainAsyncWorker* worker = new PatchChainAsyncWorker(
+                callback, oldPath, std::move(diffPaths), outNewPath, maxMemory, io
             );
             worker->Queue();
             return env.Undefined();
         }
 
         try {
-            hpatch_single_stream(oldPath.c_str(), diffPath.c_str(), outNewPath.c_str());
+            hpatch_chain(oldPath.c_str(), diffPaths, outNewPath.c_str(), maxMemory, io);
         } catch (const std::exception& e) {
             Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
             return env.Undefined();
@@ -747,14 +1858,1228 @@ namespace hdiffpatchNode
         return Napi::String::New(env, outNewPath);
     }
 
+    // ============ diffMany ============
+    // 批量辅助:同一 new 对多个历史版本各生成一个 patch(每个 patch 只依赖
+    // 自己的 old,设备端照常 patch(),不是多参考 patch 格式):内容相同的 old 只计算一次并共享结果 Buffer,
+    // 其余在 threads 个线程上并行(缺省 1),每个任务各建自己的后缀索引;
+    // maxMemory 按工作集估算压低并发。
+    struct DiffManyItem {
+        const uint8_t* oldData = nullptr;
+        size_t oldLen = 0;
+        size_t sameAs = 0;  // 内容相同的首个条目下标,自身为首个时等于自身下标
+        std::vector<uint8_t> result;
+    };
+
+    inline void runDiffMany(std::vector<DiffManyItem>& items,
+                             const uint8_t* newData, size_t newLen,
+                             const NativeDiffOptions& options, size_t threads) {
+        std::vector<size_t> unique;
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (items[i].sameAs == i) unique.push_back(i);
+        }
+        std::vector<std::string> errors(unique.size());
+        parallel_for(unique.size(), threads, [&](size_t index, size_t /*worker*/) {
+            DiffManyItem& item = items[unique[index]];
+            try {
+                runBufferDiff(DiffEngine::Memory, options, item.oldData, item.oldLen,
+                              newData, newLen, item.result);
+            } catch (const std::exception& e) {
+                errors[index] = "old #" + std::to_string(unique[index]) + ": " + e.what();
+            }
+        });
+        for (const std::string& error : errors) {
+            if (!error.empty()) throw std::runtime_error(error);
+        }
+    }
+
+    // 同时运行的任务里工作集最大的 threads 个之和
+    inline uint64_t diffManyMemoryEstimate(const std::vector<DiffManyItem>& items,
+                                            size_t newLen, const NativeDiffOptions& options,
+                                            size_t threads) {
+        std::vector<uint64_t> estimates;
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (items[i].sameAs != i) continue;
+            estimates.push_back(diffMemoryEstimate(DiffEngine::Memory, options,
+                                                   items[i].oldLen, newLen));
+        }
+        std::sort(estimates.begin(), estimates.end(), std::greater<uint64_t>());
+        uint64_t total = 0;
+        for (size_t i = 0; i < estimates.size() && i < threads; ++i) total += estimates[i];
+        return total;
+    }
+
+    // 估算超出 maxMemory(0 为不限)时逐个减少并发,至少保留 1 个
+    inline size_t diffManyThreadsWithin(const std::vector<DiffManyItem>& items,
+                                         size_t newLen, const NativeDiffOptions& options,
+                                         size_t threads, size_t maxMemory) {
+        if (maxMemory == 0) return threads;
+        while (threads > 1 &&
+               diffManyMemoryEstimate(items, newLen, options, threads) > maxMemory) {
+            --threads;
+        }
+        return threads;
+    }
+
+    inline Napi::Array diffManyResults(Napi::Env env, std::vector<DiffManyItem>& items) {
+        Napi::Array results = Napi::Array::New(env, items.size());
+        for (size_t i = 0; i < items.size(); ++i) {
+            const uint32_t index = static_cast<uint32_t>(i);
+            if (items[i].sameAs == i) {
+                results.Set(index, bufferFromVector(env, std::move(items[i].result)));
+            } else {
+                results.Set(index, results.Get(static_cast<uint32_t>(items[i].sameAs)));
+            }
+        }
+        return results;
+    }
+
+    class DiffManyAsyncWorker : public Napi::AsyncWorker {
+    public:
+        DiffManyAsyncWorker(Napi::Function& callback,
+                             std::vector<DiffManyItem> items,
+                             const Napi::Value& oldsValue,
+                             const Napi::Value& newValue, const uint8_t* newData, size_t newLen,
+                             NativeDiffOptions options, size_t threads)
+            : Napi::AsyncWorker(callback),
+              charge_(callback.Env(), NativeMemoryKind::Diff,
+                      diffManyMemoryEstimate(items, newLen, options, threads)),
+              items_(std::move(items)),
+              newData_(newData),
+              newLen_(newLen),
+              options_(std::move(options)),
+              threads_(threads),
+              oldsRef_(Napi::Persistent(oldsValue)),
+              newRef_(Napi::Persistent(newValue)) {
+        }
+
+        void Execute() override {
+            try {
+                runDiffMany(items_, newData_, newLen_, options_, threads_);
+            } catch (const std::exception& e) {
+                SetError(e.what());
+            }
+        }
+
+        void OnOK() override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Napi::Array results = diffManyResults(env, items_);
+            Callback().Call({env.Null(), results});
+            oldsRef_.Reset();
+            newRef_.Reset();
+        }
+
+        void OnError(const Napi::Error& e) override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Callback().Call({e.Value()});
+            oldsRef_.Reset();
+            newRef_.Reset();
+        }
+
+    private:
+        ExternalMemoryCharge charge_;
+        std::vector<DiffManyItem> items_;
+        const uint8_t* newData_;
+        size_t newLen_;
+        NativeDiffOptions options_;
+        size_t threads_;
+        Napi::Reference<Napi::Value> oldsRef_;
+        Napi::Reference<Napi::Value> newRef_;
+    };
+
+    // diffMany(olds[], new[, options][, cb]):options 同 diff(),另加 threads/maxMemory
+    Napi::Value diffMany(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        const uint8_t* newData = nullptr;
+        size_t newLength = 0;
+        if (info.Length() < 2 || !info[0].IsArray() ||
+            !getBufferData(info[1], &newData, &newLength)) {
+            Napi::TypeError::New(env, "Invalid arguments: expected (olds[], new) as Buffer or TypedArray.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Array oldArray = info[0].As<Napi::Array>();
+        const uint32_t count = oldArray.Length();
+        std::vector<DiffManyItem> items(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            DiffManyItem& item = items[i];
+            if (!getBufferData(oldArray.Get(i), &item.oldData, &item.oldLen)) {
+                Napi::TypeError::New(env, "Invalid diffMany old #" + std::to_string(i) +
+                                     ": expected Buffer or TypedArray.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            item.sameAs = i;
+            for (uint32_t j = 0; j < i; ++j) {
+                if (items[j].sameAs == j && items[j].oldLen == item.oldLen &&
+                    (item.oldLen == 0 ||
+                     std::memcmp(items[j].oldData, item.oldData, item.oldLen) == 0)) {
+                    item.sameAs = j;
+                    break;
+                }
+            }
+        }
+
+        NativeDiffOptions options;
+        size_t threads = 1;
+        size_t maxMemory = 0;
+        size_t argIdx = 2;
+        if (info.Length() > argIdx && !info[argIdx].IsFunction()) {
+            if (!parseDiffOptions(env, info[argIdx], false, options, true)) {
+                return env.Undefined();
+            }
+            Napi::Object raw = info[argIdx].As<Napi::Object>();
+            if (raw.Has("threads") &&
+                !parseIntegerOption(raw.Get("threads"), 1, kMaxDiffThreads, threads)) {
+                Napi::TypeError::New(env, "Invalid threads: expected an integer from 1 to " +
+                                     std::to_string(kMaxDiffThreads) + ".")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            if (raw.Has("maxMemory") &&
+                !parseIntegerOption(raw.Get("maxMemory"), 0,
+                                    std::numeric_limits<size_t>::max(), maxMemory)) {
+                Napi::TypeError::New(env, "Invalid maxMemory: expected a non-negative integer.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            argIdx++;
+        }
+        threads = diffManyThreadsWithin(items, newLength, options, threads, maxMemory);
+
+        if (info.Length() > argIdx && info[argIdx].IsFunction()) {
+            Napi::Function callback = info[argIdx].As<Napi::Function>();
+            DiffManyAsyncWorker* worker = new DiffManyAsyncWorker(
+                callback, std::move(items), info[0], info[1], newData, newLength, options, threads
+            );
+            worker->Queue();
+            return env.Undefined();
+        }
+
+        try {
+            ExternalMemoryCharge charge(env, NativeMemoryKind::Diff,
+                                        diffManyMemoryEstimate(items, newLength, options,
+                                                                threads));
+            runDiffMany(items, newData, newLength, options, threads);
+        } catch (const std::exception& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return diffManyResults(env, items);
+    }
+
+    // ============ diffBest ============
+    // 对同一对 old/new 尝试多组配置,返回最小的(已校验的)产物。
+    // 候选按预计开销从低到高领取,缺省按 CPU 数并发,并按 maxMemory(缺省为
+    // 物理内存的一半)压低并发;各候选共享输入 Buffer(不拷贝),但各自建索引:
+    // 不同引擎/选项的索引不同,HDiffPatch 也不接受预建的后缀数组。
+    // 预算用完后不再启动新候选;已开始的候选不能中途取消(匹配与压缩没有
+    // 取消点),会运行到结束,完成的结果照常参与比较,选择结果与完成时机无关。
+    struct DiffBestCandidate {
+        DiffEngine engine = DiffEngine::Memory;
+        NativeDiffOptions options;
+        const char* status = "skipped";  // done / failed / skipped
+        size_t size = 0;
+        double ms = 0;
+        std::string error;
+    };
+
+    struct DiffBestJob {
+        const uint8_t* oldData = nullptr;
+        size_t oldLen = 0;
+        const uint8_t* newData = nullptr;
+        size_t newLen = 0;
+        std::vector<DiffBestCandidate> candidates;
+        size_t threads = 1;
+        double timeBudgetMs = 0;  // 0 表示不限
+        std::vector<uint8_t> best;
+        size_t bestIndex = 0;
+        bool hasBest = false;
+    };
+
+    // 运行顺序:引擎按速度(singleStream、window、内存版),同引擎按工作集估算
+    // 从小到大,再按下标;预算内先拿到便宜的结果,贵的候选最先被跳过
+    inline std::vector<size_t> diffBestRunOrder(const DiffBestJob& job) {
+        auto engineRank = [](DiffEngine engine) {
+            switch (engine) {
+                case DiffEngine::SingleStream: return 0;
+                case DiffEngine::Window: return 1;
+                default: return 2;
+            }
+        };
+        std::vector<uint64_t> estimates;
+        std::vector<size_t> order;
+        for (size_t i = 0; i < job.candidates.size(); ++i) {
+            const DiffBestCandidate& candidate = job.candidates[i];
+            estimates.push_back(diffMemoryEstimate(candidate.engine, candidate.options,
+                                                   job.oldLen, job.newLen));
+            order.push_back(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            const int rankA = engineRank(job.candidates[a].engine);
+            const int rankB = engineRank(job.candidates[b].engine);
+            if (rankA != rankB) return rankA < rankB;
+            return estimates[a] < estimates[b];
+        });
+        return order;
+    }
+
+    inline void runDiffBest(DiffBestJob& job) {
+        typedef std::chrono::steady_clock Clock;
+        const bool limited = job.timeBudgetMs > 0;
+        const Clock::time_point deadline =
+            Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<double, std::milli>(job.timeBudgetMs));
+        const std::vector<size_t> order = diffBestRunOrder(job);
+        std::mutex bestMutex;
+        parallel_for(order.size(), job.threads, [&](size_t position, size_t /*worker*/) {
+            const size_t index = order[position];
+            DiffBestCandidate& candidate = job.candidates[index];
+            const Clock::time_point begin = Clock::now();
+            // 运行顺序中的第一个总会运行,保证有结果
+            if (position > 0 && limited && begin >= deadline) return;
+            std::vector<uint8_t> out;
+            try {
+                runBufferDiff(candidate.engine, candidate.options, job.oldData, job.oldLen,
+                              job.newData, job.newLen, out);
+            } catch (const std::exception& e) {
+                candidate.status = "failed";
+                candidate.error = e.what();
+                return;
+            }
+            candidate.size = out.size();
+            candidate.ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+            std::lock_guard<std::mutex> lock(bestMutex);
+            candidate.status = "done";
+            // 只保留当前最小的产物;同尺寸时取靠前的候选,结果与线程调度无关
+            if (!job.hasBest || out.size() < job.best.size() ||
+                (out.size() == job.best.size() && index < job.bestIndex)) {
+                job.best.swap(out);
+                job.bestIndex = index;
+                job.hasBest = true;
+            }
+        });
+        if (!job.hasBest) {
+            throw std::runtime_error("diffBest: no candidate succeeded; first error: " +
+                                     job.candidates[order[0]].error);
+        }
+    }
+
+    inline uint64_t diffBestMemoryEstimate(const DiffBestJob& job) {
+        std::vector<uint64_t> estimates;
+        for (const DiffBestCandidate& candidate : job.candidates) {
+            estimates.push_back(diffMemoryEstimate(candidate.engine, candidate.options,
+                                                   job.oldLen, job.newLen));
+        }
+        std::sort(estimates.begin(), estimates.end(), std::greater<uint64_t>());
+        uint64_t total = 0;
+        for (size_t i = 0; i < estimates.size() && i < job.threads; ++i) total += estimates[i];
+        return total;
+    }
+
+    // 估算超出 maxMemory(0 为不限)时逐个减少并发,至少保留 1 个
+    inline void diffBestThreadsWithin(DiffBestJob& job, uint64_t maxMemory) {
+        if (maxMemory == 0) return;
+        while (job.threads > 1 && diffBestMemoryEstimate(job) > maxMemory) --job.threads;
+    }
+
+    // { diff, index, candidate, results: [{ status, size, ms[, error] }] }
+    inline Napi::Object diffBestResult(Napi::Env env, DiffBestJob& job,
+                                       const Napi::Array& candidates) {
+        Napi::Object out = Napi::Object::New(env);
+        out.Set("diff", bufferFromVector(env, std::move(job.best)));
+        out.Set("index", Napi::Number::New(env, (double)job.bestIndex));
+        out.Set("candidate", candidates.Get(static_cast<uint32_t>(job.bestIndex)));
+        Napi::Array results = Napi::Array::New(env, job.candidates.size());
+        for (size_t i = 0; i < job.candidates.size(); ++i) {
+            const DiffBestCandidate& candidate = job.candidates[i];
+            Napi::Object item = Napi::Object::New(env);
+            item.Set("status", Napi::String::New(env, candidate.status));
+            item.Set("size", Napi::Number::New(env, (double)candidate.size));
+            item.Set("ms", Napi::Number::New(env, candidate.ms));
+            if (!candidate.error.empty()) {
+                item.Set("error", Napi::String::New(env, candidate.error));
+            }
+            results.Set(static_cast<uint32_t>(i), item);
+        }
+        out.Set("results", results);
+        return out;
+    }
+
+    class DiffBestAsyncWorker : public Napi::AsyncWorker {
+    public:
+        DiffBestAsyncWorker(Napi::Function& callback, DiffBestJob job,
+                            const Napi::Value& oldValue, const Napi::Value& newValue,
+                            const Napi::Array& candidates)
+            : Napi::AsyncWorker(callback),
+              charge_(callback.Env(), NativeMemoryKind::Diff, diffBestMemoryEstimate(job)),
+              job_(std::move(job)),
+              oldRef_(Napi::Persistent(oldValue)),
+              newRef_(Napi::Persistent(newValue)),
+              candidatesRef_(Napi::Persistent(candidates.As<Napi::Object>())) {
+        }
+
+        void Execute() override {
+            try {
+                runDiffBest(job_);
+            } catch (const std::exception& e) {
+                SetError(e.what());
+            }
+        }
+
+        void OnOK() override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Napi::Object result = diffBestResult(env, job_,
+                                                 candidatesRef_.Value().As<Napi::Array>());
+            Callback().Call({env.Null(), result});
+            release();
+        }
+
+        void OnError(const Napi::Error& e) override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Callback().Call({e.Value()});
+            release();
+        }
+
+    private:
+        void release() {
+            oldRef_.Reset();
+            newRef_.Reset();
+            candidatesRef_.Reset();
+        }
+
+        ExternalMemoryCharge charge_;
+        DiffBestJob job_;
+        Napi::Reference<Napi::Value> oldRef_;
+        Napi::Reference<Napi::Value> newRef_;
+        Napi::ObjectReference candidatesRef_;
+    };
+
+    inline bool parseDiffEngine(const Napi::Value& value, DiffEngine& out) {
+        if (value.IsUndefined()) return true;
+        std::string name;
+        if (!getStringUtf8(value, name)) return false;
+        if (name == "diff") {
+            out = DiffEngine::Memory;
+        } else if (name == "window") {
+            out = DiffEngine::Window;
+        } else if (name == "singleStream") {
+            out = DiffEngine::SingleStream;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // diffBest(old, new, { candidates, timeBudgetMs, threads, maxMemory, checksum }[, cb])
+    // 每个候选为 { engine: 'diff' | 'window' | 'singleStream', ...该引擎的选项 }
+    Napi::Value diffBest(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        DiffBestJob job;
+        if (info.Length() < 3 ||
+            !getBufferData(info[0], &job.oldData, &job.oldLen) ||
+            !getBufferData(info[1], &job.newData, &job.newLen) ||
+            !info[2].IsObject() || info[2].IsFunction()) {
+            Napi::TypeError::New(env, "Invalid arguments: expected (oldBuf, newBuf, { candidates }).")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object options = info[2].As<Napi::Object>();
+        Napi::Value candidatesValue = options.Get("candidates");
+        if (!candidatesValue.IsArray() || candidatesValue.As<Napi::Array>().Length() == 0) {
+            Napi::TypeError::New(env, "Invalid candidates: expected a non-empty array.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Array candidates = candidatesValue.As<Napi::Array>();
+        if (options.Has("out") && !options.Get("out").IsUndefined()) {
+            Napi::TypeError::New(env, "diffBest does not support out: the result is an object.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        bool checksum = false;
+        if (options.Has("checksum")) {
+            Napi::Value value = options.Get("checksum");
+            if (!value.IsBoolean()) {
+                Napi::TypeError::New(env, "Invalid checksum: expected a boolean.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            checksum = value.As<Napi::Boolean>().Value();
+        }
+        for (uint32_t i = 0; i < candidates.Length(); ++i) {
+            Napi::Value value = candidates.Get(i);
+            const std::string label = "candidate #" + std::to_string(i);
+            if (!value.IsObject() || value.IsFunction()) {
+                Napi::TypeError::New(env, "Invalid " + label + ": expected an object.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            DiffBestCandidate candidate;
+            Napi::Object obj = value.As<Napi::Object>();
+            if (!parseDiffEngine(obj.Get("engine"), candidate.engine)) {
+                Napi::TypeError::New(env, "Invalid " + label +
+                                     ".engine: expected 'diff', 'window' or 'singleStream'.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            // 产物尺寸须在同一 checksum 设置下比较
+            if (obj.Has("checksum")) {
+                Napi::TypeError::New(env, "Invalid " + label +
+                                     ": set checksum on the diffBest options.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            if (!parseBufferDiffOptions(env, obj, candidate.engine, candidate.options)) {
+                return env.Undefined();
+            }
+            candidate.options.checksum = checksum;
+            job.candidates.push_back(std::move(candidate));
+        }
+        if (options.Has("timeBudgetMs")) {
+            Napi::Value value = options.Get("timeBudgetMs");
+            if (!value.IsNumber() || !std::isfinite(value.As<Napi::Number>().DoubleValue()) ||
+                value.As<Napi::Number>().DoubleValue() < 0) {
+                Napi::TypeError::New(env, "Invalid timeBudgetMs: expected a non-negative number.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            job.timeBudgetMs = value.As<Napi::Number>().DoubleValue();
+        }
+        job.threads = std::thread::hardware_concurrency();
+        if (job.threads == 0) job.threads = 1;
+        if (job.threads > kMaxDiffThreads) job.threads = kMaxDiffThreads;
+        if (options.Has("threads") &&
+            !parseIntegerOption(options.Get("threads"), 1, kMaxDiffThreads, job.threads)) {
+            Napi::TypeError::New(env, "Invalid threads: expected an integer from 1 to " +
+                                 std::to_string(kMaxDiffThreads) + ".")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (job.threads > job.candidates.size()) job.threads = job.candidates.size();
+        size_t maxMemory = (size_t)std::min<uint64_t>(physical_memory_bytes() / 2,
+                                                      std::numeric_limits<size_t>::max());
+        if (options.Has("maxMemory") &&
+            !parseIntegerOption(options.Get("maxMemory"), 0,
+                                std::numeric_limits<size_t>::max(), maxMemory)) {
+            Napi::TypeError::New(env, "Invalid maxMemory: expected a non-negative integer.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        diffBestThreadsWithin(job, maxMemory);
+
+        if (info.Length() > 3 && info[3].IsFunction()) {
+            Napi::Function callback = info[3].As<Napi::Function>();
+            DiffBestAsyncWorker* worker = new DiffBestAsyncWorker(
+                callback, std::move(job), info[0], info[1], candidates
+            );
+            worker->Queue();
+            return env.Undefined();
+        }
+
+        try {
+            ExternalMemoryCharge charge(env, NativeMemoryKind::Diff, diffBestMemoryEstimate(job));
+            runDiffBest(job);
+        } catch (const std::exception& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return diffBestResult(env, job, candidates);
+    }
+
+    // ============ diffReuse ============
+    // 同一 old、重复构建的 new:上次的 diff 仍能还原 new 时直接复用,否则重新 diff。
+    struct DiffReuseJob {
+        const uint8_t* oldData = nullptr;
+        size_t oldLen = 0;
+        const uint8_t* newData = nullptr;
+        size_t newLen = 0;
+        const uint8_t* prevDiffData = nullptr;
+        size_t prevDiffLen = 0;
+        NativeDiffOptions options;
+        bool reused = false;
+        std::vector<uint8_t> result;
+    };
+
+    inline void runDiffReuse(DiffReuseJob& job) {
+        const NativeDiffOptions& options = job.options;
+        job.reused = hdiff_reuse_cached(options.cache, job.oldData, job.oldLen,
+                                        job.newData, job.newLen,
+                                        job.prevDiffData, job.prevDiffLen, job.result,
+                                        options.compressionThreads, options.checksum,
+                                        options.trimIdentical, options.maxIndexMemory);
+    }
+
+    // { diff, reused }
+    inline Napi::Object diffReuseResult(Napi::Env env, DiffReuseJob& job) {
+        Napi::Object out = Napi::Object::New(env);
+        out.Set("diff", bufferFromVector(env, std::move(job.result)));
+        out.Set("reused", Napi::Boolean::New(env, job.reused));
+        return out;
+    }
+
+    class DiffReuseAsyncWorker : public Napi::AsyncWorker {
+    public:
+        DiffReuseAsyncWorker(Napi::Function& callback, DiffReuseJob job,
+                             const Napi::CallbackInfo& info)
+            : Napi::AsyncWorker(callback),
+              charge_(callback.Env(), NativeMemoryKind::Diff,
+                      diffMemoryEstimate(DiffEngine::Memory, job.options, job.oldLen,
+                                         job.newLen)),
+              job_(std::move(job)) {
+            for (size_t i = 0; i < 3; ++i) refs_[i] = Napi::Persistent(info[i]);
+        }
+
+        void Execute() override {
+            try {
+                runDiffReuse(job_);
+            } catch (const std::exception& e) {
+                SetError(e.what());
+            }
+        }
+
+        void OnOK() override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Napi::Object result = diffReuseResult(env, job_);
+            Callback().Call({env.Null(), result});
+            release();
+        }
+
+        void OnError(const Napi::Error& e) override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Callback().Call({e.Value()});
+            release();
+        }
+
+    private:
+        void release() {
+            for (auto& ref : refs_) ref.Reset();
+        }
+
+        ExternalMemoryCharge charge_;
+        DiffReuseJob job_;
+        Napi::Reference<Napi::Value> refs_[3];  // old, new, prevDiff
+    };
+
+    // diffReuse(old, new, prevDiff[, options][, cb]),options 同 diff()
+    Napi::Value diffReuse(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        DiffReuseJob job;
+        if (info.Length() < 3 ||
+            !getBufferData(info[0], &job.oldData, &job.oldLen) ||
+            !getBufferData(info[1], &job.newData, &job.newLen) ||
+            !getBufferData(info[2], &job.prevDiffData, &job.prevDiffLen)) {
+            Napi::TypeError::New(env, "Invalid arguments: expected Buffer or TypedArray (old, new, prevDiff).")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        size_t argIdx = 3;
+        if (info.Length() > argIdx && !info[argIdx].IsFunction()) {
+            if (!parseDiffOptions(env, info[argIdx], false, job.options, true)) {
+                return env.Undefined();
+            }
+            argIdx++;
+        }
+
+        if (info.Length() > argIdx && info[argIdx].IsFunction()) {
+            Napi::Function callback = info[argIdx].As<Napi::Function>();
+            DiffReuseAsyncWorker* worker =
+                new DiffReuseAsyncWorker(callback, std::move(job), info);
+            worker->Queue();
+            return env.Undefined();
+        }
+
+        try {
+            ExternalMemoryCharge charge(env, NativeMemoryKind::Diff,
+                                        diffMemoryEstimate(DiffEngine::Memory, job.options,
+                                                           job.oldLen, job.newLen));
+            runDiffReuse(job);
+        } catch (const std::exception& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return diffReuseResult(env, job);
+    }
+
+    // ============ nativeMemoryStats ============
+    // diff/patch 任务的工作集估算与未回收的结果 Buffer(字节),供监控使用
+    inline Napi::Object memoryUsageToObject(Napi::Env env, const NativeMemoryUsage& usage) {
+        Napi::Object out = Napi::Object::New(env);
+        out.Set("current", Napi::Number::New(env, (double)usage.current));
+        out.Set("peak", Napi::Number::New(env, (double)usage.peak));
+        out.Set("count", Napi::Number::New(env, (double)usage.count));
+        return out;
+    }
+
+    Napi::Value nativeMemoryStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        const NativeMemoryUsage total = native_memory_total();
+        Napi::Object out = Napi::Object::New(env);
+        out.Set("current", Napi::Number::New(env, (double)total.current));
+        out.Set("peak", Napi::Number::New(env, (double)total.peak));
+        out.Set("diff", memoryUsageToObject(env, native_memory_usage(NativeMemoryKind::Diff)));
+        out.Set("patch", memoryUsageToObject(env, native_memory_usage(NativeMemoryKind::Patch)));
+        out.Set("results", memoryUsageToObject(env, native_memory_usage(NativeMemoryKind::Result)));
+        const ArenaStats arena = arena_stats();
+        Napi::Object arenaOut = Napi::Object::New(env);
+        arenaOut.Set("live", Napi::Number::New(env, (double)arena.liveBytes));
+        arenaOut.Set("retained", Napi::Number::New(env, (double)arena.retainedBytes));
+        arenaOut.Set("allocations", Napi::Number::New(env, (double)arena.allocations));
+        arenaOut.Set("reused", Napi::Number::New(env, (double)arena.reused));
+        arenaOut.Set("hugeTlbFallbacks", Napi::Number::New(env, (double)arena.hugeTlbFallbacks));
+        out.Set("arena", arenaOut);
+        return out;
+    }
+
+    // ============ configureArena ============
+    // configureArena({ enabled, hugePages: 'off' | 'transparent' | 'hugetlb', retainBytes })
+    // 未给出的字段保持当前值;enabled 缺省为 true
+    Napi::Value configureArena(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsObject() || info[0].IsFunction()) {
+            Napi::TypeError::New(env, "Invalid arguments: expected { enabled, hugePages, retainBytes }.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object raw = info[0].As<Napi::Object>();
+        ArenaOptions options = arena_options();
+        options.enabled = true;
+        if (raw.Has("enabled")) {
+            Napi::Value value = raw.Get("enabled");
+            if (!value.IsBoolean()) {
+                Napi::TypeError::New(env, "Invalid enabled: expected a boolean.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            options.enabled = value.As<Napi::Boolean>().Value();
+        }
+        if (raw.Has("hugePages")) {
+            std::string mode;
+            if (!getStringUtf8(raw.Get("hugePages"), mode) ||
+                (mode != "off" && mode != "transparent" && mode != "hugetlb")) {
+                Napi::TypeError::New(env, "Invalid hugePages: expected 'off', 'transparent' or 'hugetlb'.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            options.hugePages = mode == "transparent" ? HugePageMode::Transparent
+                              : mode == "hugetlb"     ? HugePageMode::HugeTlb
+                                                      : HugePageMode::Off;
+        }
+        if (raw.Has("retainBytes")) {
+            size_t retainBytes = 0;
+            if (!parseIntegerOption(raw.Get("retainBytes"), 0,
+                                    std::numeric_limits<size_t>::max(), retainBytes)) {
+                Napi::TypeError::New(env, "Invalid retainBytes: expected a non-negative integer.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            options.retainBytes = retainBytes;
+        }
+        arena_configure(options);
+        return env.Undefined();
+    }
+
+    // ============ buildInfo ============
+    // 预编译包按基线指令集构建,热点内核在运行时按 CPU 选择变体;
+    // compiledFor 为编译期已启用的扩展(hdp_march 构建时非空)
+    Napi::Value buildInfo(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        const CpuFeatures& features = cpu_features();
+        Napi::Object cpu = Napi::Object::New(env);
+        cpu.Set("sse2", Napi::Boolean::New(env, features.sse2));
+        cpu.Set("sse41", Napi::Boolean::New(env, features.sse41));
+        cpu.Set("avx2", Napi::Boolean::New(env, features.avx2));
+        cpu.Set("bmi2", Napi::Boolean::New(env, features.bmi2));
+        cpu.Set("neon", Napi::Boolean::New(env, features.neon));
+
+        Napi::Array compiledFor = Napi::Array::New(env);
+        uint32_t compiledCount = 0;
+#if defined(__AVX2__)
+        compiledFor.Set(compiledCount++, Napi::String::New(env, "avx2"));
+#endif
+#if defined(__BMI2__)
+        compiledFor.Set(compiledCount++, Napi::String::New(env, "bmi2"));
+#endif
+        (void)compiledCount;
+
+#if defined(HDP_BUILD_PGO) && HDP_BUILD_PGO == 1
+        const char* pgo = "generate";
+#elif defined(HDP_BUILD_PGO) && HDP_BUILD_PGO == 2
+        const char* pgo = "use";
+#else
+        const char* pgo = "off";
+#endif
+#if defined(HDP_BUILD_LTO)
+        const bool lto = true;
+#else
+        const bool lto = false;
+#endif
+
+        Napi::Object out = Napi::Object::New(env);
+        out.Set("cpu", cpu);
+        out.Set("byteCompare", Napi::String::New(env, byte_compare_variant()));
+        out.Set("lzmaMatchFinder", Napi::String::New(env, lzma_match_finder_variant()));
+        out.Set("lzmaMatchFinderCpuCapable",
+                Napi::String::New(env, lzma_match_finder_cpu_capable()));
+        out.Set("compiledFor", compiledFor);
+        out.Set("lto", Napi::Boolean::New(env, lto));
+        out.Set("pgo", Napi::String::New(env, pgo));
+        return out;
+    }
+
+    // ============ getDiffInfo ============
+    // 只读文件头(buffer 或文件路径),用于预分配输出、快速拒绝不匹配的 old
+    // 以及按内存预算调度 patch 任务
+    Napi::Value getDiffInfo(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        const uint8_t* diffData = nullptr;
+        size_t diffLength = 0;
+        std::string diffPath;
+        const bool isPath = info.Length() > 0 && getStringUtf8(info[0], diffPath);
+        if (!isPath && (info.Length() < 1 || !getBufferData(info[0], &diffData, &diffLength))) {
+            Napi::TypeError::New(env, "Invalid arguments: expected a diff Buffer/TypedArray or file path.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        HpatchDiffInfo diffInfo;
+        try {
+            diffInfo = isPath ? hpatch_diff_info(diffPath.c_str())
+                              : hpatch_diff_info(diffData, diffLength);
+        } catch (const std::exception& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        const uint64_t streamMemory = diffInfo.workMemory + diffInfo.decoderMemory;
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("format", Napi::String::New(env, diffInfo.isSingle ? "HDIFFSF20" : "HDIFF13"));
+        result.Set("oldDataSize", Napi::Number::New(env, static_cast<double>(diffInfo.oldDataSize)));
+        result.Set("newDataSize", Napi::Number::New(env, static_cast<double>(diffInfo.newDataSize)));
+        result.Set("compressType", Napi::String::New(env, diffInfo.compressType));
+        result.Set("stepMemSize", Napi::Number::New(env, static_cast<double>(diffInfo.stepMemSize)));
+        result.Set("checksum", Napi::Boolean::New(env, diffInfo.hasChecksum));
+        // patch()/Patcher/patchMany 只接受 single 格式;其输出 Buffer 也计入
+        result.Set("patchMemory", diffInfo.isSingle
+            ? Napi::Number::New(env, static_cast<double>(streamMemory + diffInfo.newDataSize))
+            : env.Null());
+        result.Set("streamPatchMemory", Napi::Number::New(env, static_cast<double>(streamMemory)));
+        result.Set("memoryExact", Napi::Boolean::New(env, diffInfo.decoderMemoryExact));
+        return result;
+    }
+
+    // ============ 批量 patch ============
+    // 一次 N-API 调用、一个 AsyncWorker 完成整批;条目在内部线程池上并行,
+    // 每个线程复用自己的 tempCache。Buffer 条目的结果 Buffer 在主线程按 diff
+    // 头预先分配,工作线程直接写入;单条失败只记录在该条目上。
+    struct PatchManyItem {
+        bool isPath = false;
+        const uint8_t* oldData = nullptr;
+        size_t oldLen = 0;
+        const uint8_t* diffData = nullptr;
+        size_t diffLen = 0;
+        uint8_t* outData = nullptr;
+        size_t outLen = 0;
+        std::string oldPath;
+        std::string diffPath;
+        std::string outPath;
+        std::string error;
+    };
+
+    class PatchManyAsyncWorker : public Napi::AsyncWorker {
+    public:
+        PatchManyAsyncWorker(Napi::Function& callback,
+                             std::vector<PatchManyItem> items,
+                             const Napi::Value& itemsValue,
+                             const Napi::Array& results,
+                             size_t threads)
+            : Napi::AsyncWorker(callback),
+              items_(std::move(items)),
+              threads_(threads),
+              itemsRef_(Napi::Persistent(itemsValue)),
+              resultsRef_(Napi::Persistent(results.As<Napi::Object>())) {
+        }
+
+        void Execute() override {
+            std::vector<PatchBuffer> caches(threads_);
+            parallel_for(items_.size(), threads_, [&](size_t index, size_t worker) {
+                PatchManyItem& item = items_[index];
+                if (!item.error.empty()) return;
+                try {
+                    if (item.isPath) {
+                        hpatch_file(item.oldPath.c_str(), item.diffPath.c_str(),
+                                    item.outPath.c_str());
+                    } else {
+                        hpatch_into(item.oldData, item.oldLen, item.diffData, item.diffLen,
+                                    item.outData, item.outLen, caches[worker]);
+                    }
+                } catch (const std::exception& e) {
+                    item.error = e.what();
+                }
+            });
+        }
+
+        void OnOK() override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Napi::Object results = resultsRef_.Value();
+            for (size_t i = 0; i < items_.size(); ++i) {
+                const uint32_t index = static_cast<uint32_t>(i);
+                if (!items_[i].error.empty()) {
+                    results.Set(index, Napi::Error::New(env, items_[i].error).Value());
+                } else if (items_[i].isPath) {
+                    results.Set(index, Napi::String::New(env, items_[i].outPath));
+                }
+            }
+            Callback().Call({env.Null(), results});
+            itemsRef_.Reset();
+            resultsRef_.Reset();
+        }
+
+        void OnError(const Napi::Error& e) override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            Callback().Call({e.Value()});
+            itemsRef_.Reset();
+            resultsRef_.Reset();
+        }
+
+    private:
+        std::vector<PatchManyItem> items_;
+        size_t threads_;
+        Napi::Reference<Napi::Value> itemsRef_;
+        Napi::ObjectReference resultsRef_;
+    };
+
+    // patchMany(items, options, cb):Promise 形态由 index.js 包装
+    Napi::Value patchMany(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 3 || !info[0].IsArray() || !info[2].IsFunction()) {
+            Napi::TypeError::New(env, "Invalid arguments: expected (items[], options, cb).")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Array itemArray = info[0].As<Napi::Array>();
+        const uint32_t count = itemArray.Length();
+
+        size_t threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        if (!info[1].IsUndefined()) {
+            if (!info[1].IsObject() || info[1].IsFunction()) {
+                Napi::TypeError::New(env, "Invalid patchMany options: expected an object.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            Napi::Object options = info[1].As<Napi::Object>();
+            if (options.Has("threads") &&
+                !parseIntegerOption(options.Get("threads"), 1, kMaxPatchManyThreads, threads)) {
+                Napi::TypeError::New(env, "Invalid threads: expected an integer from 1 to 64.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+        }
+
+        // 结果数组先放入 Buffer 条目的输出 Buffer,其余位置在完成时填充
+        std::vector<PatchManyItem> items(count);
+        Napi::Array results = Napi::Array::New(env, count);
+        for (uint32_t i = 0; i < count; ++i) {
+            Napi::Value value = itemArray.Get(i);
+            PatchManyItem& item = items[i];
+            if (!value.IsObject()) {
+                Napi::TypeError::New(env, "Invalid patchMany item #" + std::to_string(i) +
+                                     ": expected an object.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            Napi::Object obj = value.As<Napi::Object>();
+            if (obj.Has("oldPath")) {
+                item.isPath = true;
+                if (!getStringUtf8(obj.Get("oldPath"), item.oldPath) ||
+                    !getStringUtf8(obj.Get("diffPath"), item.diffPath) ||
+                    !getStringUtf8(obj.Get("outPath"), item.outPath)) {
+                    Napi::TypeError::New(env, "Invalid patchMany item #" + std::to_string(i) +
+                                         ": expected { oldPath, diffPath, outPath }.")
+                        .ThrowAsJavaScriptException();
+                    return env.Undefined();
+                }
+                continue;
+            }
+            if (!getBufferData(obj.Get("old"), &item.oldData, &item.oldLen) ||
+                !getBufferData(obj.Get("diff"), &item.diffData, &item.diffLen)) {
+                Napi::TypeError::New(env, "Invalid patchMany item #" + std::to_string(i) +
+                                     ": expected { old, diff } as Buffer or TypedArray.")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            try {
+                item.outLen = hpatch_new_size(item.oldLen, item.diffData, item.diffLen);
+            } catch (const std::exception& e) {
+                item.error = e.what();
+                continue;
+            }
+            Napi::Buffer<uint8_t> out = Napi::Buffer<uint8_t>::New(env, item.outLen);
+            item.outData = out.Data();
+            results.Set(i, out);
+        }
+
+        Napi::Function callback = info[2].As<Napi::Function>();
+        PatchManyAsyncWorker* worker = new PatchManyAsyncWorker(
+            callback, std::move(items), info[0], results, threads
+        );
+        worker->Queue();
+        return env.Undefined();
+    }
+
+    // ============ 可复用的 Patcher ============
+    // 持有跨调用复用的 tempCache:稳态下同尺寸级别的小 patch 不再为工作区
+    // 分配内存,调用方提供 out 时也不再分配输出。LZMA2 解码器状态(含字典)
+    // 仍由 HDiffPatch 的解压插件每次调用分配、释放,patch 并非零堆分配。
+    // 同一 Patcher 的 patchAsync() 按提交顺序串行执行,执行期间同步 patch() 报错。
+    class PatcherAsyncWorker;
+
+    class Patcher : public Napi::ObjectWrap<Patcher> {
+    public:
+        static Napi::Function Define(Napi::Env env) {
+            return DefineClass(env, "Patcher", {
+                InstanceMethod("patch", &Patcher::Patch),
+                InstanceMethod("patchAsync", &Patcher::PatchAsync),
+            });
+        }
+
+        explicit Patcher(const Napi::CallbackInfo& info)
+            : Napi::ObjectWrap<Patcher>(info) {
+        }
+
+        PatchBuffer& tempCache() { return tempCache_; }
+        void OnJobDone();
+
+    private:
+        struct Args {
+            const uint8_t* oldData = nullptr;
+            size_t oldLength = 0;
+            const uint8_t* diffData = nullptr;
+            size_t diffLength = 0;
+            uint8_t* outData = nullptr;
+            size_t outLength = 0;
+            bool hasOut = false;
+        };
+
+        static bool ParseArgs(const Napi::CallbackInfo& info, Args& args) {
+            if (info.Length() < 2 ||
+                !getBufferData(info[0], &args.oldData, &args.oldLength) ||
+                !getBufferData(info[1], &args.diffData, &args.diffLength)) {
+                return false;
+            }
+            if (info.Length() > 2 && !info[2].IsUndefined()) {
+                const uint8_t* outData = nullptr;
+                if (!getBufferData(info[2], &outData, &args.outLength)) return false;
+                args.outData = const_cast<uint8_t*>(outData);
+                args.hasOut = true;
+            }
+            return true;
+        }
+
+        Napi::Value Patch(const Napi::CallbackInfo& info);
+        Napi::Value PatchAsync(const Napi::CallbackInfo& info);
+
+        PatchBuffer tempCache_;
+        bool busy_ = false;
+        std::deque<PatcherAsyncWorker*> pending_;
+    };
+
+    class PatcherAsyncWorker : public Napi::AsyncWorker {
+    public:
+        PatcherAsyncWorker(Napi::Env env, Patcher* patcher, const Napi::CallbackInfo& info,
+                           const uint8_t* oldData, size_t oldLen,
+                           const uint8_t* diffData, size_t diffLen,
+                           const Napi::Value& outValue, uint8_t* outData, size_t outLen,
+                           bool returnLength)
+            : Napi::AsyncWorker(env),
+              deferred_(Napi::Promise::Deferred::New(env)),
+              patcher_(patcher),
+              oldData_(oldData),
+              oldLen_(oldLen),
+              diffData_(diffData),
+              diffLen_(diffLen),
+              outData_(outData),
+              outLen_(outLen),
+              returnLength_(returnLength),
+              patcherRef_(Napi::Persistent(info.This().As<Napi::Object>())),
+              oldRef_(Napi::Persistent(info[0])),
+              diffRef_(Napi::Persistent(info[1])),
+              outRef_(Napi::Persistent(outValue)) {
+        }
+
+        Napi::Promise Promise() const { return deferred_.Promise(); }
+
+        void Execute() override {
+            try {
+                written_ = hpatch_into(oldData_, oldLen_, diffData_, diffLen_,
+                                       outData_, outLen_, patcher_->tempCache());
+            } catch (const std::exception& e) {
+                SetError(e.what());
+            }
+        }
+
+        void OnOK() override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            if (returnLength_) {
+                deferred_.Resolve(Napi::Number::New(env, static_cast<double>(written_)));
+            } else {
+                deferred_.Resolve(outRef_.Value());
+            }
+            Finish();
+        }
+
+        void OnError(const Napi::Error& e) override {
+            Napi::Env env = Env();
+            Napi::HandleScope scope(env);
+            deferred_.Reject(e.Value());
+            Finish();
+        }
+
+    private:
+        void Finish() {
+            Patcher* patcher = patcher_;
+            oldRef_.Reset();
+            diffRef_.Reset();
+            outRef_.Reset();
+            patcher->OnJobDone();
+            patcherRef_.Reset();
+        }
+
+        Napi::Promise::Deferred deferred_;
+        Patcher* patcher_;
+        const uint8_t* oldData_;
+        size_t oldLen_;
+        const uint8_t* diffData_;
+        size_t diffLen_;
+        uint8_t* outData_;
+        size_t outLen_;
+        bool returnLength_;
+        size_t written_ = 0;
+        Napi::ObjectReference patcherRef_;
+        Napi::Reference<Napi::Value> oldRef_;
+        Napi::Reference<Napi::Value> diffRef_;
+        Napi::Reference<Napi::Value> outRef_;
+    };
+
+    void Patcher::OnJobDone() {
+        if (pending_.empty()) {
+            busy_ = false;
+            return;
+        }
+        PatcherAsyncWorker* next = pending_.front();
+        pending_.pop_front();
+        next->Queue();
+    }
+
+    Napi::Value Patcher::Patch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Args args;
+        if (!ParseArgs(info, args)) {
+            Napi::TypeError::New(env, "Invalid arguments: expected (old, diff[, out]) as Buffer or TypedArray.")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (busy_) {
+            Napi::Error::New(env, "Patcher is busy with patchAsync().")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        try {
+            if (args.hasOut) {
+                const size_t written = hpatch_into(args.oldData, args.oldLength,
+                                                   args.diffData, args.diffLength,
+                                                   args.outData, args.outLength, tempCache_);
+                return Napi::Number::New(env, static_cast<double>(written));
+            }
+            const size_t newSize = hpatch_new_size(args.oldLength, args.diffData, args.diffLength);
+            Napi::Buffer<uint8_t> result = Napi::Buffer<uint8_t>::New(env, newSize);
+            hpatch_into(args.oldData, args.oldLength, args.diffData, args.diffLength,
+                        result.Data(), newSize, tempCache_);
+            return result;
+        } catch (const std::exception& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+
+    Napi::Value Patcher::PatchAsync(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Args args;
+        if (!ParseArgs(info, args)) {
+            Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+            deferred.Reject(Napi::TypeError::New(
+                env, "Invalid arguments: expected (old, diff[, out]) as Buffer or TypedArray.").Value());
+            return deferred.Promise();
+        }
+
+        // 未提供 out 时在主线程按 diff 头声明的尺寸预先分配结果 Buffer
+        Napi::Value outValue = args.hasOut ? info[2] : env.Undefined();
+        if (!args.hasOut) {
+            try {
+                args.outLength = hpatch_new_size(args.oldLength, args.diffData, args.diffLength);
+            } catch (const std::exception& e) {
+                Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+                deferred.Reject(Napi::Error::New(env, e.what()).Value());
+                return deferred.Promise();
+            }
+            Napi::Buffer<uint8_t> result = Napi::Buffer<uint8_t>::New(env, args.outLength);
+            args.outData = result.Data();
+            outValue = result;
+        }
+
+        PatcherAsyncWorker* worker = new PatcherAsyncWorker(
+            env, this, info, args.oldData, args.oldLength, args.diffData, args.diffLength,
+            outValue, args.outData, args.outLength, args.hasOut
+        );
+        Napi::Promise promise = worker->Promise();
+        if (busy_) {
+            pending_.push_back(worker);
+        } else {
+            busy_ = true;
+            worker->Queue();
+        }
+        return promise;
+    }
+
     Napi::Object Init(Napi::Env env, Napi::Object exports) {
+        cpu_dispatch_init();
         exports.Set(Napi::String::New(env, "diff"), Napi::Function::New(env, diff));
         exports.Set(Napi::String::New(env, "patch"), Napi::Function::New(env, patch));
         exports.Set(Napi::String::New(env, "diffStream"), Napi::Function::New(env, diffStream));
         exports.Set(Napi::String::New(env, "patchStream"), Napi::Function::New(env, patchStream));
         exports.Set(Napi::String::New(env, "diffSingleStream"), Napi::Function::New(env, diffSingleStream));
         exports.Set(Napi::String::New(env, "diffWindow"), Napi::Function::New(env, diffWindow));
+        exports.Set(Napi::String::New(env, "diffFile"), Napi::Function::New(env, diffFile));
+        exports.Set(Napi::String::New(env, "diffMany"), Napi::Function::New(env, diffMany));
+        exports.Set(Napi::String::New(env, "diffBest"), Napi::Function::New(env, diffBest));
+        exports.Set(Napi::String::New(env, "diffReuse"), Napi::Function::New(env, diffReuse));
+        exports.Set(Napi::String::New(env, "patchRange"), Napi::Function::New(env, patchRange));
         exports.Set(Napi::String::New(env, "patchSingleStream"), Napi::Function::New(env, patchSingleStream));
+        exports.Set(Napi::String::New(env, "patchChain"), Napi::Function::New(env, patchChain));
+        exports.Set(Napi::String::New(env, "getDiffInfo"), Napi::Function::New(env, getDiffInfo));
+        exports.Set(Napi::String::New(env, "patchMany"), Napi::Function::New(env, patchMany));
+        exports.Set(Napi::String::New(env, "nativeMemoryStats"), Napi::Function::New(env, nativeMemoryStats));
+        exports.Set(Napi::String::New(env, "buildInfo"), Napi::Function::New(env, buildInfo));
+        exports.Set(Napi::String::New(env, "configureArena"), Napi::Function::New(env, configureArena));
+        exports.Set(Napi::String::New(env, "diffFeed"), Napi::Function::New(env, diffFeed));
+        exports.Set(Napi::String::New(env, "Patcher"), Patcher::Define(env));
+        exports.Set(Napi::String::New(env, "NewFeed"), NewFeed::Define(env));
         return exports;
     }
 
@@ -0,0 +1,99 @@
+#include "mapped_file.h"
+#include <limits>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const char* path) {
+    if (opened_ || !path) return false;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) ||
+        (unsigned long long)fileSize.QuadPart > std::numeric_limits<size_t>::max()) {
+        CloseHandle(file);
+        return false;
+    }
+    size_ = (size_t)fileSize.QuadPart;
+    if (size_ > 0) {
+        // 映射对象持有文件引用,文件句柄可以立即关闭
+        mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping_) return false;
+        data_ = (const uint8_t*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        if (!data_) {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+            return false;
+        }
+    } else {
+        CloseHandle(file);
+    }
+#else
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 ||
+        (unsigned long long)st.st_size > std::numeric_limits<size_t>::max()) {
+        ::close(fd);
+        return false;
+    }
+    size_ = (size_t)st.st_size;
+    if (size_ > 0) {
+        // 映射持有文件引用,fd 可以立即关闭
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            size_ = 0;
+            return false;
+        }
+        data_ = (const uint8_t*)p;
+    } else {
+        ::close(fd);
+    }
+#endif
+    opened_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (!opened_) return;
+    opened_ = false;
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    mapping_ = nullptr;
+#else
+    if (data_) ::munmap((void*)data_, size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::advise(MapAdvice advice) const {
+    if (!data_) return;
+#if !defined(_WIN32) && defined(MADV_NORMAL)
+    int flag = MADV_NORMAL;
+    switch (advice) {
+        case MapAdvice::Normal: flag = MADV_NORMAL; break;
+        case MapAdvice::Random: flag = MADV_RANDOM; break;
+        case MapAdvice::Sequential: flag = MADV_SEQUENTIAL; break;
+        case MapAdvice::WillNeed: flag = MADV_WILLNEED; break;
+    }
+    (void)::madvise((void*)data_, size_, flag);
+#else
+    (void)advice;
+#endif
+}
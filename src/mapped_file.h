@@ -0,0 +1,45 @@
+/**
+ * mapped_file - 只读内存映射整个文件
+ * POSIX 用 mmap + madvise,Windows 用 CreateFileMapping。映射失败
+ * (例如 32 位进程地址空间不足)时 open() 返回 false,由调用方回退到读文件。
+ * 映射期间文件被其他进程截断会触发 SIGBUS,调用方应保证输入在使用期间不变。
+ */
+
+#ifndef HDIFFPATCH_MAPPED_FILE_H
+#define HDIFFPATCH_MAPPED_FILE_H
+#include <stddef.h>
+#include <stdint.h>
+
+enum class MapAdvice {
+    Normal,
+    Random,      // 随机访问:关闭内核预读
+    Sequential,  // 顺序访问:加大预读,读过的页可尽快回收
+    WillNeed,    // 整个文件都会用到:立即开始异步读入
+};
+
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path);
+    void close();
+    // 仅为提示(madvise),失败不影响正确性;Windows 上忽略
+    void advise(MapAdvice advice) const;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return opened_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool opened_ = false;
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
+
+#endif
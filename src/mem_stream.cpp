@@ -0,0 +1,38 @@
+#include "mem_stream.h"
+#include <cstring>
+#include <limits>
+
+VectorStreamOutput::VectorStreamOutput(std::vector<uint8_t>& buf)
+    : buf_(buf) {
+    base.streamImport = this;
+    base.streamSize = ~(hpatch_StreamPos_t)0;
+    base.read_writed = read_writed;
+    base.write = write;
+}
+
+hpatch_BOOL VectorStreamOutput::read_writed(const hpatch_TStreamOutput* stream,
+                                            hpatch_StreamPos_t readFromPos,
+                                            unsigned char* out_data, unsigned char* out_data_end) {
+    const VectorStreamOutput* self = (const VectorStreamOutput*)stream->streamImport;
+    const size_t len = (size_t)(out_data_end - out_data);
+    if ((readFromPos > (hpatch_StreamPos_t)self->buf_.size()) ||
+        (len > self->buf_.size() - (size_t)readFromPos)) {
+        return hpatch_FALSE;
+    }
+    if (len > 0) std::memcpy(out_data, self->buf_.data() + (size_t)readFromPos, len);
+    return hpatch_TRUE;
+}
+
+hpatch_BOOL VectorStreamOutput::write(const hpatch_TStreamOutput* stream,
+                                      hpatch_StreamPos_t writeToPos,
+                                      const unsigned char* data, const unsigned char* data_end) {
+    VectorStreamOutput* self = (VectorStreamOutput*)stream->streamImport;
+    const size_t len = (size_t)(data_end - data);
+    if (writeToPos > (hpatch_StreamPos_t)(std::numeric_limits<size_t>::max() - len)) {
+        return hpatch_FALSE;
+    }
+    const size_t end = (size_t)writeToPos + len;
+    if (end > self->buf_.size()) self->buf_.resize(end);
+    if (len > 0) std::memcpy(self->buf_.data() + (size_t)writeToPos, data, len);
+    return hpatch_TRUE;
+}
@@ -0,0 +1,30 @@
+/**
+ * mem_stream - 以 std::vector 为后备的可增长输出流
+ * 供流式/window diff 引擎直接输出到内存:支持随机写(引擎会回写文件头)
+ * 与回读已写数据,写到末尾之外时自动扩容。
+ */
+
+#ifndef HDIFFPATCH_MEM_STREAM_H
+#define HDIFFPATCH_MEM_STREAM_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "../HDiffPatch/libHDiffPatch/HPatch/patch_types.h"
+
+struct VectorStreamOutput {
+    hpatch_TStreamOutput base;
+
+    explicit VectorStreamOutput(std::vector<uint8_t>& buf);
+    VectorStreamOutput(const VectorStreamOutput&) = delete;
+    VectorStreamOutput& operator=(const VectorStreamOutput&) = delete;
+
+private:
+    static hpatch_BOOL read_writed(const hpatch_TStreamOutput* stream, hpatch_StreamPos_t readFromPos,
+                                   unsigned char* out_data, unsigned char* out_data_end);
+    static hpatch_BOOL write(const hpatch_TStreamOutput* stream, hpatch_StreamPos_t writeToPos,
+                             const unsigned char* data, const unsigned char* data_end);
+
+    std::vector<uint8_t>& buf_;
+};
+
+#endif
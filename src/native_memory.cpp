@@ -0,0 +1,70 @@
+#include "native_memory.h"
+#include <atomic>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <unistd.h>
+#endif
+
+namespace {
+    struct Counter {
+        std::atomic<uint64_t> current{0};
+        std::atomic<uint64_t> peak{0};
+        std::atomic<uint64_t> count{0};
+
+        void add(uint64_t bytes) {
+            const uint64_t now = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            count.fetch_add(1, std::memory_order_relaxed);
+            uint64_t seen = peak.load(std::memory_order_relaxed);
+            while (now > seen &&
+                   !peak.compare_exchange_weak(seen, now, std::memory_order_relaxed)) {
+            }
+        }
+        void sub(uint64_t bytes) {
+            current.fetch_sub(bytes, std::memory_order_relaxed);
+            count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        NativeMemoryUsage load() const {
+            NativeMemoryUsage usage;
+            usage.current = current.load(std::memory_order_relaxed);
+            usage.peak = peak.load(std::memory_order_relaxed);
+            usage.count = count.load(std::memory_order_relaxed);
+            return usage;
+        }
+    };
+
+    Counter g_kinds[kNativeMemoryKindCount];
+    Counter g_total;
+}
+
+void native_memory_add(NativeMemoryKind kind, uint64_t bytes) {
+    g_kinds[(size_t)kind].add(bytes);
+    g_total.add(bytes);
+}
+
+void native_memory_sub(NativeMemoryKind kind, uint64_t bytes) {
+    g_kinds[(size_t)kind].sub(bytes);
+    g_total.sub(bytes);
+}
+
+NativeMemoryUsage native_memory_usage(NativeMemoryKind kind) {
+    return g_kinds[(size_t)kind].load();
+}
+
+NativeMemoryUsage native_memory_total() {
+    return g_total.load();
+}
+
+uint64_t physical_memory_bytes() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? (uint64_t)status.ullTotalPhys : 0;
+#else
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) return 0;
+    return (uint64_t)pages * (uint64_t)pageSize;
+#endif
+}
@@ -0,0 +1,34 @@
+/**
+ * native_memory - 原生内存的进程级统计
+ * 按类别记录当前与峰值字节:diff/patch 任务运行期间的工作集估算,以及
+ * 交给 JS 的外部结果缓冲。计数为原子操作,可在任意线程更新;同一份字节
+ * 由 main.cc 通过 napi_adjust_external_memory 上报给 V8 的 GC 启发式。
+ */
+
+#ifndef HDIFFPATCH_NATIVE_MEMORY_H
+#define HDIFFPATCH_NATIVE_MEMORY_H
+#include <stddef.h>
+#include <stdint.h>
+
+enum class NativeMemoryKind {
+    Diff,     // 运行中的 diff 任务(后缀索引、窗口、编码缓冲)
+    Patch,    // 运行中的 patch 任务(new 缓冲、工作区、解压字典)
+    Result,   // 已交给 JS、尚未被 GC 回收的结果 Buffer
+};
+const size_t kNativeMemoryKindCount = 3;
+
+struct NativeMemoryUsage {
+    uint64_t current = 0;
+    uint64_t peak = 0;
+    uint64_t count = 0;  // 当前持有的任务数 / 结果 Buffer 数
+};
+
+void native_memory_add(NativeMemoryKind kind, uint64_t bytes);
+void native_memory_sub(NativeMemoryKind kind, uint64_t bytes);
+NativeMemoryUsage native_memory_usage(NativeMemoryKind kind);
+// 所有类别之和;peak 为总量的峰值,不是各类峰值之和
+NativeMemoryUsage native_memory_total();
+// 物理内存总量(字节),取不到时为 0;用作并发任务的缺省内存上限
+uint64_t physical_memory_bytes();
+
+#endif
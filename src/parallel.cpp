@@ -0,0 +1,29 @@
+#include "parallel.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+void parallel_for(size_t count, size_t threadCount,
+                  const std::function<void(size_t index, size_t worker)>& fn) {
+    if (threadCount > count) threadCount = count;
+    if (threadCount == 0) return;
+
+    std::atomic<size_t> next(0);
+    auto run = [&](size_t worker) {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i, worker);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    try {
+        for (size_t worker = 1; worker < threadCount; ++worker) {
+            threads.emplace_back(run, worker);
+        }
+    } catch (...) {
+        // 线程创建失败时已启动的线程与调用线程照常分担全部任务
+    }
+    run(0);
+    for (std::thread& t : threads) t.join();
+}
@@ -0,0 +1,16 @@
+/**
+ * parallel - 简单的批量并行执行
+ * 在 threadCount 个线程(含调用线程)上执行 fn(index, worker),任务按原子
+ * 计数领取,worker 为 [0, threadCount) 内的线程序号,可用来索引每线程缓存。
+ * fn 不得抛出异常(调用方按条目自行记录错误)。
+ */
+
+#ifndef HDIFFPATCH_PARALLEL_H
+#define HDIFFPATCH_PARALLEL_H
+#include <stddef.h>
+#include <functional>
+
+void parallel_for(size_t count, size_t threadCount,
+                  const std::function<void(size_t index, size_t worker)>& fn);
+
+#endif
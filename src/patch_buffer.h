@@ -0,0 +1,45 @@
+/**
+ * patch_buffer - patch 输出/缓存用的字节缓冲
+ * patch 核心会完整写满输出和工作区,std::vector 的 resize() 却先清零一遍,
+ * 多出一整遍内存写入。这里的分配器对无参构造做默认初始化(不清零),
+ * 其余行为与 std::allocator 相同。add/copy 循环本身仍是 HDiffPatch 的标量实现。
+ * 启用 buffer_arena 时,大块分配改由 arena 提供(可用大页、跨任务复用)。
+ */
+
+#ifndef HDIFFPATCH_PATCH_BUFFER_H
+#define HDIFFPATCH_PATCH_BUFFER_H
+#include <stdint.h>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "buffer_arena.h"
+
+template <class T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template <class U>
+    struct rebind { typedef DefaultInitAllocator<U> other; };
+
+    using std::allocator<T>::allocator;
+
+    T* allocate(size_t n) {
+        if (n * sizeof(T) >= kArenaMinAlloc) {
+            if (void* p = arena_alloc(n * sizeof(T))) return (T*)p;
+        }
+        return std::allocator<T>::allocate(n);
+    }
+    // arena 配置可能在分配后改变,按块归属而不是当前配置决定释放路径
+    void deallocate(T* p, size_t n) {
+        if (n * sizeof(T) >= kArenaMinAlloc && arena_free(p)) return;
+        std::allocator<T>::deallocate(p, n);
+    }
+
+    template <class U>
+    void construct(U* p) { ::new ((void*)p) U; }
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) { ::new ((void*)p) U(std::forward<Args>(args)...); }
+};
+
+typedef std::vector<uint8_t, DefaultInitAllocator<uint8_t>> PatchBuffer;
+
+#endif
@@ -0,0 +1,185 @@
+#include "pipelined_decompress.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+
+namespace {
+    // 一个压缩子流:解压线程按块生产,patch 线程按需消费
+    struct PipelineHandle {
+        PipelinedDecompress* owner = nullptr;
+        hpatch_decompressHandle innerHandle = nullptr;
+        hpatch_StreamPos_t remaining = 0;  // 尚未解压的字节数
+
+        std::mutex mutex;
+        std::condition_variable produced;  // 通知消费者有新块或出错
+        std::condition_variable consumed;  // 通知生产者有空位或停止
+        std::deque<std::vector<unsigned char>> ready;
+        std::vector<std::vector<unsigned char>> freeChunks;
+        size_t readPos = 0;                // ready.front() 中已消费的字节
+        bool failed = false;
+        bool stopping = false;
+        std::thread worker;
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (remaining > 0) {
+                consumed.wait(lock, [this] { return stopping || ready.size() < owner->depth; });
+                if (stopping) return;
+                std::vector<unsigned char> chunk;
+                if (!freeChunks.empty()) {
+                    chunk = std::move(freeChunks.back());
+                    freeChunks.pop_back();
+                }
+                const size_t n = (size_t)std::min<hpatch_StreamPos_t>(remaining, owner->chunkSize);
+                lock.unlock();
+
+                chunk.resize(n);
+                const bool ok = owner->inner->decompress_part(innerHandle, chunk.data(),
+                                                              chunk.data() + n) != hpatch_FALSE;
+
+                lock.lock();
+                if (!ok) {
+                    failed = true;
+                    produced.notify_one();
+                    return;
+                }
+                remaining -= n;
+                ready.push_back(std::move(chunk));
+                produced.notify_one();
+            }
+        }
+
+        void start() {
+            worker = std::thread([this] { run(); });
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            consumed.notify_one();
+            if (worker.joinable()) worker.join();
+            stopping = false;
+            failed = false;
+            readPos = 0;
+            for (auto& chunk : ready) freeChunks.push_back(std::move(chunk));
+            ready.clear();
+        }
+
+        bool read(unsigned char* out, unsigned char* out_end) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (out < out_end) {
+                // remaining 为 0 且队列已空:读超出子流长度
+                produced.wait(lock, [this] { return failed || !ready.empty() || remaining == 0; });
+                if (ready.empty()) return false;
+                std::vector<unsigned char>& front = ready.front();
+                const size_t n = std::min((size_t)(out_end - out), front.size() - readPos);
+                std::memcpy(out, front.data() + readPos, n);
+                out += n;
+                readPos += n;
+                if (readPos == front.size()) {
+                    freeChunks.push_back(std::move(front));
+                    ready.pop_front();
+                    readPos = 0;
+                    consumed.notify_one();
+                }
+            }
+            return true;
+        }
+    };
+
+    hpatch_decompressHandle pipeline_open(hpatch_TDecompress* decompressPlugin,
+                                          hpatch_StreamPos_t dataSize,
+                                          const hpatch_TStreamInput* codeStream,
+                                          hpatch_StreamPos_t code_begin,
+                                          hpatch_StreamPos_t code_end) {
+        PipelinedDecompress* self = (PipelinedDecompress*)decompressPlugin;
+        // 内部 open 在 patch 线程完成:读属性、分配字典的错误按原路径返回
+        hpatch_decompressHandle innerHandle =
+            self->inner->open(self->inner, dataSize, codeStream, code_begin, code_end);
+        if (!innerHandle) {
+            self->base.decError = self->inner->decError;
+            return nullptr;
+        }
+        PipelineHandle* handle = nullptr;
+        try {
+            handle = new PipelineHandle();
+            handle->owner = self;
+            handle->innerHandle = innerHandle;
+            handle->remaining = dataSize;
+            handle->start();
+        } catch (...) {
+            delete handle;
+            self->inner->close(self->inner, innerHandle);
+            return nullptr;
+        }
+        return handle;
+    }
+
+    hpatch_BOOL pipeline_close(hpatch_TDecompress* decompressPlugin,
+                               hpatch_decompressHandle decompressHandle) {
+        PipelinedDecompress* self = (PipelinedDecompress*)decompressPlugin;
+        PipelineHandle* handle = (PipelineHandle*)decompressHandle;
+        if (!handle) return hpatch_TRUE;
+        handle->stop();
+        const hpatch_BOOL ok = self->inner->close(self->inner, handle->innerHandle);
+        if (self->inner->decError) self->base.decError = self->inner->decError;
+        delete handle;
+        return ok;
+    }
+
+    hpatch_BOOL pipeline_decompress_part(hpatch_decompressHandle decompressHandle,
+                                         unsigned char* out_part_data,
+                                         unsigned char* out_part_data_end) {
+        PipelineHandle* handle = (PipelineHandle*)decompressHandle;
+        return handle->read(out_part_data, out_part_data_end) ? hpatch_TRUE : hpatch_FALSE;
+    }
+
+    hpatch_BOOL pipeline_reset_code(hpatch_decompressHandle decompressHandle,
+                                    hpatch_StreamPos_t dataSize,
+                                    const hpatch_TStreamInput* codeStream,
+                                    hpatch_StreamPos_t code_begin,
+                                    hpatch_StreamPos_t code_end) {
+        PipelineHandle* handle = (PipelineHandle*)decompressHandle;
+        handle->stop();
+        hpatch_TDecompress* inner = handle->owner->inner;
+        if (!inner->reset_code(handle->innerHandle, dataSize, codeStream, code_begin, code_end)) {
+            return hpatch_FALSE;
+        }
+        handle->remaining = dataSize;
+        try {
+            handle->start();
+        } catch (...) {
+            return hpatch_FALSE;
+        }
+        return hpatch_TRUE;
+    }
+
+    hpatch_BOOL locked_read(const hpatch_TStreamInput* stream, hpatch_StreamPos_t readFromPos,
+                            unsigned char* out_data, unsigned char* out_data_end) {
+        LockedStreamInput* self = (LockedStreamInput*)stream->streamImport;
+        std::lock_guard<std::mutex> lock(self->mutex);
+        return self->inner->read(self->inner, readFromPos, out_data, out_data_end);
+    }
+}
+
+PipelinedDecompress::PipelinedDecompress(hpatch_TDecompress* inner_,
+                                         size_t chunkSize_, size_t depth_)
+    : base(), inner(inner_), chunkSize(chunkSize_), depth(depth_ ? depth_ : 1) {
+    base.is_can_open = inner->is_can_open;
+    base.open = pipeline_open;
+    base.close = pipeline_close;
+    base.decompress_part = pipeline_decompress_part;
+    base.reset_code = inner->reset_code ? pipeline_reset_code : nullptr;
+}
+
+LockedStreamInput::LockedStreamInput(const hpatch_TStreamInput* inner_)
+    : base(), inner(inner_) {
+    base.streamImport = this;
+    base.streamSize = inner->streamSize;
+    base.read = locked_read;
+}
@@ -0,0 +1,43 @@
+/**
+ * pipelined_decompress - 解压插件的预解压包装
+ * 每个压缩子流(HDIFF13 的 cover、RLE ctrl/code、new data)open 时各起一个
+ * 线程,用内部插件提前解压到有界的块队列;patch 线程的 decompress_part
+ * 只从队列拷贝。输出字节与串行路径完全相同。
+ * 多个解压线程与 patch 线程同时读 diff 流,diff 流须经 LockedStreamInput
+ * 串行化(file_for_patch 的读带 seek 状态,不是线程安全的)。
+ */
+
+#ifndef HDIFFPATCH_PIPELINED_DECOMPRESS_H
+#define HDIFFPATCH_PIPELINED_DECOMPRESS_H
+#include <stddef.h>
+#include <mutex>
+#include "../HDiffPatch/libHDiffPatch/HPatch/patch_types.h"
+
+const size_t kPipelineChunkSize = 256 * 1024;
+const size_t kPipelineDepth = 8;  // 每个子流最多提前解压的块数
+
+struct PipelinedDecompress {
+    hpatch_TDecompress base;          // 传给 patch_decompress 的插件
+    hpatch_TDecompress* inner;
+    size_t chunkSize;
+    size_t depth;
+
+    explicit PipelinedDecompress(hpatch_TDecompress* inner,
+                                 size_t chunkSize = kPipelineChunkSize,
+                                 size_t depth = kPipelineDepth);
+    PipelinedDecompress(const PipelinedDecompress&) = delete;
+    PipelinedDecompress& operator=(const PipelinedDecompress&) = delete;
+};
+
+// 对 read 加锁的输入流包装,inner 须比本对象活得久
+struct LockedStreamInput {
+    hpatch_TStreamInput base;
+    const hpatch_TStreamInput* inner;
+    std::mutex mutex;
+
+    explicit LockedStreamInput(const hpatch_TStreamInput* inner);
+    LockedStreamInput(const LockedStreamInput&) = delete;
+    LockedStreamInput& operator=(const LockedStreamInput&) = delete;
+};
+
+#endif
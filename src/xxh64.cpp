@@ -0,0 +1,132 @@
+#include "xxh64.h"
+#include <cstring>
+
+namespace {
+    const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t rotl64(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    // 支持的平台(x64/arm64)均为小端,memcpy 由编译器折叠为单条 load
+    inline uint64_t read64(const uint8_t* p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t round64(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        acc = rotl64(acc, 31);
+        return acc * kPrime1;
+    }
+
+    inline uint64_t mergeRound(uint64_t acc, uint64_t val) {
+        acc ^= round64(0, val);
+        return acc * kPrime1 + kPrime4;
+    }
+
+    inline void consumeStripes(uint64_t v[4], const uint8_t*& p, const uint8_t* limit) {
+        uint64_t v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3];
+        while (p + 32 <= limit) {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        }
+        v[0] = v1; v[1] = v2; v[2] = v3; v[3] = v4;
+    }
+}
+
+void xxh64_init(Xxh64State* state, uint64_t seed) {
+    std::memset(state, 0, sizeof(*state));
+    state->seed = seed;
+    state->v[0] = seed + kPrime1 + kPrime2;
+    state->v[1] = seed + kPrime2;
+    state->v[2] = seed;
+    state->v[3] = seed - kPrime1;
+}
+
+void xxh64_update(Xxh64State* state, const uint8_t* data, size_t size) {
+    if (size == 0) return;
+    state->totalLen += size;
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+
+    if (state->memSize + size < 32) {
+        std::memcpy(state->mem + state->memSize, p, size);
+        state->memSize += size;
+        return;
+    }
+    if (state->memSize > 0) {
+        const size_t fill = 32 - state->memSize;
+        std::memcpy(state->mem + state->memSize, p, fill);
+        const uint8_t* memPos = state->mem;
+        consumeStripes(state->v, memPos, state->mem + 32);
+        p += fill;
+        state->memSize = 0;
+    }
+    consumeStripes(state->v, p, end);
+    if (p < end) {
+        std::memcpy(state->mem, p, (size_t)(end - p));
+        state->memSize = (size_t)(end - p);
+    }
+}
+
+uint64_t xxh64_digest(const Xxh64State* state) {
+    uint64_t h;
+    if (state->totalLen >= 32) {
+        const uint64_t* v = state->v;
+        h = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18);
+        h = mergeRound(h, v[0]);
+        h = mergeRound(h, v[1]);
+        h = mergeRound(h, v[2]);
+        h = mergeRound(h, v[3]);
+    } else {
+        h = state->seed + kPrime5;
+    }
+    h += state->totalLen;
+
+    const uint8_t* p = state->mem;
+    const uint8_t* end = state->mem + state->memSize;
+    while (p + 8 <= end) {
+        h ^= round64(0, read64(p));
+        h = rotl64(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * kPrime1;
+        h = rotl64(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * kPrime5;
+        h = rotl64(h, 11) * kPrime1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t xxh64(const uint8_t* data, size_t size, uint64_t seed) {
+    Xxh64State state;
+    xxh64_init(&state, seed);
+    xxh64_update(&state, data, size);
+    return xxh64_digest(&state);
+}
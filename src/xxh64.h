@@ -0,0 +1,24 @@
+/**
+ * xxh64 - 64 位 XXH64 摘要(与 xxHash 参考实现的输出一致)
+ * 用于磁盘缓存键与缓存条目自校验,非密码学用途。
+ */
+
+#ifndef HDIFFPATCH_XXH64_H
+#define HDIFFPATCH_XXH64_H
+#include <stddef.h>
+#include <stdint.h>
+
+struct Xxh64State {
+    uint64_t totalLen;
+    uint64_t v[4];
+    uint8_t mem[32];
+    size_t memSize;
+    uint64_t seed;
+};
+
+void xxh64_init(Xxh64State* state, uint64_t seed = 0);
+void xxh64_update(Xxh64State* state, const uint8_t* data, size_t size);
+uint64_t xxh64_digest(const Xxh64State* state);
+uint64_t xxh64(const uint8_t* data, size_t size, uint64_t seed = 0);
+
+#endif
@@ -0,0 +1,117 @@
+// diff()/diffFile() 在 200 MB 以上输入上的耗时、次缺页与峰值内存,按分配方式对比:
+// 后缀数组与匹配器的工作区由 HDiffPatch 内部经 malloc 分配,只能用 glibc 的
+// GLIBC_TUNABLES=glibc.malloc.hugetlb 切换大页;diffFile() 读入的整文件输入在
+// configureArena() 启用大页时改由 arena 提供。malloc 设置只在进程启动时生效,
+// 因此每种组合都在独立子进程中运行(同时得到准确的 maxRSS)。
+const crypto = require('node:crypto');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const { spawnSync } = require('node:child_process');
+
+if (process.env.HDIFF_ARENA_DIFF_CHILD === '1') {
+  const hdiffpatch = require('..');
+  const [api, hugePages, oldPath, newPath, outPath] = process.argv.slice(2);
+  if (hugePages !== 'off') hdiffpatch.configureArena({ hugePages, retainBytes: 0 });
+  let oldData;
+  let newData;
+  if (api === 'diff') {
+    oldData = fs.readFileSync(oldPath);
+    newData = fs.readFileSync(newPath);
+  }
+  const faultsBefore = process.resourceUsage().minorPageFault;
+  const startedAt = performance.now();
+  let patchBytes;
+  if (api === 'diff') {
+    patchBytes = hdiffpatch.diff(oldData, newData).length;
+  } else {
+    hdiffpatch.diffFile(oldPath, newPath, outPath);
+    patchBytes = fs.statSync(outPath).size;
+  }
+  const durationMs = performance.now() - startedAt;
+  const usage = process.resourceUsage();
+  console.log(JSON.stringify({
+    durationMs,
+    minorFaults: usage.minorPageFault - faultsBefore,
+    maxRSSKiB: usage.maxRSS,
+    patchBytes,
+    hugeTlbFallbacks: hdiffpatch.nativeMemoryStats().arena.hugeTlbFallbacks,
+  }));
+  process.exit(0);
+}
+
+// AES-CTR 密钥流作确定性伪随机数据;new 每 4 MiB 插入一小段并改写一个字节
+function writeInputs(oldPath, newPath, size) {
+  const chunkSize = 4 * 1024 * 1024;
+  const zeros = Buffer.alloc(chunkSize);
+  const key = crypto.createHash('sha256').update('arena-diff').digest().subarray(0, 16);
+  const stream = crypto.createCipheriv('aes-128-ctr', key, Buffer.alloc(16));
+  const oldFd = fs.openSync(oldPath, 'w');
+  const newFd = fs.openSync(newPath, 'w');
+  try {
+    for (let pos = 0; pos < size; pos += chunkSize) {
+      const chunk = stream.update(zeros.subarray(0, Math.min(chunkSize, size - pos)));
+      fs.writeSync(oldFd, chunk);
+      fs.writeSync(newFd, chunk.subarray(0, 97));
+      chunk[chunk.length >> 1] ^= 0xa5;
+      fs.writeSync(newFd, chunk);
+    }
+  } finally {
+    fs.closeSync(oldFd);
+    fs.closeSync(newFd);
+  }
+}
+
+const modes = [
+  { name: 'default', tunables: '', hugePages: 'off' },
+  { name: 'malloc-thp', tunables: 'glibc.malloc.hugetlb=1', hugePages: 'off' },
+  { name: 'malloc-thp+arena-thp', tunables: 'glibc.malloc.hugetlb=1', hugePages: 'transparent' },
+  { name: 'malloc-hugetlb+arena-hugetlb', tunables: 'glibc.malloc.hugetlb=2', hugePages: 'hugetlb' },
+];
+
+function runChild(api, mode, oldPath, newPath, outPath) {
+  const env = { ...process.env, HDIFF_ARENA_DIFF_CHILD: '1' };
+  if (mode.tunables) {
+    env.GLIBC_TUNABLES = [process.env.GLIBC_TUNABLES, mode.tunables].filter(Boolean).join(':');
+  }
+  const result = spawnSync(
+    process.execPath,
+    [__filename, api, mode.hugePages, oldPath, newPath, outPath],
+    { encoding: 'utf8', env },
+  );
+  if (result.status !== 0) {
+    throw new Error(result.stderr || `benchmark child exited ${result.status}`);
+  }
+  const outputLines = result.stdout.trim().split('\n');
+  return JSON.parse(outputLines[outputLines.length - 1]);
+}
+
+const sizeMiB = Number(process.env.HDIFF_BENCHMARK_MB ?? 256);
+const rounds = Number(process.env.HDIFF_BENCHMARK_ROUNDS ?? 1);
+if (!Number.isInteger(sizeMiB) || sizeMiB < 8 || !Number.isInteger(rounds) || rounds < 1) {
+  throw new Error('HDIFF_BENCHMARK_MB must be >= 8 and rounds must be >= 1');
+}
+
+const tempRoot = fs.mkdtempSync(
+  path.join(process.env.HDIFF_BENCHMARK_DIR ?? os.tmpdir(), 'hdiff-arena-diff-'),
+);
+try {
+  const oldPath = path.join(tempRoot, 'old.bin');
+  const newPath = path.join(tempRoot, 'new.bin');
+  const outPath = path.join(tempRoot, 'out.diff');
+  writeInputs(oldPath, newPath, sizeMiB * 1024 * 1024);
+
+  const samples = [];
+  for (let round = 0; round < rounds; round++) {
+    for (const api of ['diff', 'diffFile']) {
+      for (const mode of modes) {
+        const sample = runChild(api, mode, oldPath, newPath, outPath);
+        samples.push({ api, mode: mode.name, ...sample });
+        fs.rmSync(outPath, { force: true });
+      }
+    }
+  }
+  console.log(JSON.stringify({ sizeMiB, rounds, samples }, null, 2));
+} finally {
+  fs.rmSync(tempRoot, { recursive: true, force: true });
+}
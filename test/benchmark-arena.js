@@ -0,0 +1,72 @@
+// patch() 大输出的分配开销:buffer arena 关闭 / 透明大页 / 大页且跨任务保留。
+// 每轮记录耗时与次缺页数(process.resourceUsage().minorPageFault);
+// 需要 --expose-gc,以便每轮结束时回收结果 Buffer 并把块交还 arena。
+const hdiffpatch = require('..');
+
+function deterministicBytes(size, seed) {
+  const out = Buffer.allocUnsafe(size);
+  let x = seed >>> 0;
+  for (let i = 0; i < size; i++) {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    out[i] = x & 0xff;
+  }
+  return out;
+}
+
+if (typeof global.gc !== 'function') {
+  throw new Error('run with node --expose-gc (npm run benchmark:arena)');
+}
+const sizeMiB = Number(process.env.HDIFF_BENCHMARK_MB ?? 256);
+const rounds = Number(process.env.HDIFF_BENCHMARK_ROUNDS ?? 5);
+if (!Number.isInteger(sizeMiB) || sizeMiB < 2 ||
+    !Number.isInteger(rounds) || rounds < 1) {
+  throw new Error('HDIFF_BENCHMARK_MB must be >= 2 and rounds must be >= 1');
+}
+
+const size = sizeMiB * 1024 * 1024;
+const oldData = deterministicBytes(size, 0x13572468);
+const newData = Buffer.from(oldData);
+for (let pos = 4096; pos < size; pos += 64 * 1024) newData[pos] ^= 0x5a;
+const diffData = hdiffpatch.diff(oldData, newData);
+
+const modes = [
+  { name: 'off', options: { enabled: false, retainBytes: 0 } },
+  { name: 'transparent', options: { hugePages: 'transparent', retainBytes: 0 } },
+  { name: 'transparent+retain', options: { hugePages: 'transparent', retainBytes: 2 * size } },
+  { name: 'hugetlb+retain', options: { hugePages: 'hugetlb', retainBytes: 2 * size } },
+];
+
+const summary = [];
+for (const mode of modes) {
+  hdiffpatch.configureArena(mode.options);
+  const before = hdiffpatch.nativeMemoryStats().arena;
+  const times = [];
+  const faults = [];
+  for (let round = 0; round < rounds; round++) {
+    const faultsBefore = process.resourceUsage().minorPageFault;
+    const startedAt = process.hrtime.bigint();
+    let out = hdiffpatch.patch(oldData, diffData);
+    times.push(Number(process.hrtime.bigint() - startedAt) / 1e9);
+    faults.push(process.resourceUsage().minorPageFault - faultsBefore);
+    if (round === 0 && !out.equals(newData)) throw new Error(`${mode.name}: patch() output mismatch`);
+    out = null;
+    global.gc();
+  }
+  const after = hdiffpatch.nativeMemoryStats().arena;
+  times.sort((a, b) => a - b);
+  faults.sort((a, b) => a - b);
+  const median = times[times.length >> 1];
+  summary.push({
+    mode: mode.name,
+    medianMs: median * 1000,
+    gbPerSec: size / median / 1e9,
+    medianMinorFaults: faults[faults.length >> 1],
+    arenaReused: after.reused - before.reused,
+    hugeTlbFallbacks: after.hugeTlbFallbacks - before.hugeTlbFallbacks,
+  });
+}
+hdiffpatch.configureArena({ enabled: false, retainBytes: 0 });
+
+console.log(JSON.stringify({ sizeMiB, rounds, diffBytes: diffData.length, summary }, null, 2));
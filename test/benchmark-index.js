@@ -0,0 +1,96 @@
+// diff() 在不同 maxIndexMemory 预算下的耗时、峰值内存与 patch 尺寸,
+// 以 diffWindow() 默认窗口作对照。每个用例在独立子进程中运行以取得准确的 maxRSS。
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const { spawnSync } = require('node:child_process');
+
+const hdiffpatch = require('..');
+
+if (process.env.HDIFF_INDEX_CHILD === '1') {
+  const [oldPath, newPath, outPath, rawBudget] = process.argv.slice(2);
+  const startedAt = performance.now();
+  let patchBytes;
+  if (rawBudget === 'window') {
+    hdiffpatch.diffWindow(oldPath, newPath, outPath);
+    patchBytes = fs.statSync(outPath).size;
+  } else {
+    const options = rawBudget === '0' ? {} : { maxIndexMemory: Number(rawBudget) };
+    patchBytes = hdiffpatch.diff(
+      fs.readFileSync(oldPath),
+      fs.readFileSync(newPath),
+      options,
+    ).length;
+  }
+  console.log(JSON.stringify({
+    budget: rawBudget,
+    durationMs: performance.now() - startedAt,
+    maxRSSKiB: process.resourceUsage().maxRSS,
+    patchBytes,
+  }));
+  process.exit(0);
+}
+
+function deterministicBytes(size, seed) {
+  const out = Buffer.allocUnsafe(size);
+  let x = seed >>> 0;
+  for (let i = 0; i < size; i++) {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    out[i] = x & 0xff;
+  }
+  return out;
+}
+
+function runChild(oldPath, newPath, outPath, budget) {
+  const result = spawnSync(
+    process.execPath,
+    [__filename, oldPath, newPath, outPath, String(budget)],
+    {
+      encoding: 'utf8',
+      env: { ...process.env, HDIFF_INDEX_CHILD: '1' },
+    },
+  );
+  if (result.status !== 0) {
+    throw new Error(result.stderr || `benchmark child exited ${result.status}`);
+  }
+  const outputLines = result.stdout.trim().split('\n');
+  return JSON.parse(outputLines[outputLines.length - 1]);
+}
+
+const sizeMiB = Number(process.env.HDIFF_BENCHMARK_MB ?? 128);
+if (!Number.isInteger(sizeMiB) || sizeMiB < 32) {
+  throw new Error('HDIFF_BENCHMARK_MB must be an integer >= 32');
+}
+
+const tempRoot = fs.mkdtempSync(path.join(os.tmpdir(), 'hdiff-index-'));
+try {
+  // 把 old 切块后打乱并穿插改动:长距离移动能体现窗口大小对 patch 尺寸的影响
+  const size = sizeMiB * 1024 * 1024;
+  const oldData = deterministicBytes(size, 0x0badf00d);
+  const blockSize = 1024 * 1024;
+  const blocks = [];
+  for (let pos = 0; pos < size; pos += blockSize) {
+    const block = Buffer.from(oldData.subarray(pos, pos + blockSize));
+    block[block.length >> 1] ^= 0xff;
+    blocks.push(block);
+  }
+  for (let i = blocks.length - 1; i > 0; i -= 3) {
+    const j = (i * 7919) % (i + 1);
+    [blocks[i], blocks[j]] = [blocks[j], blocks[i]];
+  }
+  const oldPath = path.join(tempRoot, 'old.bin');
+  const newPath = path.join(tempRoot, 'new.bin');
+  fs.writeFileSync(oldPath, oldData);
+  fs.writeFileSync(newPath, Buffer.concat(blocks));
+
+  const fullIndex = size * 4;
+  const budgets = [0, fullIndex / 2, fullIndex / 4, fullIndex / 8, fullIndex / 16, 'window'];
+  const samples = budgets.map((budget) =>
+    runChild(oldPath, newPath, path.join(tempRoot, 'out.diff'), budget),
+  );
+  console.log(JSON.stringify({ sizeMiB, samples }, null, 2));
+} finally {
+  fs.rmSync(tempRoot, { recursive: true, force: true });
+}
@@ -0,0 +1,97 @@
+// patch()/patchSingleStream() 吞吐量(GB/s,按 new 字节计)。
+// HDIFF_BASELINE 指向另一份构建(例如旧版本的包目录)时两者交替测量,便于前后对比。
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+
+function deterministicBytes(size, seed) {
+  const out = Buffer.allocUnsafe(size);
+  let x = seed >>> 0;
+  for (let i = 0; i < size; i++) {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    out[i] = x & 0xff;
+  }
+  return out;
+}
+
+const sizeMiB = Number(process.env.HDIFF_BENCHMARK_MB ?? 64);
+const rounds = Number(process.env.HDIFF_BENCHMARK_ROUNDS ?? 5);
+if (!Number.isInteger(sizeMiB) || sizeMiB < 1 ||
+    !Number.isInteger(rounds) || rounds < 1) {
+  throw new Error('HDIFF_BENCHMARK_MB must be >= 1 and rounds must be >= 1');
+}
+
+const builds = [{ name: 'current', module: require('..') }];
+if (process.env.HDIFF_BASELINE) {
+  builds.push({
+    name: 'baseline',
+    module: require(path.resolve(process.env.HDIFF_BASELINE)),
+  });
+}
+
+const tempRoot = fs.mkdtempSync(path.join(os.tmpdir(), 'hdiff-patch-bench-'));
+try {
+  // 大部分相同、分散少量改动:patch 时间以 old 拷贝与差值相加为主
+  const size = sizeMiB * 1024 * 1024;
+  const oldData = deterministicBytes(size, 0x2468ace0);
+  const newData = Buffer.from(oldData);
+  for (let pos = 4096; pos < size; pos += 64 * 1024) {
+    newData[pos] ^= 0x5a;
+    newData[pos + 7] = (newData[pos + 7] + 3) & 0xff;
+  }
+  const oldPath = path.join(tempRoot, 'old.bin');
+  const diffPath = path.join(tempRoot, 'single.diff');
+  const outPath = path.join(tempRoot, 'out.bin');
+  const diffData = builds[0].module.diff(oldData, newData);
+  fs.writeFileSync(oldPath, oldData);
+  fs.writeFileSync(diffPath, diffData);
+
+  const cases = {
+    patch: (mod) => mod.patch(oldData, diffData),
+    patchSingleStream: (mod) => mod.patchSingleStream(oldPath, diffPath, outPath),
+  };
+  const samples = [];
+  for (const build of builds) {
+    if (!build.module.patch(oldData, diffData).equals(newData)) {
+      throw new Error(`${build.name}: patch() output mismatch`);
+    }
+  }
+  for (let round = 0; round < rounds; round++) {
+    const order = round % 2 === 0 ? builds : [...builds].reverse();
+    for (const build of order) {
+      for (const [name, run] of Object.entries(cases)) {
+        const startedAt = process.hrtime.bigint();
+        run(build.module);
+        const seconds = Number(process.hrtime.bigint() - startedAt) / 1e9;
+        samples.push({ build: build.name, case: name, seconds });
+      }
+    }
+  }
+
+  const summary = [];
+  for (const build of builds) {
+    for (const name of Object.keys(cases)) {
+      const times = samples
+        .filter((s) => s.build === build.name && s.case === name)
+        .map((s) => s.seconds)
+        .sort((a, b) => a - b);
+      const median = times[times.length >> 1];
+      summary.push({
+        build: build.name,
+        case: name,
+        medianMs: median * 1000,
+        gbPerSec: newData.length / median / 1e9,
+      });
+    }
+  }
+  console.log(JSON.stringify({
+    sizeMiB,
+    rounds,
+    diffBytes: diffData.length,
+    summary,
+  }, null, 2));
+} finally {
+  fs.rmSync(tempRoot, { recursive: true, force: true });
+}
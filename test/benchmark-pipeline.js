@@ -0,0 +1,96 @@
+// patchStream() 串行与 pipelined(子流预解压)两种模式的耗时对比(按 new 字节计)。
+// new 中约一半是 old 里没有的可压缩数据,使 new data 子流的 lzma 解压与 cover 拷贝
+// 的耗时相当;两种模式交替测量,输出各自的中位数与加速比。
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+
+const hdiffpatch = require('..');
+
+function deterministicBytes(size, seed) {
+  const out = Buffer.allocUnsafe(size);
+  let x = seed >>> 0;
+  for (let i = 0; i < size; i++) {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    out[i] = x & 0xff;
+  }
+  return out;
+}
+
+// 小字母表的文本状数据:lzma 能压缩,但解压仍有可观的 CPU 开销
+function textLikeBytes(size, seed) {
+  const out = deterministicBytes(size, seed);
+  for (let i = 0; i < size; i++) out[i] = 0x61 + (out[i] % 12);
+  return out;
+}
+
+const sizeMiB = Number(process.env.HDIFF_BENCHMARK_MB ?? 64);
+const rounds = Number(process.env.HDIFF_BENCHMARK_ROUNDS ?? 5);
+if (!Number.isInteger(sizeMiB) || sizeMiB < 1 ||
+    !Number.isInteger(rounds) || rounds < 1) {
+  throw new Error('HDIFF_BENCHMARK_MB must be >= 1 and rounds must be >= 1');
+}
+
+const tempRoot = fs.mkdtempSync(path.join(os.tmpdir(), 'hdiff-pipeline-bench-'));
+try {
+  const size = sizeMiB * 1024 * 1024;
+  const block = 256 * 1024;
+  const oldData = deterministicBytes(size, 0x13579bdf);
+  const fresh = textLikeBytes(size, 0x0badf00d);
+  const newData = Buffer.allocUnsafe(size);
+  // 按块交替:偶数块来自 old(cover),奇数块为新内容(new data 子流)
+  for (let pos = 0; pos < size; pos += block) {
+    const src = (pos / block) % 2 === 0 ? oldData : fresh;
+    src.copy(newData, pos, pos, Math.min(pos + block, size));
+  }
+  const oldPath = path.join(tempRoot, 'old.bin');
+  const newPath = path.join(tempRoot, 'new.bin');
+  const diffPath = path.join(tempRoot, 'stream.diff');
+  const outPath = path.join(tempRoot, 'out.bin');
+  fs.writeFileSync(oldPath, oldData);
+  fs.writeFileSync(newPath, newData);
+  hdiffpatch.diffStream(oldPath, newPath, diffPath);
+
+  const cases = {
+    serial: () => hdiffpatch.patchStream(oldPath, diffPath, outPath),
+    pipelined: () => hdiffpatch.patchStream(oldPath, diffPath, outPath, { pipelined: true }),
+  };
+  for (const [name, run] of Object.entries(cases)) {
+    run();
+    if (!fs.readFileSync(outPath).equals(newData)) {
+      throw new Error(`${name}: patchStream output mismatch`);
+    }
+  }
+
+  const samples = [];
+  for (let round = 0; round < rounds; round++) {
+    const order = round % 2 === 0 ? Object.keys(cases) : Object.keys(cases).reverse();
+    for (const name of order) {
+      const startedAt = process.hrtime.bigint();
+      cases[name]();
+      const seconds = Number(process.hrtime.bigint() - startedAt) / 1e9;
+      samples.push({ case: name, seconds });
+    }
+  }
+
+  const summary = {};
+  for (const name of Object.keys(cases)) {
+    const times = samples
+      .filter((s) => s.case === name)
+      .map((s) => s.seconds)
+      .sort((a, b) => a - b);
+    const median = times[times.length >> 1];
+    summary[name] = { medianMs: median * 1000, mbPerSec: size / median / 1e6 };
+  }
+  console.log(JSON.stringify({
+    sizeMiB,
+    rounds,
+    diffBytes: fs.statSync(diffPath).size,
+    summary,
+    speedup: summary.serial.medianMs / summary.pipelined.medianMs,
+  }, null, 2));
+} finally {
+  fs.rmSync(tempRoot, { recursive: true, force: true });
+}
@@ -0,0 +1,113 @@
+// diffStream()/diffSingleStream() 在 1–10 GB 输入上的耗时、吞吐与峰值内存。
+// 两者都走 HDiffPatch 的块摘要匹配(digest_matcher + adler 滚动哈希,均为
+// 子模块中的标量实现),用作向量化版本的基线,以及升级子模块或调整匹配参数前后对比。每种模式在独立子进程中运行以取得准确的 maxRSS。
+const crypto = require('node:crypto');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const { spawnSync } = require('node:child_process');
+
+const hdiffpatch = require('..');
+
+const modes = {
+  diffStream: (oldPath, newPath, outPath) =>
+    hdiffpatch.diffStream(oldPath, newPath, outPath),
+  diffSingleStream: (oldPath, newPath, outPath) =>
+    hdiffpatch.diffSingleStream(oldPath, newPath, outPath),
+};
+
+if (process.env.HDIFF_STREAM_CHILD === '1') {
+  const [mode, oldPath, newPath, outPath] = process.argv.slice(2);
+  const cpuStartedAt = process.cpuUsage();
+  const startedAt = performance.now();
+  modes[mode](oldPath, newPath, outPath);
+  const durationMs = performance.now() - startedAt;
+  const cpuUsage = process.cpuUsage(cpuStartedAt);
+  console.log(JSON.stringify({
+    mode,
+    durationMs,
+    cpuTotalMs: (cpuUsage.user + cpuUsage.system) / 1000,
+    maxRSSKiB: process.resourceUsage().maxRSS,
+    patchBytes: fs.statSync(outPath).size,
+  }));
+  process.exit(0);
+}
+
+// AES-CTR 密钥流作确定性伪随机数据,生成 GB 级文件时不成为瓶颈
+function keystream(seed) {
+  const key = crypto.createHash('sha256').update(String(seed)).digest().subarray(0, 16);
+  return crypto.createCipheriv('aes-128-ctr', key, Buffer.alloc(16));
+}
+
+// old 为伪随机数据;new 每 64 MiB 插入一小段、改写若干字节,迫使匹配器频繁重新同步
+function writeInputs(oldPath, newPath, size) {
+  const chunkSize = 4 * 1024 * 1024;
+  const zeros = Buffer.alloc(chunkSize);
+  const oldStream = keystream(0x5eed);
+  const insertStream = keystream(0xface);
+  const oldFd = fs.openSync(oldPath, 'w');
+  const newFd = fs.openSync(newPath, 'w');
+  try {
+    for (let pos = 0; pos < size; pos += chunkSize) {
+      const len = Math.min(chunkSize, size - pos);
+      const chunk = oldStream.update(zeros.subarray(0, len));
+      fs.writeSync(oldFd, chunk);
+      if (pos % (64 * 1024 * 1024) === 0) {
+        fs.writeSync(newFd, insertStream.update(zeros.subarray(0, 333)));
+        chunk[len >> 1] ^= 0xa5;
+        chunk[len - 1] ^= 0x3c;
+      }
+      fs.writeSync(newFd, chunk);
+    }
+  } finally {
+    fs.closeSync(oldFd);
+    fs.closeSync(newFd);
+  }
+}
+
+function runChild(mode, oldPath, newPath, outPath) {
+  const result = spawnSync(
+    process.execPath,
+    [__filename, mode, oldPath, newPath, outPath],
+    {
+      encoding: 'utf8',
+      env: { ...process.env, HDIFF_STREAM_CHILD: '1' },
+    },
+  );
+  if (result.status !== 0) {
+    throw new Error(result.stderr || `benchmark child exited ${result.status}`);
+  }
+  const outputLines = result.stdout.trim().split('\n');
+  return JSON.parse(outputLines[outputLines.length - 1]);
+}
+
+const sizeGiB = Number(process.env.HDIFF_BENCHMARK_GB ?? 1);
+const rounds = Number(process.env.HDIFF_BENCHMARK_ROUNDS ?? 1);
+if (!(sizeGiB >= 1 && sizeGiB <= 10) || !Number.isInteger(rounds) || rounds < 1) {
+  throw new Error('HDIFF_BENCHMARK_GB must be within 1..10 and rounds must be >= 1');
+}
+
+const tempRoot = fs.mkdtempSync(
+  path.join(process.env.HDIFF_BENCHMARK_DIR ?? os.tmpdir(), 'hdiff-stream-'),
+);
+try {
+  const size = Math.floor(sizeGiB * 1024 * 1024 * 1024);
+  const oldPath = path.join(tempRoot, 'old.bin');
+  const newPath = path.join(tempRoot, 'new.bin');
+  writeInputs(oldPath, newPath, size);
+  const newSize = fs.statSync(newPath).size;
+
+  const samples = [];
+  for (let round = 0; round < rounds; round++) {
+    for (const mode of Object.keys(modes)) {
+      const outPath = path.join(tempRoot, `${mode}.diff`);
+      const sample = runChild(mode, oldPath, newPath, outPath);
+      sample.mbPerSec = newSize / 1e6 / (sample.durationMs / 1000);
+      samples.push(sample);
+      fs.rmSync(outPath, { force: true });
+    }
+  }
+  console.log(JSON.stringify({ sizeGiB, rounds, newSize, samples }, null, 2));
+} finally {
+  fs.rmSync(tempRoot, { recursive: true, force: true });
+}
@@ -199,6 +199,104 @@ hdiffpatch.diffWindow(ssOldPath, ssNewPath, winDiffMtPath, {
 assert.deepStrictEqual(hdiffpatch.patch(oldData, fs.readFileSync(winDiffMtPath)), newData);
 console.log("  ✓ diffWindow with explicit windowSize works, invalid size throws");
 
+console.log("\nTest 5d: content-addressed diff cache...");
+var cacheDir = path.join(ssDir, "cache");
+var cachedDiff = hdiffpatch.diff(oldData, newData, { cache: { dir: cacheDir } });
+assert.deepStrictEqual(cachedDiff, diffResult);
+var cacheEntries = fs.readdirSync(cacheDir).filter((name) => name.endsWith(".hdpc"));
+assert.strictEqual(cacheEntries.length, 1);
+assert.deepStrictEqual(hdiffpatch.diff(oldData, newData, { cache: { dir: cacheDir } }), diffResult);
+// 损坏的条目按未命中处理并被重新生成的结果覆盖
+var cacheEntryPath = path.join(cacheDir, cacheEntries[0]);
+var corruptEntry = fs.readFileSync(cacheEntryPath);
+corruptEntry[corruptEntry.length - 1] ^= 0xff;
+fs.writeFileSync(cacheEntryPath, corruptEntry);
+assert.deepStrictEqual(hdiffpatch.diff(oldData, newData, { cache: { dir: cacheDir } }), diffResult);
+var cachedWinPath = path.join(ssDir, "cached-win.diff");
+hdiffpatch.diffWindow(ssOldPath, ssNewPath, cachedWinPath, { cache: { dir: cacheDir } });
+fs.rmSync(cachedWinPath);
+hdiffpatch.diffWindow(ssOldPath, ssNewPath, cachedWinPath, { cache: { dir: cacheDir } });
+assert.deepStrictEqual(fs.readFileSync(cachedWinPath), winDiffData);
+assert.strictEqual(fs.readdirSync(cacheDir).filter((name) => name.endsWith(".hdpc")).length, 2);
+// 文件版:损坏条目先拷到临时文件,校验失败不改名,输出由重新生成的结果写入
+var winEntryPath = path.join(cacheDir,
+  fs.readdirSync(cacheDir).find((name) => name.endsWith(".hdpc") && !cacheEntries.includes(name)));
+var corruptWinEntry = fs.readFileSync(winEntryPath);
+corruptWinEntry[corruptWinEntry.length - 1] ^= 0xff;
+fs.writeFileSync(winEntryPath, corruptWinEntry);
+hdiffpatch.diffWindow(ssOldPath, ssNewPath, cachedWinPath, { cache: { dir: cacheDir } });
+assert.deepStrictEqual(fs.readFileSync(cachedWinPath), winDiffData);
+assert.deepStrictEqual(fs.readdirSync(ssDir).filter((name) => name.endsWith(".tmp")), []);
+hdiffpatch.diff(tinyOld, tinyNew, { cache: { dir: cacheDir, maxBytes: 1 } });
+assert(fs.readdirSync(cacheDir).filter((name) => name.endsWith(".hdpc")).length <= 1);
+assert.throws(() => hdiffpatch.diff(oldData, newData, { cache: { dir: "" } }));
+assert.throws(() => hdiffpatch.diff(oldData, newData, { cache: { dir: cacheDir, maxBytes: -1 } }));
+console.log("  ✓ cache hits return identical patches; corrupt entries and size limits are handled");
+
+console.log("\nTest 5e: trimIdentical switches near-identical inputs to the window engine...");
+var trimOld = deterministicBytes(9 * 1024 * 1024, 0x13579bdf);
+var trimNew = Buffer.concat([
+  trimOld.subarray(0, 3 * 1024 * 1024),
+  Buffer.from("_inserted_"),
+  trimOld.subarray(3 * 1024 * 1024)
+]);
+trimNew[6 * 1024 * 1024] ^= 0x55;
+var trimDiff = hdiffpatch.diff(trimOld, trimNew, { trimIdentical: true });
+assertHeaderPrefix(trimDiff, "HDIFFSF20");
+assert.deepStrictEqual(hdiffpatch.patch(trimOld, trimDiff), trimNew);
+// 只有同偏移原地修改时同样可以应用
+var trimInPlace = Buffer.from(trimOld);
+for (var trimPos = 4096; trimPos < trimInPlace.length; trimPos += 1024 * 1024) trimInPlace[trimPos] ^= 0xa5;
+var trimInPlaceDiff = hdiffpatch.diff(trimOld, trimInPlace, { trimIdentical: true });
+assert.deepStrictEqual(hdiffpatch.patch(trimOld, trimInPlaceDiff), trimInPlace);
+// 低于阈值时与默认路径逐字节一致
+assert.deepStrictEqual(hdiffpatch.diff(oldData, newData, { trimIdentical: true }), diffResult);
+assert.throws(() => hdiffpatch.diff(oldData, newData, { trimIdentical: "yes" }));
+assert.throws(() => hdiffpatch.diffWindow(ssOldPath, ssNewPath, winDiffMtPath, { trimIdentical: true }));
+console.log("  ✓ trimIdentical diffs round-trip and small inputs keep the default output");
+
+console.log("\nTest 5f: maxIndexMemory bounds the suffix index...");
+// 预算足够:与默认路径逐字节一致
+assert.deepStrictEqual(
+  hdiffpatch.diff(oldData, newData, { maxIndexMemory: oldData.length * 8 }),
+  diffResult
+);
+var compactOld = deterministicBytes(6 * 1024 * 1024, 0x7531);
+var compactNew = Buffer.concat([compactOld.subarray(4 * 1024 * 1024), compactOld.subarray(0, 4 * 1024 * 1024)]);
+// 6 MiB 的 old 需要 24 MiB 索引;8 MiB 预算正好是 2 MiB 默认窗口的索引
+var compactDiff = hdiffpatch.diff(compactOld, compactNew, { maxIndexMemory: 8 * 1024 * 1024 });
+assertHeaderPrefix(compactDiff, "HDIFFSF20");
+assert.deepStrictEqual(hdiffpatch.patch(compactOld, compactDiff), compactNew);
+// 低于最小窗口索引的预算无法守住,直接拒绝而不是悄悄超出
+assert.throws(() => hdiffpatch.diff(compactOld, compactNew, { maxIndexMemory: 1 }),
+  /at least 8388608 bytes/);
+assert.throws(() => hdiffpatch.diff(compactOld, compactNew, { maxIndexMemory: 8 * 1024 * 1024 - 1 }));
+assert.throws(() => hdiffpatch.diff(oldData, newData, { maxIndexMemory: -1 }));
+assert.throws(() => hdiffpatch.diffStream(ssOldPath, ssNewPath, winDiffMtPath, { maxIndexMemory: 1 }));
+console.log("  ✓ maxIndexMemory keeps default output when it fits, round-trips when bounded and rejects budgets below one window");
+
+console.log("\nTest 5g: getDiffInfo reads headers without patching...");
+var singleInfo = hdiffpatch.getDiffInfo(diffResult);
+assert.strictEqual(singleInfo.format, "HDIFFSF20");
+assert.strictEqual(singleInfo.oldDataSize, oldData.length);
+assert.strictEqual(singleInfo.newDataSize, newData.length);
+assert(singleInfo.stepMemSize > 0);
+assert.strictEqual(singleInfo.checksum, false);
+assert.strictEqual(singleInfo.memoryExact, true);
+assert(singleInfo.patchMemory >= singleInfo.streamPatchMemory + newData.length);
+var checkedTinyDiff = hdiffpatch.diff(tinyOld, tinyNew, { checksum: true });
+assert.strictEqual(hdiffpatch.getDiffInfo(checkedTinyDiff).checksum, true);
+var streamInfoPath = path.join(ssDir, "info-stream.diff");
+hdiffpatch.diffStream(ssOldPath, ssNewPath, streamInfoPath);
+var streamInfo = hdiffpatch.getDiffInfo(streamInfoPath);
+assert.strictEqual(streamInfo.format, "HDIFF13");
+assert.strictEqual(streamInfo.newDataSize, newData.length);
+assert.strictEqual(streamInfo.patchMemory, null);
+assert.deepStrictEqual(hdiffpatch.getDiffInfo(winDiffMtPath).format, "HDIFFSF20");
+assert.throws(() => hdiffpatch.getDiffInfo(Buffer.from("not a diff")));
+assert.throws(() => hdiffpatch.getDiffInfo(path.join(ssDir, "no-such.diff")));
+console.log("  ✓ getDiffInfo reports format, sizes and memory for buffers and files");
+
 console.log("\nTest 6: Single-compressed patchSingleStream (file paths)...");
 var tempDir = fs.mkdtempSync(path.join(os.tmpdir(), "hdiffpatch-"));
 var oldPath = path.join(tempDir, "old.bin");
@@ -232,6 +330,468 @@ var outNewData = fs.readFileSync(outNewPath);
 assert.deepStrictEqual(outNewData, newData);
 console.log("  ✓ Stream diff/patch works");
 
+console.log("\nTest 7a: patchChain applies several hops without intermediate files...");
+var v3Data = Buffer.concat([newData.subarray(0, 1000), Buffer.from("_v3_"), newData.subarray(1000)]);
+var v3Path = path.join(tempDir, "v3.bin");
+var v2v3DiffPath = path.join(tempDir, "v2-v3.diff");
+var chainOutPath = path.join(tempDir, "chain-out.bin");
+fs.writeFileSync(v3Path, v3Data);
+hdiffpatch.diffSingleStream(newPath, v3Path, v2v3DiffPath);
+// 首跳是 stream 格式,第二跳是 single 格式
+assert.strictEqual(
+  hdiffpatch.patchChain(oldPath, [diffPath, v2v3DiffPath], chainOutPath),
+  chainOutPath
+);
+assert.deepStrictEqual(fs.readFileSync(chainOutPath), v3Data);
+hdiffpatch.patchChain(oldPath, [singleDiffPath, v2v3DiffPath], chainOutPath, { maxMemory: 0 });
+assert.deepStrictEqual(fs.readFileSync(chainOutPath), v3Data);
+assert.deepStrictEqual(
+  fs.readdirSync(tempDir).filter((name) => name.endsWith(".tmp")),
+  []
+);
+assert.throws(() => hdiffpatch.patchChain(oldPath, [v2v3DiffPath, diffPath], chainOutPath));
+assert.throws(() => hdiffpatch.patchChain(oldPath, [], chainOutPath));
+console.log("  ✓ patchChain handles in-memory and spilled intermediates, rejects broken chains");
+
+console.log("\nTest 7b: optional old/new checksum trailer...");
+var checkedDiff = hdiffpatch.diff(oldData, newData, { checksum: true });
+assert.strictEqual(checkedDiff.length, diffResult.length + 24);
+assert.deepStrictEqual(checkedDiff.subarray(0, diffResult.length), diffResult);
+assert.strictEqual(checkedDiff.subarray(checkedDiff.length - 8).toString("latin1"), "HDPXXH64");
+assert.deepStrictEqual(hdiffpatch.patch(oldData, checkedDiff), newData);
+var wrongOld = Buffer.from(oldData);
+wrongOld[wrongOld.length >> 1] ^= 0xff;
+assert.throws(() => hdiffpatch.patch(wrongOld, checkedDiff), /Old data checksum mismatch/);
+var wrongOldPath = path.join(tempDir, "wrong-old.bin");
+var checkedSinglePath = path.join(tempDir, "checked-single.diff");
+var checkedStreamPath = path.join(tempDir, "checked-stream.diff");
+var checkedOutPath = path.join(tempDir, "checked-out.bin");
+fs.writeFileSync(wrongOldPath, wrongOld);
+hdiffpatch.diffSingleStream(oldPath, newPath, checkedSinglePath, { checksum: true });
+hdiffpatch.diffStream(oldPath, newPath, checkedStreamPath, { checksum: true });
+hdiffpatch.patchSingleStream(oldPath, checkedSinglePath, checkedOutPath);
+assert.deepStrictEqual(fs.readFileSync(checkedOutPath), newData);
+hdiffpatch.patchStream(oldPath, checkedStreamPath, checkedOutPath);
+assert.deepStrictEqual(fs.readFileSync(checkedOutPath), newData);
+assert.throws(
+  () => hdiffpatch.patchStream(wrongOldPath, checkedStreamPath, checkedOutPath),
+  /Old data checksum mismatch/
+);
+hdiffpatch.patchChain(oldPath, [checkedStreamPath, v2v3DiffPath], chainOutPath);
+assert.deepStrictEqual(fs.readFileSync(chainOutPath), v3Data);
+// 篡改尾部记录的 new 摘要:补丁本身有效,但结果校验失败
+var badNewHash = Buffer.from(checkedDiff);
+badNewHash[badNewHash.length - 16] ^= 0xff;
+assert.throws(() => hdiffpatch.patch(oldData, badNewHash), /New data checksum mismatch/);
+assert.throws(() => hdiffpatch.diff(oldData, newData, { checksum: 1 }));
+console.log("  ✓ checksummed diffs verify old before patching and new while writing");
+
+console.log("\nTest 7c: read-ahead/write-behind file streams (io option)...");
+// 最小块与队列深度:产物跨越多个写出块,且回写文件头、读回求摘要都要经过后写队列
+var smallIo = { bufferSize: 4096, queueDepth: 1 };
+var ioSinglePath = path.join(tempDir, "io-single.diff");
+var ioStreamPath = path.join(tempDir, "io-stream.diff");
+var ioWindowPath = path.join(tempDir, "io-window.diff");
+var ioOutPath = path.join(tempDir, "io-out.bin");
+hdiffpatch.diffSingleStream(oldPath, newPath, ioSinglePath, { io: smallIo, checksum: true });
+assert.deepStrictEqual(fs.readFileSync(ioSinglePath), fs.readFileSync(checkedSinglePath));
+hdiffpatch.diffStream(oldPath, newPath, ioStreamPath, { io: {} });
+assert.deepStrictEqual(fs.readFileSync(ioStreamPath), fs.readFileSync(diffPath));
+hdiffpatch.diffWindow(oldPath, newPath, ioWindowPath, { io: { dropBehind: false } });
+hdiffpatch.patchSingleStream(oldPath, ioSinglePath, ioOutPath, { io: smallIo });
+assert.deepStrictEqual(fs.readFileSync(ioOutPath), newData);
+hdiffpatch.patchStream(oldPath, ioStreamPath, ioOutPath, { io: smallIo });
+assert.deepStrictEqual(fs.readFileSync(ioOutPath), newData);
+hdiffpatch.patchSingleStream(oldPath, ioWindowPath, ioOutPath, { io: smallIo });
+assert.deepStrictEqual(fs.readFileSync(ioOutPath), newData);
+hdiffpatch.patchChain(oldPath, [diffPath, v2v3DiffPath], chainOutPath, {
+  maxMemory: 0,
+  io: smallIo,
+});
+assert.deepStrictEqual(fs.readFileSync(chainOutPath), v3Data);
+assert.throws(
+  () => hdiffpatch.patchStream(oldPath, ioStreamPath, ioOutPath, { io: { bufferSize: 1 } }),
+  /io\.bufferSize/
+);
+assert.throws(
+  () => hdiffpatch.diffStream(oldPath, newPath, ioStreamPath, { io: { queueDepth: 0 } }),
+  /io\.queueDepth/
+);
+assert.throws(() => hdiffpatch.diff(oldData, newData, { io: {} }), /streaming file diffs/);
+console.log("  ✓ io option keeps diff bytes unchanged and round-trips all file paths");
+
+console.log("\nTest 7d: mmap inputs and diffFile() on mapped files...");
+var mmapSinglePath = path.join(tempDir, "mmap-single.diff");
+var mmapWindowPath = path.join(tempDir, "mmap-window.diff");
+var mmapFilePath = path.join(tempDir, "mmap-file.diff");
+var emptyPath = path.join(tempDir, "empty.bin");
+hdiffpatch.diffSingleStream(oldPath, newPath, mmapSinglePath, { mmap: true, checksum: true });
+assert.deepStrictEqual(fs.readFileSync(mmapSinglePath), fs.readFileSync(checkedSinglePath));
+hdiffpatch.diffWindow(oldPath, newPath, mmapWindowPath, { mmap: true, io: smallIo });
+assert.deepStrictEqual(fs.readFileSync(mmapWindowPath), fs.readFileSync(ioWindowPath));
+hdiffpatch.patchSingleStream(oldPath, mmapWindowPath, ioOutPath, { mmap: true });
+assert.deepStrictEqual(fs.readFileSync(ioOutPath), newData);
+hdiffpatch.patchStream(oldPath, diffPath, ioOutPath, { mmap: true });
+assert.deepStrictEqual(fs.readFileSync(ioOutPath), newData);
+hdiffpatch.patchChain(oldPath, [diffPath, v2v3DiffPath], chainOutPath, { mmap: true });
+assert.deepStrictEqual(fs.readFileSync(chainOutPath), v3Data);
+// diffFile 与 diff() 字节相同;空文件不能映射,也要能处理
+assert.strictEqual(hdiffpatch.diffFile(oldPath, newPath, mmapFilePath), mmapFilePath);
+assert.deepStrictEqual(fs.readFileSync(mmapFilePath), diffResult);
+hdiffpatch.diffFile(oldPath, newPath, mmapFilePath, { checksum: true });
+assert.deepStrictEqual(fs.readFileSync(mmapFilePath), checkedDiff);
+fs.writeFileSync(emptyPath, Buffer.alloc(0));
+hdiffpatch.diffFile(emptyPath, newPath, mmapFilePath);
+assert.deepStrictEqual(hdiffpatch.patch(Buffer.alloc(0), fs.readFileSync(mmapFilePath)), newData);
+assert.throws(() => hdiffpatch.diffFile(oldPath, newPath, mmapFilePath, { mmap: true }), /mmap/);
+assert.throws(() => hdiffpatch.diffFile(path.join(tempDir, "missing.bin"), newPath, mmapFilePath));
+console.log("  ✓ mapped inputs keep output bytes; diffFile matches diff()");
+
+console.log("\nTest 7e: pipelined decompress-ahead for patchStream...");
+var pipelinedOutPath = path.join(tempDir, "pipelined-new.bin");
+hdiffpatch.patchStream(oldPath, diffPath, pipelinedOutPath, { pipelined: true });
+assert.deepStrictEqual(fs.readFileSync(pipelinedOutPath), newData);
+hdiffpatch.patchStream(oldPath, checkedStreamPath, pipelinedOutPath, { pipelined: true, io: smallIo });
+assert.deepStrictEqual(fs.readFileSync(pipelinedOutPath), newData);
+assert.throws(
+  () => hdiffpatch.patchStream(wrongOldPath, checkedStreamPath, pipelinedOutPath, { pipelined: true })
+);
+assert.throws(
+  () => hdiffpatch.patchStream(oldPath, diffPath, pipelinedOutPath, { pipelined: 1 }),
+  /pipelined/
+);
+assert.throws(
+  () => hdiffpatch.patchSingleStream(oldPath, mmapWindowPath, pipelinedOutPath, { pipelined: true }),
+  /only supported by patchStream/
+);
+console.log("  ✓ pipelined patchStream matches the serial output and surfaces errors");
+
+console.log("\nTest 7f: diffSingleStream()/diffWindow() on Buffers...");
+// Buffer 形态与路径形态同一引擎,产物字节相同
+var memSingle = hdiffpatch.diffSingleStream(oldData, newData, { checksum: true });
+assert.ok(Buffer.isBuffer(memSingle));
+assert.deepStrictEqual(memSingle, fs.readFileSync(checkedSinglePath));
+var memWindow = hdiffpatch.diffWindow(oldData, new Uint8Array(newData));
+assert.deepStrictEqual(memWindow, fs.readFileSync(ioWindowPath));
+assert.deepStrictEqual(hdiffpatch.patch(oldData, memWindow), newData);
+assert.deepStrictEqual(hdiffpatch.diffWindow(oldData, newData, 0), memWindow);
+assert.deepStrictEqual(hdiffpatch.diffWindow(oldData, newData, { windowSize: 0 }), memWindow);
+assert.deepStrictEqual(
+  hdiffpatch.patch(Buffer.alloc(0), hdiffpatch.diffSingleStream(Buffer.alloc(0), newData)),
+  newData
+);
+assert.throws(() => hdiffpatch.diffSingleStream(oldData, newData, { mmap: true }), /file paths/);
+assert.throws(() => hdiffpatch.diffWindow(oldData, newData, { io: {} }), /file paths/);
+assert.throws(() => hdiffpatch.diffSingleStream(oldData, newPath), /oldBuf, newBuf/);
+console.log("  ✓ Buffer inputs give the same bytes as the path form without temp files");
+
+console.log("\nTest 7g: nativeMemoryStats reports working sets and result Buffers...");
+var statsBefore = hdiffpatch.nativeMemoryStats();
+var statsDiff = hdiffpatch.diff(oldData, newData);
+var statsAfter = hdiffpatch.nativeMemoryStats();
+// 同步任务结束后工作集已撤回;结果 Buffer 仍被引用(更早的结果可能已被 GC 回收)
+assert.strictEqual(statsAfter.diff.current, statsBefore.diff.current);
+assert.strictEqual(statsAfter.diff.count, statsBefore.diff.count);
+assert.ok(statsAfter.diff.peak >= oldData.length * 4);
+assert.ok(statsAfter.results.current >= statsDiff.length);
+assert.ok(statsAfter.results.count >= 1);
+assert.ok(statsAfter.peak >= statsAfter.current);
+hdiffpatch.patch(oldData, statsDiff);
+assert.ok(hdiffpatch.nativeMemoryStats().patch.peak >= newData.length);
+console.log("  ✓ stats track job working sets and live result Buffers");
+
+console.log("\nTest 7h: diffMany builds one patch per old version...");
+var olderData = Buffer.from(oldData);
+olderData.fill(0x42, 1000, 3000);
+var manyDiffs = hdiffpatch.diffMany([oldData, olderData, Buffer.from(oldData)], newData, {
+  threads: 2,
+});
+assert.strictEqual(manyDiffs.length, 3);
+assert.deepStrictEqual(manyDiffs[0], diffResult);
+assert.deepStrictEqual(hdiffpatch.patch(olderData, manyDiffs[1]), newData);
+// 内容相同的 old 共享同一结果 Buffer
+assert.strictEqual(manyDiffs[2], manyDiffs[0]);
+assert.deepStrictEqual(hdiffpatch.diffMany([], newData), []);
+var manyChecked = hdiffpatch.diffMany([oldData], newData, { checksum: true });
+assert.deepStrictEqual(manyChecked[0], checkedDiff);
+assert.throws(() => hdiffpatch.diffMany([oldData, "x"], newData), /old #1/);
+assert.throws(() => hdiffpatch.diffMany([oldData], newData, { threads: 0 }), /threads/);
+assert.throws(() => hdiffpatch.diffMany([oldData], newData, { threads: 64 }), /1 to 16/);
+assert.throws(() => hdiffpatch.diffMany([oldData], newData, { maxMemory: -1 }), /maxMemory/);
+// 预算小于单个任务时退到 1 个线程,结果不变
+var manyCapped = hdiffpatch.diffMany([oldData, olderData], newData, { threads: 2, maxMemory: 1 });
+assert.deepStrictEqual(manyCapped, manyDiffs.slice(0, 2));
+console.log("  ✓ diffMany matches per-old diff() and deduplicates identical olds");
+
+console.log("\nTest 7i: diffBest keeps the smallest candidate...");
+var best = hdiffpatch.diffBest(oldData, newData, {
+  candidates: [
+    { engine: "singleStream" },
+    { engine: "window" },
+    { engine: "diff" },
+  ],
+  threads: 2,
+});
+var candidateDiffs = [
+  hdiffpatch.diffSingleStream(oldData, newData),
+  hdiffpatch.diffWindow(oldData, newData),
+  diffResult,
+];
+var smallest = Math.min.apply(null, candidateDiffs.map((d) => d.length));
+assert.strictEqual(best.diff.length, smallest);
+assert.deepStrictEqual(best.diff, candidateDiffs[best.index]);
+assert.strictEqual(best.candidate.engine, ["singleStream", "window", "diff"][best.index]);
+assert.deepStrictEqual(
+  best.results.map((r) => r.size),
+  candidateDiffs.map((d) => d.length)
+);
+assert.ok(best.results.every((r) => r.status === "done" && r.ms >= 0));
+// 预算为 1ms 且单线程:首个候选照常运行,其后的候选被跳过
+var budgeted = hdiffpatch.diffBest(oldData, newData, {
+  candidates: [{ engine: "window" }, { engine: "diff" }],
+  timeBudgetMs: 1,
+  threads: 1,
+  checksum: true,
+});
+assert.strictEqual(budgeted.index, 0);
+assert.strictEqual(budgeted.results[1].status, "skipped");
+assert.deepStrictEqual(hdiffpatch.patch(oldData, budgeted.diff), newData);
+// 运行顺序与候选顺序无关:最便宜的 singleStream 先运行,其余被跳过
+var budgetedDefault = hdiffpatch.diffBest(oldData, newData, {
+  candidates: [{ engine: "diff" }, { engine: "window" }, { engine: "singleStream" }],
+  timeBudgetMs: 1e-6,
+  threads: 1,
+});
+assert.strictEqual(budgetedDefault.index, 2);
+assert.deepStrictEqual(
+  budgetedDefault.results.map((r) => r.status),
+  ["skipped", "skipped", "done"]
+);
+assert.deepStrictEqual(budgetedDefault.diff, candidateDiffs[0]);
+// 缺省并发:所有候选都完成,结果与完成先后无关;maxMemory 只压低并发
+var bestDefault = hdiffpatch.diffBest(oldData, newData, {
+  candidates: [{ engine: "singleStream" }, { engine: "window" }, { engine: "diff" }],
+});
+assert.ok(bestDefault.results.every((r) => r.status === "done"));
+assert.strictEqual(bestDefault.index, best.index);
+assert.deepStrictEqual(bestDefault.diff, best.diff);
+var bestCapped = hdiffpatch.diffBest(oldData, newData, {
+  candidates: [{ engine: "singleStream" }, { engine: "window" }, { engine: "diff" }],
+  threads: 3,
+  maxMemory: 1,
+});
+assert.deepStrictEqual(bestCapped.diff, best.diff);
+assert.throws(
+  () => hdiffpatch.diffBest(oldData, newData, { candidates: [{}], maxMemory: -1 }),
+  /maxMemory/
+);
+assert.throws(
+  () => hdiffpatch.diffBest(oldData, newData, { candidates: [{}], threads: 64 }),
+  /1 to 16/
+);
+assert.throws(() => hdiffpatch.diffBest(oldData, newData, { candidates: [] }), /candidates/);
+assert.throws(
+  () => hdiffpatch.diffBest(oldData, newData, { candidates: [{ engine: "bsdiff" }] }),
+  /engine/
+);
+assert.throws(
+  () => hdiffpatch.diffBest(oldData, newData, { candidates: [{ checksum: true }] }),
+  /checksum/
+);
+console.log("  ✓ diffBest returns the smallest verified patch and honours the time budget");
+
+console.log("\nTest 7j: diffArchive/patchArchive on zip archives...");
+var zlib = require("zlib");
+// 最小 ZIP 写出器:[name, data, level];level 为 null 表示 stored
+function makeZip(files) {
+  var locals = [];
+  var centrals = [];
+  var offset = 0;
+  files.forEach(function (file) {
+    var name = Buffer.from(file[0]);
+    var stored = file[2] === null;
+    var body = stored ? file[1] : zlib.deflateRawSync(file[1], { level: file[2] });
+    var local = Buffer.alloc(30);
+    local.writeUInt32LE(0x04034b50, 0);
+    local.writeUInt16LE(stored ? 0 : 8, 8);
+    local.writeUInt32LE(body.length, 18);
+    local.writeUInt32LE(file[1].length, 22);
+    local.writeUInt16LE(name.length, 26);
+    var central = Buffer.alloc(46);
+    central.writeUInt32LE(0x02014b50, 0);
+    central.writeUInt16LE(stored ? 0 : 8, 10);
+    central.writeUInt32LE(body.length, 20);
+    central.writeUInt32LE(file[1].length, 24);
+    central.writeUInt16LE(name.length, 28);
+    central.writeUInt32LE(offset, 42);
+    locals.push(local, name, body);
+    centrals.push(central, name);
+    offset += 30 + name.length + body.length;
+  });
+  var cd = Buffer.concat(centrals);
+  var eocd = Buffer.alloc(22);
+  eocd.writeUInt32LE(0x06054b50, 0);
+  eocd.writeUInt16LE(files.length, 8);
+  eocd.writeUInt16LE(files.length, 10);
+  eocd.writeUInt32LE(cd.length, 12);
+  eocd.writeUInt32LE(offset, 16);
+  return Buffer.concat(locals.concat([cd, eocd]));
+}
+var bundleLines = [];
+for (var line = 0; line < 4000; line++) {
+  bundleLines.push("export const v" + line + " = " + ((line * 7919) % 10007) + ";");
+}
+var bundleV1 = Buffer.from(bundleLines.join("\n"));
+var bundleV2 = Buffer.from(bundleV1.toString().replace("v2000 = ", "v2000 = -"));
+var assetData = deterministicBytes(4096, 0x7a1b);
+var oldZip = makeZip([["index.js", bundleV1, 6], ["asset.bin", assetData, null]]);
+var newZip = makeZip([["index.js", bundleV2, 9], ["asset.bin", assetData, null]]);
+var archiveDiff = hdiffpatch.diffArchive(oldZip, newZip);
+assert.deepStrictEqual(hdiffpatch.patchArchive(oldZip, archiveDiff), newZip);
+// 展开后只剩一处改动,应明显小于直接对压缩字节做 diff
+assert.ok(archiveDiff.length < hdiffpatch.diff(oldZip, newZip).length);
+// 非归档输入按普通字节处理
+var plainArchiveDiff = hdiffpatch.diffArchive(oldData, newData);
+assert.deepStrictEqual(hdiffpatch.patchArchive(oldData, plainArchiveDiff), newData);
+assert.throws(() => hdiffpatch.patchArchive(newZip, archiveDiff), /checksum mismatch/);
+assert.throws(() => hdiffpatch.patchArchive(oldZip, diffResult), /bad magic/);
+console.log("  ✓ archive diffs rebuild the exact new archive from inflated entries");
+
+console.log("\nTest 7k: diffReuse returns the previous diff while it still applies...");
+var sameBuild = Buffer.from(newData);
+var reusedDiff = hdiffpatch.diffReuse(oldData, sameBuild, diffResult);
+assert.strictEqual(reusedDiff.reused, true);
+assert.deepStrictEqual(reusedDiff.diff, diffResult);
+// checksum 设置不一致时不复用,按 diff() 重新生成
+var reuseChecked = hdiffpatch.diffReuse(oldData, sameBuild, diffResult, { checksum: true });
+assert.strictEqual(reuseChecked.reused, false);
+assert.deepStrictEqual(reuseChecked.diff, checkedDiff);
+assert.strictEqual(
+  hdiffpatch.diffReuse(oldData, sameBuild, checkedDiff, { checksum: true }).reused,
+  true
+);
+var nextBuild = Buffer.from(newData);
+nextBuild[1000] ^= 0xff;
+nextBuild[1500] ^= 0xff;
+var reuseChanged = hdiffpatch.diffReuse(oldData, nextBuild, diffResult);
+assert.strictEqual(reuseChanged.reused, false);
+assert.deepStrictEqual(reuseChanged.diff, hdiffpatch.diff(oldData, nextBuild));
+// 摘要不符时直接排除
+assert.strictEqual(
+  hdiffpatch.diffReuse(oldData, nextBuild, checkedDiff, { checksum: true }).reused,
+  false
+);
+// 校验尾部完好但正文损坏:摘要相符也要实际 patch 校验,不能复用
+var corruptBody = Buffer.from(checkedDiff);
+corruptBody[corruptBody.length - 25] ^= 0xff;
+var reuseCorrupt = hdiffpatch.diffReuse(oldData, sameBuild, corruptBody, { checksum: true });
+assert.strictEqual(reuseCorrupt.reused, false);
+assert.deepStrictEqual(reuseCorrupt.diff, checkedDiff);
+// 过期或损坏的 prevDiff 不报错,直接重新 diff
+var reuseStale = hdiffpatch.diffReuse(oldData, sameBuild, Buffer.from("stale"));
+assert.strictEqual(reuseStale.reused, false);
+assert.deepStrictEqual(reuseStale.diff, diffResult);
+assert.throws(() => hdiffpatch.diffReuse(oldData, sameBuild), /prevDiff/);
+console.log("  ✓ diffReuse reuses valid diffs and rediffs changed builds");
+
+console.log("\nTest 7l: patchRange materializes only a byte range...");
+var rangeStart = Math.floor(newData.length / 3);
+assert.deepStrictEqual(
+  hdiffpatch.patchRange(oldData, diffResult, rangeStart, 1000),
+  newData.subarray(rangeStart, rangeStart + 1000)
+);
+assert.deepStrictEqual(hdiffpatch.patchRange(oldData, diffResult, 0, newData.length), newData);
+// 区间延伸到 new 末尾、带校验尾部与空区间
+assert.deepStrictEqual(
+  hdiffpatch.patchRange(oldData, checkedDiff, newData.length - 10, 10),
+  newData.subarray(newData.length - 10)
+);
+assert.strictEqual(hdiffpatch.patchRange(oldData, diffResult, newData.length, 0).length, 0);
+assert.throws(() => hdiffpatch.patchRange(oldData, diffResult, newData.length, 1), /out of bounds/);
+assert.throws(() => hdiffpatch.patchRange(oldData, diffResult, -1, 1), /Invalid range/);
+assert.throws(() => hdiffpatch.patchRange(newData, checkedDiff, 0, 1), /mismatch/);
+// 截断的 diff 在范围写满前就失败,必须报错而不是当成提前结束
+assert.throws(() => hdiffpatch.patchRange(oldData, diffResult.subarray(0, diffResult.length - 8),
+  newData.length - 10, 10));
+console.log("  ✓ patchRange returns the requested slice of new");
+
+console.log("\nTest 7m: buildInfo reports CPU features and kernel variants...");
+var build = hdiffpatch.buildInfo();
+assert.ok(["avx2", "sse2", "neon", "scalar"].includes(build.byteCompare));
+assert.ok(["avx2", "sse4.1", "neon", "generic"].includes(build.lzmaMatchFinder));
+assert.ok(["avx2", "sse4.1", "neon", "generic"].includes(build.lzmaMatchFinderCpuCapable));
+assert.strictEqual(build.lzmaMatchFinderCpuCapable === "avx2", build.cpu.avx2);
+assert.strictEqual(build.byteCompare === "avx2", build.cpu.avx2);
+assert.ok(Array.isArray(build.compiledFor));
+assert.strictEqual(typeof build.lto, "boolean");
+assert.ok(["off", "generate", "use"].includes(build.pgo));
+console.log("  ✓ buildInfo: byteCompare=" + build.byteCompare + ", lzma=" + build.lzmaMatchFinder +
+  " (cpu " + build.lzmaMatchFinderCpuCapable + ")");
+
+console.log("\nTest 7n: configureArena serves large patch outputs...");
+hdiffpatch.configureArena({ hugePages: "transparent", retainBytes: 64 * 1024 * 1024 });
+var arenaOld = Buffer.alloc(3 * 1024 * 1024, 7);
+var arenaNew = Buffer.from(arenaOld);
+arenaNew.fill(9, 1024 * 1024, 1024 * 1024 + 4096);
+var arenaDiff = hdiffpatch.diff(arenaOld, arenaNew);
+var arenaBefore = hdiffpatch.nativeMemoryStats().arena;
+var arenaOut = hdiffpatch.patch(arenaOld, arenaDiff);
+assert.deepStrictEqual(arenaOut, arenaNew);
+var arenaAfter = hdiffpatch.nativeMemoryStats().arena;
+assert.ok(arenaAfter.allocations > arenaBefore.allocations);
+assert.ok(arenaAfter.live >= arenaNew.length);
+assert.throws(() => hdiffpatch.configureArena({ hugePages: "always" }), /hugePages/);
+assert.throws(() => hdiffpatch.configureArena({ retainBytes: -1 }), /retainBytes/);
+hdiffpatch.configureArena({ enabled: false, retainBytes: 0 });
+assert.strictEqual(hdiffpatch.nativeMemoryStats().arena.retained, 0);
+assert.deepStrictEqual(hdiffpatch.patch(arenaOld, arenaDiff), arenaNew);
+console.log("  ✓ configureArena: " + (arenaAfter.allocations - arenaBefore.allocations) + " arena allocation(s)");
+
+console.log("\nTest 7o: SharedArrayBuffer inputs and caller-provided out...");
+var sharedOld = new SharedArrayBuffer(oldData.length);
+Buffer.from(sharedOld).set(oldData);
+var sharedDiff = new SharedArrayBuffer(diffResult.length);
+Buffer.from(sharedDiff).set(diffResult);
+assert.deepStrictEqual(hdiffpatch.patch(sharedOld, sharedDiff), newData);
+assert.deepStrictEqual(hdiffpatch.patch(new Uint8Array(sharedOld), diffResult), newData);
+assert.deepStrictEqual(hdiffpatch.patch(new DataView(sharedOld), diffResult), newData);
+assert.deepStrictEqual(hdiffpatch.diff(sharedOld, newData), diffResult);
+var sharedOut = new SharedArrayBuffer(newData.length + 8);
+assert.strictEqual(hdiffpatch.patch(sharedOld, diffResult, sharedOut), newData.length);
+assert.deepStrictEqual(Buffer.from(sharedOut, 0, newData.length), newData);
+assert.throws(() => hdiffpatch.patch(oldData, diffResult, new SharedArrayBuffer(1)), /too small/);
+var diffOut = new SharedArrayBuffer(diffResult.length);
+assert.strictEqual(hdiffpatch.diff(oldData, newData, { out: diffOut }), diffResult.length);
+assert.deepStrictEqual(Buffer.from(diffOut), diffResult);
+assert.throws(() => hdiffpatch.diff(oldData, newData, { out: Buffer.alloc(1) }),
+  new RegExp("need " + diffResult.length + " bytes"));
+assert.throws(() => hdiffpatch.patch(oldData, diffResult, "out"), /Invalid out/);
+// Buffer 形态的 diffWindow/diffSingleStream 与 patchRange 同样支持 out
+var windowOut = Buffer.alloc(memWindow.length);
+assert.strictEqual(hdiffpatch.diffWindow(oldData, newData, { out: windowOut }), memWindow.length);
+assert.deepStrictEqual(windowOut, memWindow);
+var singleOut = new SharedArrayBuffer(memSingle.length);
+assert.strictEqual(
+  hdiffpatch.diffSingleStream(oldData, newData, { checksum: true, out: singleOut }),
+  memSingle.length
+);
+assert.deepStrictEqual(Buffer.from(singleOut), memSingle);
+var rangeOut = new SharedArrayBuffer(1000);
+assert.strictEqual(hdiffpatch.patchRange(oldData, diffResult, rangeStart, 1000, rangeOut), 1000);
+assert.deepStrictEqual(Buffer.from(rangeOut), newData.subarray(rangeStart, rangeStart + 1000));
+assert.throws(() => hdiffpatch.patchRange(oldData, diffResult, 0, 10, Buffer.alloc(9)), /too small/);
+// 其余入口不支持 out,必须报错而不是静默忽略
+var outOption = { out: Buffer.alloc(1 << 20) };
+assert.throws(() => hdiffpatch.diffBest(oldData, newData, { candidates: [{}], out: outOption.out }),
+  /does not support out/);
+assert.throws(() => hdiffpatch.diffBest(oldData, newData, { candidates: [outOption] }), /out is only/);
+assert.throws(() => hdiffpatch.diffReuse(oldData, newData, diffResult, outOption), /out is only/);
+assert.throws(() => hdiffpatch.diffMany([oldData], newData, outOption), /out is only/);
+assert.throws(() => hdiffpatch.diffFile(oldPath, newPath, mmapFilePath, outOption), /out is only/);
+assert.throws(() => hdiffpatch.diffWindow(oldPath, newPath, mmapFilePath, outOption), /out is only/);
+assert.throws(() => hdiffpatch.diffArchive(oldZip, newZip, outOption), /does not support out/);
+console.log("  ✓ SharedArrayBuffer inputs and out regions work without copies");
+
 // ---- 异步与 CLI 测试 ----
 var util = require("util");
 var execFile = util.promisify(require("child_process").execFile);
@@ -252,8 +812,57 @@ async function runAsyncTests() {
   assert.deepStrictEqual(asyncPatched, newData);
   var asyncMtDiff = await diffAsync(oldData, newData, { compressionThreads: 2 });
   assert.deepStrictEqual(await patchAsync(oldData, asyncMtDiff), newData);
+  var asyncOut = new SharedArrayBuffer(newData.length);
+  assert.strictEqual(await patchAsync(sharedOld, asyncDiff, asyncOut), newData.length);
+  assert.deepStrictEqual(Buffer.from(asyncOut), newData);
+  var asyncDiffOut = Buffer.alloc(asyncDiff.length);
+  assert.strictEqual(await diffAsync(oldData, newData, { out: asyncDiffOut }), asyncDiff.length);
+  assert.deepStrictEqual(asyncDiffOut, asyncDiff);
   console.log("  ✓ Async diff/patch works");
 
+  console.log("\nTest 8a: Patcher reuses work buffers...");
+  var patcher = new hdiffpatch.Patcher();
+  assert.deepStrictEqual(patcher.patch(oldData, diffResult), newData);
+  assert.deepStrictEqual(patcher.patch(oldData, diffResult), newData);
+  var patcherOut = Buffer.alloc(newData.length + 16);
+  assert.strictEqual(patcher.patch(oldData, diffResult, patcherOut), newData.length);
+  assert.deepStrictEqual(patcherOut.subarray(0, newData.length), newData);
+  assert.throws(() => patcher.patch(oldData, diffResult, Buffer.alloc(1)), /too small/);
+  var queued = [patcher.patchAsync(oldData, diffResult), patcher.patchAsync(tinyOld, tinyDiff)];
+  assert.throws(() => patcher.patch(oldData, diffResult), /busy/);
+  var queuedResults = await Promise.all(queued);
+  assert.deepStrictEqual(queuedResults[0], newData);
+  assert.deepStrictEqual(queuedResults[1], tinyNew);
+  assert.strictEqual(await patcher.patchAsync(oldData, diffResult, patcherOut), newData.length);
+  await assert.rejects(() => patcher.patchAsync(oldData, Buffer.from("not a diff at all")));
+  assert.deepStrictEqual(patcher.patch(oldData, diffResult), newData);
+  console.log("  ✓ Patcher sync/async, caller-provided output and queued async calls work");
+
+  console.log("\nTest 8b: patchMany applies a batch in one call...");
+  var manyOutPath = path.join(tempDir, "many-out.bin");
+  var manyResults = await hdiffpatch.patchMany([
+    { old: oldData, diff: diffResult },
+    { old: tinyOld, diff: tinyDiff },
+    { old: oldData, diff: Buffer.from("broken diff data") },
+    { oldPath: oldPath, diffPath: diffPath, outPath: manyOutPath }
+  ], { threads: 2 });
+  assert.strictEqual(manyResults.length, 4);
+  assert.deepStrictEqual(manyResults[0], newData);
+  assert.deepStrictEqual(manyResults[1], tinyNew);
+  assert(manyResults[2] instanceof Error);
+  assert.strictEqual(manyResults[3], manyOutPath);
+  assert.deepStrictEqual(fs.readFileSync(manyOutPath), newData);
+  var manyCbResults = await new Promise((resolve, reject) => {
+    hdiffpatch.patchMany([{ old: oldData, diff: diffResult }], (err, results) =>
+      err ? reject(err) : resolve(results)
+    );
+  });
+  assert.deepStrictEqual(manyCbResults, [newData]);
+  assert.deepStrictEqual(await hdiffpatch.patchMany([]), []);
+  assert.throws(() => hdiffpatch.patchMany([{ old: oldData }], () => {}));
+  assert.throws(() => hdiffpatch.patchMany([], { threads: 0 }, () => {}));
+  console.log("  ✓ patchMany returns per-item results and errors");
+
   console.log("\nTest 9: Async error propagation...");
   var corruptDiff = Buffer.from("this is definitely not a diff");
   await assert.rejects(() => patchAsync(oldData, corruptDiff));
@@ -282,6 +891,8 @@ async function runAsyncTests() {
   );
   assert.strictEqual(await patchStreamAsync(oldPath, asyncDiffPath, asyncOutPath), asyncOutPath);
   assert.deepStrictEqual(fs.readFileSync(asyncOutPath), newData);
+  await patchStreamAsync(oldPath, asyncDiffPath, asyncOutPath, { pipelined: true });
+  assert.deepStrictEqual(fs.readFileSync(asyncOutPath), newData);
   assert.strictEqual(
     await patchSingleStreamAsync(oldPath, singleDiffPath, asyncSingleOutPath),
     asyncSingleOutPath
@@ -292,6 +903,26 @@ async function runAsyncTests() {
   );
   var asyncWinDiffPath = path.join(tempDir, "async-win.diff");
   assert.strictEqual(await diffWindowAsync(oldPath, newPath, asyncWinDiffPath), asyncWinDiffPath);
+  assert.deepStrictEqual(await diffWindowAsync(oldData, newData), memWindow);
+  assert.deepStrictEqual(await diffSingleStreamAsync(oldData, newData, { checksum: true }), memSingle);
+  var manyAsync = await util.promisify(hdiffpatch.diffMany)([oldData, olderData], newData);
+  assert.deepStrictEqual(manyAsync[0], diffResult);
+  assert.deepStrictEqual(hdiffpatch.patch(olderData, manyAsync[1]), newData);
+  var bestAsync = await util.promisify(hdiffpatch.diffBest)(oldData, newData, {
+    candidates: [{ engine: "window", windowSize: 4 << 20 }, {}],
+  });
+  assert.deepStrictEqual(hdiffpatch.patch(oldData, bestAsync.diff), newData);
+  var reuseAsync = await util.promisify(hdiffpatch.diffReuse)(oldData, nextBuild, diffResult, {});
+  assert.deepStrictEqual(reuseAsync.diff, reuseChanged.diff);
+  assert.deepStrictEqual(
+    await util.promisify(hdiffpatch.patchRange)(oldData, diffResult, 100, 200),
+    newData.subarray(100, 300)
+  );
+  var archiveDiffAsync = await util.promisify(hdiffpatch.diffArchive)(oldZip, newZip);
+  assert.deepStrictEqual(
+    await util.promisify(hdiffpatch.patchArchive)(oldZip, archiveDiffAsync),
+    newZip
+  );
   assert.deepStrictEqual(hdiffpatch.patch(oldData, fs.readFileSync(asyncWinDiffPath)), newData);
   // 带 windowSize 的异步形态:(old, new, out, windowSize, cb)
   var asyncWin8Path = path.join(tempDir, "async-win8.diff");
@@ -304,7 +935,65 @@ async function runAsyncTests() {
   await assert.rejects(
     () => diffWindowAsync(path.join(tempDir, "no-such.bin"), newPath, asyncWinDiffPath)
   );
-  console.log("  ✓ Async stream diff/patch works (incl. diffWindow)");
+  var asyncFileDiffPath = path.join(tempDir, "async-file.diff");
+  assert.strictEqual(
+    await util.promisify(hdiffpatch.diffFile)(oldPath, newPath, asyncFileDiffPath, {}),
+    asyncFileDiffPath
+  );
+  assert.deepStrictEqual(fs.readFileSync(asyncFileDiffPath), diffResult);
+  console.log("  ✓ Async stream diff/patch works (incl. diffWindow, diffFile)");
+
+  console.log("\nTest 10a: Readable new diffs while the stream is read...");
+  var { Readable } = require("stream");
+  function chunkedNew(data, chunkSize) {
+    var chunks = [];
+    for (var pos = 0; pos < data.length; pos += chunkSize) {
+      chunks.push(data.subarray(pos, pos + chunkSize));
+    }
+    return Readable.from(chunks);
+  }
+  var readableSinglePath = path.join(tempDir, "readable-single.diff");
+  await diffSingleStreamAsync(oldPath, chunkedNew(newData, 4096), readableSinglePath,
+    { newSize: newData.length, checksum: true });
+  assert.deepStrictEqual(hdiffpatch.patch(oldData, fs.readFileSync(readableSinglePath)), newData);
+  assert.ok(!fs.existsSync(readableSinglePath + ".new.tmp"));
+  var readableWindowPath = path.join(tempDir, "readable-window.diff");
+  await diffWindowAsync(oldPath, chunkedNew(newData, 1000), readableWindowPath,
+    { newSize: newData.length });
+  assert.deepStrictEqual(fs.readFileSync(readableWindowPath),
+    fs.readFileSync(hdiffpatch.diffWindow(oldPath, newPath, path.join(tempDir, "file-window.diff"))));
+  var readableStreamPath = path.join(tempDir, "readable-stream.diff");
+  await diffStreamAsync(oldPath, chunkedNew(newData, 65536), readableStreamPath,
+    { newSize: newData.length });
+  await patchStreamAsync(oldPath, readableStreamPath, asyncOutPath);
+  assert.deepStrictEqual(fs.readFileSync(asyncOutPath), newData);
+  await assert.rejects(
+    () => diffSingleStreamAsync(oldPath, chunkedNew(newData, 4096), readableSinglePath,
+      { newSize: newData.length + 1 }),
+    /ended after/
+  );
+  await assert.rejects(
+    () => diffSingleStreamAsync(oldPath, chunkedNew(newData, 4096), readableSinglePath,
+      { newSize: newData.length - 1 }),
+    /longer than newSize/
+  );
+  // 并发数超过 libuv 线程池、且 source 自身也用线程池时不能互相等待
+  var fileWindowDiff = fs.readFileSync(path.join(tempDir, "file-window.diff"));
+  var pooledPaths = [];
+  for (var poolIndex = 0; poolIndex < 6; poolIndex++) {
+    pooledPaths.push(path.join(tempDir, "readable-pool-" + poolIndex + ".diff"));
+  }
+  await Promise.all(pooledPaths.map((pooledPath) =>
+    diffWindowAsync(oldPath, fs.createReadStream(newPath, { highWaterMark: 4096 }), pooledPath,
+      { newSize: newData.length })));
+  for (var pooledPath of pooledPaths) {
+    assert.deepStrictEqual(fs.readFileSync(pooledPath), fileWindowDiff);
+  }
+  assert.throws(() => hdiffpatch.diffSingleStream(oldPath, chunkedNew(newData, 4096),
+    readableSinglePath, { newSize: newData.length }), /requires a callback/);
+  assert.throws(() => hdiffpatch.diffSingleStream(oldPath, chunkedNew(newData, 4096),
+    readableSinglePath, {}, () => {}), /newSize/);
+  console.log("  ✓ Readable new produces the same diffs as the file form");
 
   console.log("\nTest 11: CLI auto-detects both diff formats...");
   var cliBin = path.join(__dirname, "..", "bin", "hdiffpatch.js");
@@ -320,6 +1009,39 @@ async function runAsyncTests() {
     () => execFile(process.execPath, [cliBin, "patch", oldPath, oldPath, cliOutPath])
   );
   console.log("  ✓ CLI patch handles stream, single-compressed, and invalid inputs");
+
+  console.log("\nTest 11a: CLI batch runs a manifest of jobs...");
+  var batchDir = path.join(tempDir, "batch");
+  fs.mkdirSync(batchDir);
+  fs.writeFileSync(path.join(batchDir, "diff.json"), JSON.stringify({
+    threads: 2,
+    maxMemory: "64m",
+    jobs: [
+      { old: oldPath, new: newPath, out: "single.diff", mode: "single" },
+      { old: oldPath, new: newPath, out: "window.diff", mode: "window", checksum: true },
+      { old: oldPath, new: newPath, out: "stream.diff", mode: "stream" },
+      { old: oldPath, new: newPath, out: "auto.diff" },
+    ],
+  }));
+  var batchReport = JSON.parse((await execFile(process.execPath, [
+    cliBin, "batch", path.join(batchDir, "diff.json"), "--json",
+  ])).stdout);
+  assert.strictEqual(batchReport.failed, 0);
+  assert.deepStrictEqual(batchReport.jobs.map((j) => j.mode), ["single", "window", "stream", "auto"]);
+  assert.deepStrictEqual(fs.readFileSync(path.join(batchDir, "single.diff")), diffResult);
+  fs.writeFileSync(path.join(batchDir, "patch.json"), JSON.stringify(
+    ["single", "window", "stream", "auto"].map((name) => ({
+      type: "patch", old: oldPath, diff: name + ".diff", out: name + ".out",
+    })).concat([{ type: "patch", old: oldPath, diff: "missing.diff", out: "missing.out" }])
+  ));
+  await assert.rejects(
+    () => execFile(process.execPath, [cliBin, "batch", path.join(batchDir, "patch.json")]),
+    (err) => err.code === 1 && /5 jobs, 1 failed/.test(err.stdout)
+  );
+  ["single", "window", "stream", "auto"].forEach((name) => {
+    assert.deepStrictEqual(fs.readFileSync(path.join(batchDir, name + ".out")), newData);
+  });
+  console.log("  ✓ CLI batch runs diff/patch jobs in every mode and reports failures");
 }
 
 runAsyncTests()